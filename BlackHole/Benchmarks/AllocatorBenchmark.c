@@ -0,0 +1,192 @@
+#include "Benchmark.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Threading/Atomic.h"
+#include "../Threading/Thread.h"
+#include "../Stdafx.h"
+
+#define ALLOCATOR_BENCHMARK_MAX_THREADS 64
+
+typedef struct SAllocatorBenchmarkThread
+{
+	ThreadHandle thread;
+	BenchmarkSamples samples;
+	size_t batchesCount;
+	uint32_t seed;
+	bool useThreadCache;
+	volatile int32_t* startFlag;
+} SAllocatorBenchmarkThread;
+
+static uint32_t AllocatorBenchmark_NextRandom(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return (*state);
+}
+
+// Mostly small objects like the engine allocates them, with an occasional large buffer
+static size_t AllocatorBenchmark_NextSize(uint32_t* state)
+{
+	uint32_t random = AllocatorBenchmark_NextRandom(state);
+	if ((random & 63) == 0)
+	{
+		return (4096 + (random >> 20));
+	}
+
+	if ((random & 3) == 0)
+	{
+		return (256 + (random >> 8) % 768);
+	}
+
+	return (16 + (random >> 8) % 240);
+}
+
+static void AllocatorBenchmark_ThreadMain(void* arg)
+{
+	SAllocatorBenchmarkThread* context = (SAllocatorBenchmarkThread*)arg;
+	void* blocks[BENCHMARK_BATCH_SIZE];
+	uint32_t state = context->seed;
+
+	if (context->useThreadCache)
+	{
+		MemoryManager_InitializeThreadCache();
+	}
+
+	// Start together so every thread runs under the same contention
+	while (Atomic_Load32(context->startFlag) == 0)
+	{
+		Thread_Yield();
+	}
+
+	for (size_t batch = 0; batch < context->batchesCount; batch++)
+	{
+		uint64_t start = Clock_GetTimeNs();
+
+		for (size_t i = 0; i < BENCHMARK_BATCH_SIZE; i++)
+		{
+			blocks[i] = engine_malloc(AllocatorBenchmark_NextSize(&state), MEM_TAG_ENGINE);
+		}
+
+		// Free out of allocation order, like objects with different lifetimes
+		for (size_t i = 0; i < BENCHMARK_BATCH_SIZE; i += 2)
+		{
+			engine_free(blocks[i]);
+		}
+
+		for (size_t i = 1; i < BENCHMARK_BATCH_SIZE; i += 2)
+		{
+			engine_free(blocks[i]);
+		}
+
+		BenchmarkSamples_Add(context->samples, Clock_GetTimeNs() - start);
+	}
+
+	if (context->useThreadCache)
+	{
+		MemoryManager_DestroyThreadCache();
+	}
+}
+
+static void AllocatorBenchmark_Run(size_t batchesCount, uint32_t threadsCount, bool useThreadCache, const char* modeName)
+{
+	SAllocatorBenchmarkThread threads[ALLOCATOR_BENCHMARK_MAX_THREADS];
+	volatile int32_t startFlag = 0;
+	size_t batchesPerThread = batchesCount / threadsCount + 1;
+
+	// A sample is one batch of allocations plus the matching frees
+	BenchmarkSamples allSamples = NULL;
+	if (!BenchmarkSamples_Initialize(&allSamples, batchesPerThread * threadsCount, BENCHMARK_BATCH_SIZE * 2))
+	{
+		return;
+	}
+
+	uint32_t startedCount = 0;
+	for (; startedCount < threadsCount; startedCount++)
+	{
+		SAllocatorBenchmarkThread* thread = &threads[startedCount];
+		thread->batchesCount = batchesPerThread;
+		thread->seed = 0x9E3779B9u * (startedCount + 1);
+		thread->useThreadCache = useThreadCache;
+		thread->startFlag = &startFlag;
+
+		if (!BenchmarkSamples_Initialize(&thread->samples, batchesPerThread, BENCHMARK_BATCH_SIZE * 2))
+		{
+			break;
+		}
+
+		if (!Thread_Create(&thread->thread, AllocatorBenchmark_ThreadMain, thread))
+		{
+			syserr("AllocatorBenchmark: failed to start thread %u", startedCount);
+			BenchmarkSamples_Destroy(&thread->samples);
+			break;
+		}
+	}
+
+	uint64_t start = Clock_GetTimeNs();
+	Atomic_Store32(&startFlag, 1);
+
+	for (uint32_t i = 0; i < startedCount; i++)
+	{
+		Thread_Join(threads[i].thread);
+	}
+
+	uint64_t wallTime = Clock_GetTimeNs() - start;
+
+	for (uint32_t i = 0; i < startedCount; i++)
+	{
+		BenchmarkSamples_Merge(allSamples, threads[i].samples);
+		BenchmarkSamples_Destroy(&threads[i].samples);
+	}
+
+	// Aggregate throughput tells more than latency once threads contend
+	char label[64];
+	double operations = (double)allSamples->count * (double)allSamples->opsPerSample;
+	snprintf(label, sizeof(label), "%2u thr %-6s %7.2f Mops/s", startedCount, modeName,
+		(wallTime > 0) ? operations * 1000.0 / (double)wallTime : 0.0);
+
+	BenchmarkSamples_Report(allSamples, label);
+	BenchmarkSamples_Destroy(&allSamples);
+}
+
+void AllocatorBenchmark_Throughput(size_t operationsCount, uint32_t maxThreads)
+{
+	if (operationsCount == 0)
+	{
+		return;
+	}
+
+	if (maxThreads == 0)
+	{
+		maxThreads = 1;
+	}
+
+	if (maxThreads > ALLOCATOR_BENCHMARK_MAX_THREADS)
+	{
+		maxThreads = ALLOCATOR_BENCHMARK_MAX_THREADS;
+	}
+
+	size_t batchesCount = operationsCount / (BENCHMARK_BATCH_SIZE * 2) + 1;
+
+	syslog("--- ALLOCATOR BENCHMARK (%zu alloc+free ops, up to %u threads) ---", batchesCount * BENCHMARK_BATCH_SIZE * 2, maxThreads);
+
+	// Global lock blocking, global lock spinning first, then the thread caches
+	const char* modeNames[] = { "block", "spin", "cached" };
+	for (int mode = 0; mode < 3; mode++)
+	{
+		MemoryManager_SetLockMode(mode == 1 ? MEMORY_LOCK_MODE_SPIN_THEN_BLOCK : MEMORY_LOCK_MODE_BLOCK);
+
+		// Powers of two, then the requested maximum
+		for (uint32_t threadsCount = 1; ; threadsCount *= 2)
+		{
+			if (threadsCount >= maxThreads)
+			{
+				AllocatorBenchmark_Run(batchesCount, maxThreads, mode == 2, modeNames[mode]);
+				break;
+			}
+
+			AllocatorBenchmark_Run(batchesCount, threadsCount, mode == 2, modeNames[mode]);
+		}
+	}
+
+	MemoryManager_SetLockMode(MEMORY_LOCK_MODE_BLOCK);
+}
@@ -0,0 +1,111 @@
+#include "Benchmark.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+bool BenchmarkSamples_Initialize(BenchmarkSamples* ppSamples, size_t capacity, size_t opsPerSample)
+{
+	if (ppSamples == NULL || capacity == 0 || opsPerSample == 0)
+	{
+		return (false);
+	}
+
+	*ppSamples = engine_new_zero(SBenchmarkSamples, 1, MEM_TAG_ENGINE);
+	BenchmarkSamples samples = *ppSamples;
+
+	if (samples == NULL)
+	{
+		syserr("Failed to Allocate Memory for BenchmarkSamples");
+		return (false);
+	}
+
+	samples->samples = engine_new_count_zero(uint64_t, capacity, MEM_TAG_ENGINE);
+	if (samples->samples == NULL)
+	{
+		syserr("Failed to Allocate Memory for %zu benchmark samples", capacity);
+		engine_delete(samples);
+		*ppSamples = NULL;
+		return (false);
+	}
+
+	samples->capacity = capacity;
+	samples->opsPerSample = opsPerSample;
+	return (true);
+}
+
+void BenchmarkSamples_Destroy(BenchmarkSamples* ppSamples)
+{
+	if (ppSamples == NULL || *ppSamples == NULL)
+	{
+		return;
+	}
+
+	engine_free((*ppSamples)->samples);
+	engine_delete(*ppSamples);
+	*ppSamples = NULL;
+}
+
+void BenchmarkSamples_Clear(BenchmarkSamples samples)
+{
+	if (samples != NULL)
+	{
+		samples->count = 0;
+	}
+}
+
+void BenchmarkSamples_Add(BenchmarkSamples samples, uint64_t timeNs)
+{
+	if (samples->count < samples->capacity)
+	{
+		samples->samples[samples->count++] = timeNs;
+	}
+}
+
+void BenchmarkSamples_Merge(BenchmarkSamples samples, BenchmarkSamples source)
+{
+	for (size_t i = 0; i < source->count; i++)
+	{
+		BenchmarkSamples_Add(samples, source->samples[i]);
+	}
+}
+
+static int Benchmark_CompareSamples(const void* a, const void* b)
+{
+	uint64_t left = *(const uint64_t*)a;
+	uint64_t right = *(const uint64_t*)b;
+	return ((left > right) - (left < right));
+}
+
+// Nearest rank, converted to ns per operation
+static double BenchmarkSamples_GetPercentile(BenchmarkSamples samples, double percentile)
+{
+	size_t rank = (size_t)ceil(percentile / 100.0 * (double)samples->count);
+	size_t index = (rank > 0) ? rank - 1 : 0;
+	return ((double)samples->samples[index] / (double)samples->opsPerSample);
+}
+
+void BenchmarkSamples_Report(BenchmarkSamples samples, const char* label)
+{
+	if (samples == NULL || samples->count == 0)
+	{
+		syslog("%-28s no samples", label);
+		return;
+	}
+
+	qsort(samples->samples, samples->count, sizeof(uint64_t), Benchmark_CompareSamples);
+
+	uint64_t totalNs = 0;
+	for (size_t i = 0; i < samples->count; i++)
+	{
+		totalNs += samples->samples[i];
+	}
+
+	size_t opsCount = samples->count * samples->opsPerSample;
+	syslog("%-28s %9.1f ns/op | p50 %8.1f | p90 %8.1f | p99 %8.1f | max %9.1f | %zu ops",
+		label,
+		(double)totalNs / (double)opsCount,
+		BenchmarkSamples_GetPercentile(samples, 50.0),
+		BenchmarkSamples_GetPercentile(samples, 90.0),
+		BenchmarkSamples_GetPercentile(samples, 99.0),
+		BenchmarkSamples_GetPercentile(samples, 100.0),
+		opsCount);
+}
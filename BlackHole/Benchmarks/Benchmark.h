@@ -0,0 +1,42 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../Clock/Clock.h"
+
+// Operations timed together per sample, single operations are below the clock resolution
+#define BENCHMARK_BATCH_SIZE 64
+
+// Latency samples, each one is the time taken by 'opsPerSample' operations
+typedef struct SBenchmarkSamples
+{
+	uint64_t* samples;
+	size_t count;
+	size_t capacity;
+	size_t opsPerSample;
+} SBenchmarkSamples;
+
+typedef struct SBenchmarkSamples* BenchmarkSamples;
+
+bool BenchmarkSamples_Initialize(BenchmarkSamples* ppSamples, size_t capacity, size_t opsPerSample);
+void BenchmarkSamples_Destroy(BenchmarkSamples* ppSamples);
+void BenchmarkSamples_Clear(BenchmarkSamples samples);
+// Dropped once the capacity is reached, nothing allocates while timing
+void BenchmarkSamples_Add(BenchmarkSamples samples, uint64_t timeNs);
+// Appends the samples of 'source', both must use the same opsPerSample
+void BenchmarkSamples_Merge(BenchmarkSamples samples, BenchmarkSamples source);
+// Prints mean, p50, p90, p99 and max in ns/op (sorts the samples)
+void BenchmarkSamples_Report(BenchmarkSamples samples, const char* label);
+
+// Alloc/free batches on 1..maxThreads threads: global lock blocking, spinning first, and with thread caches
+void AllocatorBenchmark_Throughput(size_t operationsCount, uint32_t maxThreads);
+
+// List_Insert, List_ForEach and List_Sort on random and presorted values
+void ListBenchmark_InsertSortIterate(size_t elementsCount);
+
+// Shows sorted key insertion no longer degenerates the Map tree, and compares with the hash backend
+void MapBenchmark_SortedVsRandom(size_t keysCount);
+
+#endif // __BENCHMARK_H__
@@ -0,0 +1,33 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "MemoryManager/MemoryManager.h"
+#include "Threading/Thread.h"
+#include "Benchmarks/Benchmark.h"
+#include "Log/Log.h"
+
+// Usage: BlackHoleBenchmark [elements] [max threads]
+int main(int argc, char** argv)
+{
+	size_t elementsCount = (argc > 1) ? (size_t)strtoull(argv[1], NULL, 10) : 100000;
+	uint32_t maxThreads = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : Thread_GetHardwareConcurrency();
+
+	MemoryManager memManager;
+	if (MemoryManager_Initialize(&memManager) == false)
+	{
+		return (EXIT_FAILURE);
+	}
+
+	Log_Initialize();
+
+	printf("BlackHole benchmarks: %zu elements, up to %u threads\n", elementsCount, maxThreads);
+
+	AllocatorBenchmark_Throughput(elementsCount * 10, maxThreads);
+	ListBenchmark_InsertSortIterate(elementsCount);
+	MapBenchmark_SortedVsRandom(elementsCount);
+
+	Log_Destroy(); // Joins the writer thread, its start block would otherwise show as a leak
+	MemoryManager_DumpLeaks();
+	MemoryManager_Destroy(&memManager);
+
+	return (EXIT_SUCCESS);
+}
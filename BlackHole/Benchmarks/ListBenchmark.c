@@ -0,0 +1,132 @@
+#include "Benchmark.h"
+#include "../List/List.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#define LIST_BENCHMARK_ROUNDS 5
+
+static int ListBenchmark_Compare(void* a, void* b)
+{
+	int left = *(int*)a;
+	int right = *(int*)b;
+	return ((left > right) - (left < right));
+}
+
+static void ListBenchmark_Sum(void* data, void* context)
+{
+	*(int64_t*)context += *(int*)data;
+}
+
+// Values live in one array, the list only holds pointers to them like engine object lists
+static void ListBenchmark_Fill(List list, int* values, size_t elementsCount)
+{
+	List_Clear(list);
+	for (size_t i = 0; i < elementsCount; i++)
+	{
+		List_Insert(list, &values[i]);
+	}
+}
+
+void ListBenchmark_InsertSortIterate(size_t elementsCount)
+{
+	if (elementsCount == 0)
+	{
+		return;
+	}
+
+	int* values = engine_new_count_zero(int, elementsCount, MEM_TAG_ENGINE);
+	List list = NULL;
+	BenchmarkSamples insertSamples = NULL;
+	BenchmarkSamples iterateSamples = NULL;
+	BenchmarkSamples sortSamples = NULL;
+	BenchmarkSamples presortedSamples = NULL;
+
+	size_t batchesCount = elementsCount / BENCHMARK_BATCH_SIZE + 1;
+	if (values == NULL || !List_Initialize(&list)
+		|| !BenchmarkSamples_Initialize(&insertSamples, batchesCount * LIST_BENCHMARK_ROUNDS, BENCHMARK_BATCH_SIZE)
+		|| !BenchmarkSamples_Initialize(&iterateSamples, LIST_BENCHMARK_ROUNDS, elementsCount)
+		|| !BenchmarkSamples_Initialize(&sortSamples, LIST_BENCHMARK_ROUNDS, elementsCount)
+		|| !BenchmarkSamples_Initialize(&presortedSamples, LIST_BENCHMARK_ROUNDS, elementsCount))
+	{
+		syserr("ListBenchmark: setup failed");
+		engine_free(values);
+		List_Destroy(&list);
+		BenchmarkSamples_Destroy(&insertSamples);
+		BenchmarkSamples_Destroy(&iterateSamples);
+		BenchmarkSamples_Destroy(&sortSamples);
+		BenchmarkSamples_Destroy(&presortedSamples);
+		return;
+	}
+
+	uint32_t state = 0x2545F491u;
+	for (size_t i = 0; i < elementsCount; i++)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		values[i] = (int)(state >> 1);
+	}
+
+	int64_t sum = 0;
+	for (int round = 0; round < LIST_BENCHMARK_ROUNDS; round++)
+	{
+		// Insert, the first round pays for the node blocks, later rounds reuse recycled nodes
+		List_Clear(list);
+		size_t inserted = 0;
+		while (inserted + BENCHMARK_BATCH_SIZE <= elementsCount)
+		{
+			uint64_t start = Clock_GetTimeNs();
+			for (size_t i = 0; i < BENCHMARK_BATCH_SIZE; i++)
+			{
+				List_Insert(list, &values[inserted + i]);
+			}
+
+			BenchmarkSamples_Add(insertSamples, Clock_GetTimeNs() - start);
+			inserted += BENCHMARK_BATCH_SIZE;
+		}
+
+		for (; inserted < elementsCount; inserted++)
+		{
+			List_Insert(list, &values[inserted]);
+		}
+
+		uint64_t start = Clock_GetTimeNs();
+		List_ForEach(list, ListBenchmark_Sum, &sum);
+		BenchmarkSamples_Add(iterateSamples, Clock_GetTimeNs() - start);
+
+		start = Clock_GetTimeNs();
+		List_Sort(list, ListBenchmark_Compare, true);
+		BenchmarkSamples_Add(sortSamples, Clock_GetTimeNs() - start);
+
+		start = Clock_GetTimeNs();
+		List_Sort(list, ListBenchmark_Compare, true);
+		BenchmarkSamples_Add(presortedSamples, Clock_GetTimeNs() - start);
+	}
+
+	// Keeps the iteration from being optimized away
+	syslog("--- LIST BENCHMARK (%zu elements, checksum %lld) ---", elementsCount, (long long)sum);
+	BenchmarkSamples_Report(insertSamples, "insert");
+	BenchmarkSamples_Report(iterateSamples, "iterate");
+	BenchmarkSamples_Report(sortSamples, "merge sort random");
+	BenchmarkSamples_Report(presortedSamples, "merge sort presorted");
+
+	// Same values, but the nodes now follow the sorted order instead of the allocation order
+	ListBenchmark_Fill(list, values, elementsCount);
+	List_Sort(list, ListBenchmark_Compare, true);
+	BenchmarkSamples_Clear(iterateSamples);
+	for (int round = 0; round < LIST_BENCHMARK_ROUNDS; round++)
+	{
+		uint64_t start = Clock_GetTimeNs();
+		List_ForEach(list, ListBenchmark_Sum, &sum);
+		BenchmarkSamples_Add(iterateSamples, Clock_GetTimeNs() - start);
+	}
+
+	BenchmarkSamples_Report(iterateSamples, "iterate after sort");
+
+	BenchmarkSamples_Destroy(&insertSamples);
+	BenchmarkSamples_Destroy(&iterateSamples);
+	BenchmarkSamples_Destroy(&sortSamples);
+	BenchmarkSamples_Destroy(&presortedSamples);
+	List_Destroy(&list);
+	engine_free(values);
+}
@@ -0,0 +1,122 @@
+#include "Benchmark.h"
+#include "../Map/Map.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#define MAP_BENCHMARK_KEY_LENGTH 40 // "textures/asset_" + the 20 digits of SIZE_MAX + NUL
+
+// Runs 'function' over every key in timed batches, the tail that does not fill a batch runs untimed
+static void MapBenchmark_TimeBatches(Map map, char** keys, size_t keysCount, bool isInsert, BenchmarkSamples samples, size_t* pFound)
+{
+	for (size_t i = 0; i < keysCount; i += BENCHMARK_BATCH_SIZE)
+	{
+		size_t end = (i + BENCHMARK_BATCH_SIZE < keysCount) ? i + BENCHMARK_BATCH_SIZE : keysCount;
+
+		uint64_t start = Clock_GetTimeNs();
+		for (size_t j = i; j < end; j++)
+		{
+			if (isInsert)
+			{
+				Map_Insert(map, keys[j], keys[j]);
+			}
+			else
+			{
+				*pFound += (Map_Find(map, keys[j]) != NULL);
+			}
+		}
+
+		if (end - i == BENCHMARK_BATCH_SIZE)
+		{
+			BenchmarkSamples_Add(samples, Clock_GetTimeNs() - start);
+		}
+	}
+}
+
+static void MapBenchmark_RunOrder(const char* label, EMapBackend backend, char** keys, size_t keysCount)
+{
+	Map map = NULL;
+	BenchmarkSamples insertSamples = NULL;
+	BenchmarkSamples findSamples = NULL;
+	size_t batchesCount = keysCount / BENCHMARK_BATCH_SIZE + 1;
+
+	if (!Map_InitializeWithBackend(&map, backend, MEM_TAG_RESOURCES)
+		|| !BenchmarkSamples_Initialize(&insertSamples, batchesCount, BENCHMARK_BATCH_SIZE)
+		|| !BenchmarkSamples_Initialize(&findSamples, batchesCount, BENCHMARK_BATCH_SIZE))
+	{
+		BenchmarkSamples_Destroy(&insertSamples);
+		Map_Destroy(&map);
+		return;
+	}
+
+	size_t found = 0;
+	MapBenchmark_TimeBatches(map, keys, keysCount, true, insertSamples, &found);
+	MapBenchmark_TimeBatches(map, keys, keysCount, false, findSamples, &found);
+
+	// Height only means something for the tree
+	if (backend == MAP_BACKEND_TREE)
+	{
+		syslog("%-8s height: %zu (found %zu/%zu)", label, Map_GetHeight(map), found, keysCount);
+	}
+	else
+	{
+		syslog("%-8s (found %zu/%zu)", label, found, keysCount);
+	}
+
+	char sampleLabel[64];
+	snprintf(sampleLabel, sizeof(sampleLabel), "%s insert", label);
+	BenchmarkSamples_Report(insertSamples, sampleLabel);
+	snprintf(sampleLabel, sizeof(sampleLabel), "%s find", label);
+	BenchmarkSamples_Report(findSamples, sampleLabel);
+
+	BenchmarkSamples_Destroy(&insertSamples);
+	BenchmarkSamples_Destroy(&findSamples);
+	Map_Destroy(&map);
+}
+
+void MapBenchmark_SortedVsRandom(size_t keysCount)
+{
+	if (keysCount == 0)
+	{
+		return;
+	}
+
+	char* keysBuffer = engine_malloc(keysCount * MAP_BENCHMARK_KEY_LENGTH, MEM_TAG_STRINGS);
+	char** keys = engine_new_count_zero(char*, keysCount, MEM_TAG_STRINGS);
+	if (keysBuffer == NULL || keys == NULL)
+	{
+		engine_free(keysBuffer);
+		engine_free(keys);
+		return;
+	}
+
+	// Zero padded so the generation order is also the strcmp order, like our asset manifests
+	for (size_t i = 0; i < keysCount; i++)
+	{
+		keys[i] = keysBuffer + i * MAP_BENCHMARK_KEY_LENGTH;
+		snprintf(keys[i], MAP_BENCHMARK_KEY_LENGTH, "textures/asset_%08zu", i);
+	}
+
+	syslog("--- MAP BENCHMARK (%zu keys, # = hash backend) ---", keysCount);
+	MapBenchmark_RunOrder("sorted", MAP_BACKEND_TREE, keys, keysCount);
+	MapBenchmark_RunOrder("sorted#", MAP_BACKEND_HASH, keys, keysCount);
+
+	// Fisher-Yates shuffle with a fixed seed so runs are comparable
+	uint32_t state = 0x12345678u;
+	for (size_t i = keysCount - 1; i > 0; i--)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+
+		size_t j = state % (i + 1);
+		char* temp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = temp;
+	}
+
+	MapBenchmark_RunOrder("random", MAP_BACKEND_TREE, keys, keysCount);
+	MapBenchmark_RunOrder("random#", MAP_BACKEND_HASH, keys, keysCount);
+
+	engine_free(keys);
+	engine_free(keysBuffer);
+}
@@ -0,0 +1,29 @@
+#include "Clock.h"
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t Clock_GetTimeNs()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	// Split to avoid overflowing counter * 1e9
+	uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+	uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+	return (seconds * 1000000000ull + remainder * 1000000000ull / frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec);
+#endif
+}
@@ -0,0 +1,9 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include <stdint.h>
+
+// Monotonic clock in nanoseconds, shared by the profiler, the benchmarks and the lock stats
+uint64_t Clock_GetTimeNs();
+
+#endif // __CLOCK_H__
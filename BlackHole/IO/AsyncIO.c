@@ -0,0 +1,583 @@
+#include "AsyncIO.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Threading/Atomic.h"
+#include "../Threading/Thread.h"
+#include "../Threading/Epoch.h"
+#include "../Profiler/Profiler.h"
+#include "../Log/Log.h"
+#include "../Stdafx.h"
+
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define ASYNC_IO_DEFAULT_THREADS 2
+
+// One read from submit to callback, it moves from the request queue to the completion stack
+typedef struct SAsyncIORequest
+{
+	SAsyncReadRequest request;
+	char* szPath; // Owned copy of request.szPath
+	SAsyncReadResult result;
+	struct SAsyncIORequest* next;
+} SAsyncIORequest;
+
+// The file an I/O thread read last, kept open while its queue is busy
+typedef struct SAsyncIOFile
+{
+	char* szPath; // NULL when nothing is open
+#if defined(_WIN32) || defined(_WIN64)
+	HANDLE handle;
+#else
+	int descriptor;
+#endif
+	uint64_t size;
+} SAsyncIOFile;
+
+typedef struct SAsyncIOThread
+{
+	struct SAsyncIO* io;
+	ThreadHandle thread;
+} SAsyncIOThread;
+
+typedef struct SAsyncIO
+{
+	SAsyncIOThread threads[ASYNC_IO_MAX_THREADS];
+	uint32_t threadsCount;
+
+	// Requests waiting for an I/O thread, FIFO
+	SAsyncIORequest* queueHead;
+	SAsyncIORequest* queueTail;
+	bool isShuttingDown;
+	Mutex queueLock;
+	ConditionVariable queueCondition;
+
+	// Lock-free stack pushed by the I/O threads, emptied in one exchange by the polling thread
+	SAsyncIORequest* volatile completed;
+	// Taken from 'completed' but not run yet because of maxCount, oldest first. Polling thread only.
+	SAsyncIORequest* readyHead;
+	SAsyncIORequest* readyTail;
+
+	volatile int32_t pendingCount;
+	volatile int32_t isWaiting; // AsyncIO_Wait sleeps on completionCondition
+	Mutex completionLock;
+	ConditionVariable completionCondition;
+} SAsyncIO;
+
+static void AsyncIOFile_Close(SAsyncIOFile* file)
+{
+	if (file->szPath == NULL)
+	{
+		return;
+	}
+
+#if defined(_WIN32) || defined(_WIN64)
+	CloseHandle(file->handle);
+#else
+	close(file->descriptor);
+#endif
+
+	engine_free(file->szPath);
+	file->szPath = NULL;
+}
+
+static bool AsyncIOFile_Open(SAsyncIOFile* file, const char* szPath)
+{
+	if (file->szPath != NULL && strcmp(file->szPath, szPath) == 0)
+	{
+		return (true);
+	}
+
+	AsyncIOFile_Close(file);
+
+#if defined(_WIN32) || defined(_WIN64)
+	HANDLE handle = CreateFileA(szPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return (false);
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize))
+	{
+		CloseHandle(handle);
+		return (false);
+	}
+
+	file->handle = handle;
+	file->size = (uint64_t)fileSize.QuadPart;
+#else
+	int descriptor = open(szPath, O_RDONLY);
+	if (descriptor < 0)
+	{
+		return (false);
+	}
+
+	struct stat fileStat;
+	if (fstat(descriptor, &fileStat) != 0)
+	{
+		close(descriptor);
+		return (false);
+	}
+
+	file->descriptor = descriptor;
+	file->size = (uint64_t)fileStat.st_size;
+#endif
+
+	file->szPath = engine_strdup(szPath, MEM_TAG_STRINGS);
+	if (file->szPath == NULL)
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		CloseHandle(file->handle);
+#else
+		close(file->descriptor);
+#endif
+		return (false);
+	}
+
+	return (true);
+}
+
+// Positioned read, no shared file pointer, so threads never seek each other's handles
+static bool AsyncIOFile_Read(SAsyncIOFile* file, uint64_t offset, void* pBuffer, size_t size, size_t* pBytesRead)
+{
+	size_t done = 0;
+	while (done < size)
+	{
+#if defined(_WIN32) || defined(_WIN64)
+		OVERLAPPED overlapped = { 0 };
+		overlapped.Offset = (DWORD)(offset + done);
+		overlapped.OffsetHigh = (DWORD)((offset + done) >> 32);
+
+		DWORD chunk = (size - done > 0x40000000) ? 0x40000000 : (DWORD)(size - done);
+		DWORD readCount = 0;
+		if (!ReadFile(file->handle, (uint8_t*)pBuffer + done, chunk, &readCount, &overlapped))
+		{
+			if (GetLastError() != ERROR_HANDLE_EOF)
+			{
+				return (false);
+			}
+		}
+#else
+		ssize_t readCount = pread(file->descriptor, (uint8_t*)pBuffer + done, size - done, (off_t)(offset + done));
+		if (readCount < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return (false);
+		}
+#endif
+
+		// The file got shorter since it was opened
+		if (readCount == 0)
+		{
+			break;
+		}
+
+		done += (size_t)readCount;
+	}
+
+	*pBytesRead = done;
+	return (true);
+}
+
+static void AsyncIO_Read(SAsyncIOFile* file, SAsyncIORequest* request)
+{
+	if (!AsyncIOFile_Open(file, request->szPath))
+	{
+		syserr("AsyncIO: failed to open %s", request->szPath);
+		return;
+	}
+
+	if (request->request.offset > file->size)
+	{
+		syserr("AsyncIO: offset %llu is past the end of %s", (unsigned long long)request->request.offset, request->szPath);
+		return;
+	}
+
+	uint64_t available = file->size - request->request.offset;
+	size_t size = request->request.size;
+	if (size == 0 || size > available)
+	{
+		size = (size_t)available;
+	}
+
+	// An empty read still hands the callback a buffer it can free
+	void* pBuffer = engine_malloc(size > 0 ? size : 1, request->request.tag);
+	if (pBuffer == NULL)
+	{
+		syserr("AsyncIO: failed to allocate %zu bytes for %s", size, request->szPath);
+		return;
+	}
+
+	size_t bytesRead = 0;
+	if (!AsyncIOFile_Read(file, request->request.offset, pBuffer, size, &bytesRead))
+	{
+		syserr("AsyncIO: failed to read %s", request->szPath);
+		engine_free(pBuffer);
+		return;
+	}
+
+	request->result.pBuffer = pBuffer;
+	request->result.size = bytesRead;
+	request->result.isSuccess = true;
+}
+
+static SAsyncIORequest* AsyncIO_TakeRequest(AsyncIO io, bool isBlocking)
+{
+	Mutex_Lock(&io->queueLock);
+
+	while (isBlocking && io->queueHead == NULL && !io->isShuttingDown)
+	{
+		ConditionVariable_Wait(&io->queueCondition, &io->queueLock);
+	}
+
+	SAsyncIORequest* request = io->queueHead;
+	if (request != NULL)
+	{
+		io->queueHead = request->next;
+		if (io->queueHead == NULL)
+		{
+			io->queueTail = NULL;
+		}
+
+		request->next = NULL;
+	}
+
+	Mutex_Unlock(&io->queueLock);
+	return (request);
+}
+
+static void AsyncIO_PushCompletion(AsyncIO io, SAsyncIORequest* request)
+{
+	// Only ever pushed to and emptied whole, so there is no ABA on the head
+	SAsyncIORequest* head;
+	do
+	{
+		head = (SAsyncIORequest*)Atomic_LoadPtr((void* volatile*)&io->completed);
+		request->next = head;
+	} while (!Atomic_CompareExchangePtr((void* volatile*)&io->completed, head, request));
+
+	if (Atomic_Load32(&io->isWaiting) != 0)
+	{
+		Mutex_Lock(&io->completionLock);
+		ConditionVariable_Signal(&io->completionCondition);
+		Mutex_Unlock(&io->completionLock);
+	}
+}
+
+static void AsyncIO_ThreadMain(void* arg)
+{
+	SAsyncIOThread* thread = (SAsyncIOThread*)arg;
+	AsyncIO io = thread->io;
+
+	SAsyncIOFile file;
+	memset(&file, 0, sizeof(file));
+
+	for (;;)
+	{
+		SAsyncIORequest* request = AsyncIO_TakeRequest(io, false);
+		if (request == NULL)
+		{
+			// Idle: let go of the file so it can be replaced on disk
+			AsyncIOFile_Close(&file);
+			request = AsyncIO_TakeRequest(io, true);
+		}
+
+		// Shutting down with an empty queue
+		if (request == NULL)
+		{
+			break;
+		}
+
+		AsyncIO_Read(&file, request);
+		AsyncIO_PushCompletion(io, request);
+	}
+
+	AsyncIOFile_Close(&file);
+	Log_ReleaseThread();
+	Epoch_ReleaseThread();
+	Profiler_ReleaseThread();
+}
+
+static void AsyncIO_FreeRequest(SAsyncIORequest* request)
+{
+	engine_free(request->szPath);
+	engine_delete(request);
+}
+
+bool AsyncIO_Initialize(AsyncIO* ppIO, uint32_t threadsCount)
+{
+	if (ppIO == NULL)
+	{
+		return (false);
+	}
+
+	if (threadsCount == 0)
+	{
+		threadsCount = ASYNC_IO_DEFAULT_THREADS;
+	}
+
+	if (threadsCount > ASYNC_IO_MAX_THREADS)
+	{
+		threadsCount = ASYNC_IO_MAX_THREADS;
+	}
+
+	*ppIO = engine_new_zero(SAsyncIO, 1, MEM_TAG_ENGINE);
+	AsyncIO io = *ppIO;
+
+	if (io == NULL)
+	{
+		syserr("Failed to Allocate Memory for AsyncIO");
+		return (false);
+	}
+
+	Mutex_Initialize(&io->queueLock);
+	ConditionVariable_Initialize(&io->queueCondition);
+	Mutex_Initialize(&io->completionLock);
+	ConditionVariable_Initialize(&io->completionCondition);
+
+	for (uint32_t i = 0; i < threadsCount; i++)
+	{
+		io->threads[i].io = io;
+		if (!Thread_Create(&io->threads[i].thread, AsyncIO_ThreadMain, &io->threads[i]))
+		{
+			syserr("AsyncIO: only %u of %u threads started", i, threadsCount);
+			break;
+		}
+
+		io->threadsCount++;
+	}
+
+	if (io->threadsCount == 0)
+	{
+		AsyncIO_Destroy(ppIO);
+		return (false);
+	}
+
+	return (true);
+}
+
+void AsyncIO_Destroy(AsyncIO* ppIO)
+{
+	if (ppIO == NULL || *ppIO == NULL)
+	{
+		return;
+	}
+
+	AsyncIO io = *ppIO;
+
+	// The threads drain the queue before they leave
+	Mutex_Lock(&io->queueLock);
+	io->isShuttingDown = true;
+	ConditionVariable_Broadcast(&io->queueCondition);
+	Mutex_Unlock(&io->queueLock);
+
+	for (uint32_t i = 0; i < io->threadsCount; i++)
+	{
+		Thread_Join(io->threads[i].thread);
+	}
+
+	// Callbacks own the buffers, so they run rather than the buffers being dropped
+	AsyncIO_PollCompletions(io, 0);
+
+	ConditionVariable_Destroy(&io->completionCondition);
+	Mutex_Destroy(&io->completionLock);
+	ConditionVariable_Destroy(&io->queueCondition);
+	Mutex_Destroy(&io->queueLock);
+
+	engine_delete(io);
+	*ppIO = NULL;
+}
+
+bool AsyncIO_Submit(AsyncIO io, const SAsyncReadRequest* pRequests, uint32_t count)
+{
+	if (io == NULL || (pRequests == NULL && count > 0))
+	{
+		return (false);
+	}
+
+	// Build the chain first, the lock is then held for a single append
+	SAsyncIORequest* first = NULL;
+	SAsyncIORequest* last = NULL;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const SAsyncReadRequest* source = &pRequests[i];
+		SAsyncIORequest* request = NULL;
+
+		if (source->szPath != NULL && source->tag < MEM_TAG_COUNT)
+		{
+			request = engine_new_zero(SAsyncIORequest, 1, MEM_TAG_ENGINE);
+		}
+
+		if (request != NULL)
+		{
+			request->request = *source;
+			request->szPath = engine_strdup(source->szPath, MEM_TAG_STRINGS);
+			request->request.szPath = request->szPath;
+		}
+
+		if (request == NULL || request->szPath == NULL)
+		{
+			syserr("AsyncIO: failed to queue request %u of %u", i, count);
+			if (request != NULL)
+			{
+				AsyncIO_FreeRequest(request);
+			}
+
+			while (first != NULL)
+			{
+				SAsyncIORequest* next = first->next;
+				AsyncIO_FreeRequest(first);
+				first = next;
+			}
+
+			return (false);
+		}
+
+		if (last != NULL)
+		{
+			last->next = request;
+		}
+		else
+		{
+			first = request;
+		}
+
+		last = request;
+	}
+
+	if (first == NULL)
+	{
+		return (true);
+	}
+
+	Atomic_FetchAdd32(&io->pendingCount, (int32_t)count);
+
+	Mutex_Lock(&io->queueLock);
+	if (io->queueTail != NULL)
+	{
+		io->queueTail->next = first;
+	}
+	else
+	{
+		io->queueHead = first;
+	}
+
+	io->queueTail = last;
+
+	if (count == 1)
+	{
+		ConditionVariable_Signal(&io->queueCondition);
+	}
+	else
+	{
+		ConditionVariable_Broadcast(&io->queueCondition);
+	}
+	Mutex_Unlock(&io->queueLock);
+
+	return (true);
+}
+
+uint32_t AsyncIO_PollCompletions(AsyncIO io, uint32_t maxCount)
+{
+	if (io == NULL)
+	{
+		return (0);
+	}
+
+	// The stack is newest first, reverse it so callbacks run in completion order
+	SAsyncIORequest* taken = (SAsyncIORequest*)Atomic_ExchangePtr((void* volatile*)&io->completed, NULL);
+	if (taken != NULL)
+	{
+		SAsyncIORequest* newest = taken;
+		SAsyncIORequest* reversed = NULL;
+		while (taken != NULL)
+		{
+			SAsyncIORequest* next = taken->next;
+			taken->next = reversed;
+			reversed = taken;
+			taken = next;
+		}
+
+		if (io->readyTail != NULL)
+		{
+			io->readyTail->next = reversed;
+		}
+		else
+		{
+			io->readyHead = reversed;
+		}
+
+		io->readyTail = newest;
+	}
+
+	uint32_t ranCount = 0;
+	while (io->readyHead != NULL && (maxCount == 0 || ranCount < maxCount))
+	{
+		SAsyncIORequest* request = io->readyHead;
+		io->readyHead = request->next;
+		if (io->readyHead == NULL)
+		{
+			io->readyTail = NULL;
+		}
+
+		request->result.userData = request->request.userData;
+		if (request->request.callback != NULL)
+		{
+			request->request.callback(&request->result);
+		}
+		else
+		{
+			engine_free(request->result.pBuffer);
+		}
+
+		AsyncIO_FreeRequest(request);
+		Atomic_Decrement32(&io->pendingCount);
+		ranCount++;
+	}
+
+	return (ranCount);
+}
+
+void AsyncIO_Wait(AsyncIO io)
+{
+	if (io == NULL)
+	{
+		return;
+	}
+
+	while (Atomic_Load32(&io->pendingCount) > 0)
+	{
+		if (AsyncIO_PollCompletions(io, 0) > 0)
+		{
+			continue;
+		}
+
+		// Sleep until an I/O thread pushes, re-checking under the lock so the signal is not missed
+		Mutex_Lock(&io->completionLock);
+		Atomic_Exchange32(&io->isWaiting, 1);
+		while (Atomic_LoadPtr((void* volatile*)&io->completed) == NULL)
+		{
+			ConditionVariable_Wait(&io->completionCondition, &io->completionLock);
+		}
+		Atomic_Store32(&io->isWaiting, 0);
+		Mutex_Unlock(&io->completionLock);
+	}
+}
+
+uint32_t AsyncIO_GetPendingCount(AsyncIO io)
+{
+	return ((io != NULL) ? (uint32_t)Atomic_Load32(&io->pendingCount) : 0);
+}
@@ -0,0 +1,52 @@
+#ifndef __ASYNC_IO_H__
+#define __ASYNC_IO_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../MemoryManager/MemoryTags.h"
+
+#define ASYNC_IO_MAX_THREADS 16
+
+typedef struct SAsyncReadResult
+{
+	void* pBuffer; // engine_malloc'd under the request tag, the callback owns it. NULL on failure.
+	size_t size; // Bytes read, shorter than requested at the end of the file
+	bool isSuccess;
+	void* userData;
+} SAsyncReadResult;
+
+// Runs on the thread calling AsyncIO_PollCompletions, never on an I/O thread
+typedef void(*fnReadComplete)(SAsyncReadResult* pResult);
+
+typedef struct SAsyncReadRequest
+{
+	const char* szPath; // Copied on submit
+	uint64_t offset;
+	size_t size; // 0 reads up to the end of the file
+	EMemoryTag tag;
+	fnReadComplete callback;
+	void* userData;
+} SAsyncReadRequest;
+
+typedef struct SAsyncIO* AsyncIO;
+
+// threadsCount = 0 picks 2, enough to keep a disk busy without competing with the workers
+bool AsyncIO_Initialize(AsyncIO* ppIO, uint32_t threadsCount);
+// Finishes the queued reads and runs their callbacks on the calling thread
+void AsyncIO_Destroy(AsyncIO* ppIO);
+
+// Queues the whole batch with a single lock. Requests run in order per I/O thread,
+// consecutive reads from the same file reuse its handle.
+bool AsyncIO_Submit(AsyncIO io, const SAsyncReadRequest* pRequests, uint32_t count);
+
+// Runs up to maxCount finished callbacks (0 = all) and returns how many ran.
+// Call from one thread only, typically once per frame.
+uint32_t AsyncIO_PollCompletions(AsyncIO io, uint32_t maxCount);
+// Polls until every submitted read has completed
+void AsyncIO_Wait(AsyncIO io);
+
+// Submitted reads whose callback has not run yet
+uint32_t AsyncIO_GetPendingCount(AsyncIO io);
+
+#endif // __ASYNC_IO_H__
@@ -0,0 +1,198 @@
+#include "MappedFile.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Maps the file and drops the OS handles, the view keeps the file alive
+static bool MappedFile_Map(MappedFile file, const char* szPath)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	HANDLE hFile = CreateFileA(szPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return (false);
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(hFile);
+		return (false);
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(hFile);
+
+	if (hMapping == NULL)
+	{
+		return (false);
+	}
+
+	file->pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(hMapping);
+
+	file->size = (size_t)fileSize.QuadPart;
+	return (file->pData != NULL);
+#else
+	int fileDescriptor = open(szPath, O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return (false);
+	}
+
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(fileDescriptor);
+		return (false);
+	}
+
+	void* pData = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	close(fileDescriptor);
+
+	if (pData == MAP_FAILED)
+	{
+		return (false);
+	}
+
+	file->pData = pData;
+	file->size = (size_t)fileStat.st_size;
+	return (true);
+#endif
+}
+
+bool MappedFile_Open(MappedFile* ppFile, const char* szPath, EMemoryTag tag)
+{
+	if (!ppFile || szPath == NULL)
+	{
+		return (false);
+	}
+
+	*ppFile = engine_new_zero(SMappedFile, 1, tag);
+	MappedFile file = *ppFile;
+
+	if (file == NULL)
+	{
+		syserr("Failed to Allocate MappedFile Memory");
+		return (false);
+	}
+
+	if (!MappedFile_Map(file, szPath))
+	{
+		syserr("Failed to map file %s", szPath);
+		engine_delete(file);
+		*ppFile = NULL;
+		return (false);
+	}
+
+	file->tag = tag;
+	MemoryManager_TrackMapping(tag, file->size);
+	return (true);
+}
+
+void MappedFile_Close(MappedFile* ppFile)
+{
+	if (!ppFile || !*ppFile)
+	{
+		return;
+	}
+
+	MappedFile file = *ppFile;
+
+#if defined(_WIN32) || defined(_WIN64)
+	UnmapViewOfFile(file->pData);
+#else
+	munmap((void*)file->pData, file->size);
+#endif
+
+	MemoryManager_UntrackMapping(file->tag, file->size);
+	engine_delete(file);
+	*ppFile = NULL;
+}
+
+const void* MappedFile_GetView(MappedFile file, size_t offset, size_t size)
+{
+	if (file == NULL || offset > file->size || size > file->size - offset)
+	{
+		return (NULL);
+	}
+
+	return ((const uint8_t*)file->pData + offset);
+}
+
+static size_t MappedFile_GetPageSize()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return ((size_t)systemInfo.dwPageSize);
+#else
+	return ((size_t)sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Clamps the range to the file and widens it to whole pages, the view itself starts on a page
+static bool MappedFile_GetPages(MappedFile file, size_t offset, size_t size, void** ppStart, size_t* pLength)
+{
+	if (file == NULL || offset >= file->size || size == 0)
+	{
+		return (false);
+	}
+
+	if (size > file->size - offset)
+	{
+		size = file->size - offset;
+	}
+
+	size_t pageSize = MappedFile_GetPageSize();
+	size_t first = offset & ~(pageSize - 1);
+	size_t last = (offset + size + pageSize - 1) & ~(pageSize - 1);
+
+	*ppStart = (uint8_t*)file->pData + first;
+	*pLength = last - first;
+	return (true);
+}
+
+void MappedFile_Prefetch(MappedFile file, size_t offset, size_t size)
+{
+	void* pStart;
+	size_t length;
+	if (!MappedFile_GetPages(file, offset, size, &pStart, &length))
+	{
+		return;
+	}
+
+#if defined(_WIN32) || defined(_WIN64)
+	WIN32_MEMORY_RANGE_ENTRY range = { pStart, length };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	madvise(pStart, length, MADV_WILLNEED);
+#endif
+}
+
+void MappedFile_Release(MappedFile file, size_t offset, size_t size)
+{
+	void* pStart;
+	size_t length;
+	if (!MappedFile_GetPages(file, offset, size, &pStart, &length))
+	{
+		return;
+	}
+
+#if defined(_WIN32) || defined(_WIN64)
+	// Unlocking pages that are not locked removes them from the working set
+	VirtualUnlock(pStart, length);
+#else
+	// The mapping is read only, so the pages are clean and simply dropped
+	madvise(pStart, length, MADV_DONTNEED);
+#endif
+}
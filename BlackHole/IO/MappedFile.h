@@ -0,0 +1,30 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../MemoryManager/MemoryTags.h"
+
+// Read only view of a whole file, pages are loaded by the OS on first touch
+typedef struct SMappedFile
+{
+	const void* pData;
+	size_t size;
+	EMemoryTag tag; // The mapped bytes count under this tag until Close
+} SMappedFile;
+
+typedef struct SMappedFile* MappedFile;
+
+bool MappedFile_Open(MappedFile* ppFile, const char* szPath, EMemoryTag tag);
+void MappedFile_Close(MappedFile* ppFile);
+
+// Zero copy view of [offset, offset + size), NULL when the range is outside the file.
+// Valid until Close.
+const void* MappedFile_GetView(MappedFile file, size_t offset, size_t size);
+
+// Hints, the range is widened to whole pages. Prefetch starts reading the pages in the background,
+// Release drops them from memory, a later access reads them from disk again.
+void MappedFile_Prefetch(MappedFile file, size_t offset, size_t size);
+void MappedFile_Release(MappedFile file, size_t offset, size_t size);
+
+#endif // __MAPPED_FILE_H__
@@ -0,0 +1,360 @@
+#include "IndexedList.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+static IndexedListNode IndexedList_CreateNode(int32_t levelCount, void* value)
+{
+	size_t nodeSize = sizeof(SIndexedListNode) + sizeof(SIndexedListLevel) * levelCount;
+
+	IndexedListNode node = engine_calloc(1, nodeSize, MEM_TAG_ENGINE);
+	if (node == NULL)
+	{
+		return (NULL);
+	}
+
+	node->data = value;
+	node->levelCount = levelCount;
+	return (node);
+}
+
+static int32_t IndexedList_RandomLevel(IndexedList list)
+{
+	int32_t level = 1;
+
+	// xorshift32, each extra level has a 1/4 chance
+	while (level < INDEXED_LIST_MAX_LEVEL)
+	{
+		uint32_t x = list->randomState;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		list->randomState = x;
+
+		if ((x & 3) != 0)
+		{
+			break;
+		}
+
+		level++;
+	}
+
+	return (level);
+}
+
+// Find the last node on each level that sits before position 'rank' (1-based, head is rank 0)
+static void IndexedList_FindPredecessors(IndexedList list, size_t rank, IndexedListNode* update, size_t* ranks)
+{
+	IndexedListNode curr = list->headNode;
+	size_t traversed = 0;
+
+	for (int32_t i = list->levelCount - 1; i >= 0; i--)
+	{
+		while (curr->levels[i].next != NULL && traversed + curr->levels[i].span < rank)
+		{
+			traversed += curr->levels[i].span;
+			curr = curr->levels[i].next;
+		}
+
+		update[i] = curr;
+		ranks[i] = traversed;
+	}
+}
+
+static IndexedListNode IndexedList_GetNode(IndexedList list, int index)
+{
+	if (list == NULL || index < 0 || (size_t)index >= list->elementsCount)
+	{
+		return (NULL);
+	}
+
+	size_t rank = (size_t)index + 1;
+	size_t traversed = 0;
+	IndexedListNode curr = list->headNode;
+
+	for (int32_t i = list->levelCount - 1; i >= 0; i--)
+	{
+		while (curr->levels[i].next != NULL && traversed + curr->levels[i].span <= rank)
+		{
+			traversed += curr->levels[i].span;
+			curr = curr->levels[i].next;
+		}
+
+		if (traversed == rank)
+		{
+			return (curr);
+		}
+	}
+
+	return (NULL);
+}
+
+bool IndexedList_Initialize(IndexedList* ppList)
+{
+	if (ppList == NULL)
+	{
+		return (false);
+	}
+
+	*ppList = engine_new_zero(SIndexedList, 1, MEM_TAG_ENGINE);
+	IndexedList list = *ppList;
+
+	if (list == NULL)
+	{
+		return (false);
+	}
+
+	list->headNode = IndexedList_CreateNode(INDEXED_LIST_MAX_LEVEL, NULL);
+	if (list->headNode == NULL)
+	{
+		engine_delete(list);
+		*ppList = NULL;
+		return (false);
+	}
+
+	list->levelCount = 1;
+	list->randomState = 0x9E3779B9u ^ (uint32_t)(uintptr_t)list; // any non-zero seed works
+	if (list->randomState == 0)
+	{
+		list->randomState = 0x9E3779B9u;
+	}
+
+	return (true);
+}
+
+void IndexedList_Destroy(IndexedList* ppList)
+{
+	if (ppList == NULL || *ppList == NULL)
+	{
+		return;
+	}
+
+	IndexedList list = *ppList;
+
+	IndexedList_Clear(list);
+
+	engine_delete(list->headNode);
+	engine_delete(list);
+
+	*ppList = NULL;
+}
+
+void IndexedList_Clear(IndexedList list)
+{
+	if (list == NULL)
+	{
+		return;
+	}
+
+	// Level 0 links every node
+	IndexedListNode curr = list->headNode->levels[0].next;
+	while (curr != NULL)
+	{
+		IndexedListNode next = curr->levels[0].next;
+		engine_free(curr);
+		curr = next;
+	}
+
+	for (int32_t i = 0; i < INDEXED_LIST_MAX_LEVEL; i++)
+	{
+		list->headNode->levels[i].next = NULL;
+		list->headNode->levels[i].span = 0;
+	}
+
+	list->levelCount = 1;
+	list->elementsCount = 0;
+}
+
+bool IndexedList_Insert(IndexedList list, void* value)
+{
+	if (list == NULL)
+	{
+		return (false);
+	}
+
+	return IndexedList_InsertAt(list, value, (int)list->elementsCount);
+}
+
+bool IndexedList_InsertStart(IndexedList list, void* value)
+{
+	return IndexedList_InsertAt(list, value, 0);
+}
+
+bool IndexedList_InsertAt(IndexedList list, void* value, int index)
+{
+	if (list == NULL || index < 0 || (size_t)index > list->elementsCount)
+	{
+		return (false);
+	}
+
+	IndexedListNode update[INDEXED_LIST_MAX_LEVEL] = { 0 };
+	size_t ranks[INDEXED_LIST_MAX_LEVEL];
+
+	// The new node takes rank index + 1, so its predecessors have rank <= index
+	IndexedList_FindPredecessors(list, (size_t)index + 1, update, ranks);
+
+	int32_t level = IndexedList_RandomLevel(list);
+	IndexedListNode newNode = IndexedList_CreateNode(level, value);
+	if (newNode == NULL)
+	{
+		return (false);
+	}
+
+	// Levels we never used before start at the head
+	if (level > list->levelCount)
+	{
+		for (int32_t i = list->levelCount; i < level; i++)
+		{
+			update[i] = list->headNode;
+			ranks[i] = 0;
+			list->headNode->levels[i].next = NULL;
+			list->headNode->levels[i].span = 0;
+		}
+
+		list->levelCount = level;
+	}
+
+	for (int32_t i = 0; i < level; i++)
+	{
+		SIndexedListLevel* prevLevel = &update[i]->levels[i];
+
+		newNode->levels[i].next = prevLevel->next;
+		if (prevLevel->next != NULL)
+		{
+			// The old successor moves one position further
+			newNode->levels[i].span = prevLevel->span - ((size_t)index - ranks[i]);
+		}
+
+		prevLevel->next = newNode;
+		prevLevel->span = (size_t)index + 1 - ranks[i];
+	}
+
+	// Higher levels jump over the new node
+	for (int32_t i = level; i < list->levelCount; i++)
+	{
+		if (update[i]->levels[i].next != NULL)
+		{
+			update[i]->levels[i].span++;
+		}
+	}
+
+	list->elementsCount++;
+	return (true);
+}
+
+void* IndexedList_Get(IndexedList list, int index)
+{
+	IndexedListNode node = IndexedList_GetNode(list, index);
+	if (node == NULL)
+	{
+		return (NULL);
+	}
+
+	return (node->data);
+}
+
+bool IndexedList_Set(IndexedList list, int index, void* value)
+{
+	IndexedListNode node = IndexedList_GetNode(list, index);
+	if (node == NULL)
+	{
+		return (false);
+	}
+
+	node->data = value;
+	return (true);
+}
+
+int IndexedList_IndexOf(IndexedList list, void* value)
+{
+	if (list == NULL)
+	{
+		return (-1);
+	}
+
+	// Values are not ordered, so this is still a linear scan
+	int index = 0;
+	for (IndexedListNode curr = list->headNode->levels[0].next; curr != NULL; curr = curr->levels[0].next)
+	{
+		if (curr->data == value)
+		{
+			return (index);
+		}
+
+		index++;
+	}
+
+	return (-1);
+}
+
+bool IndexedList_RemoveIndex(IndexedList list, int index)
+{
+	if (list == NULL || index < 0 || (size_t)index >= list->elementsCount)
+	{
+		return (false);
+	}
+
+	IndexedListNode update[INDEXED_LIST_MAX_LEVEL] = { 0 };
+	size_t ranks[INDEXED_LIST_MAX_LEVEL];
+
+	IndexedList_FindPredecessors(list, (size_t)index + 1, update, ranks);
+
+	IndexedListNode target = update[0]->levels[0].next;
+	if (target == NULL)
+	{
+		return (false);
+	}
+
+	for (int32_t i = 0; i < list->levelCount; i++)
+	{
+		SIndexedListLevel* prevLevel = &update[i]->levels[i];
+
+		if (prevLevel->next == target)
+		{
+			prevLevel->span += target->levels[i].span - 1;
+			prevLevel->next = target->levels[i].next;
+		}
+		else if (prevLevel->next != NULL)
+		{
+			prevLevel->span--;
+		}
+	}
+
+	// Drop levels that became empty
+	while (list->levelCount > 1 && list->headNode->levels[list->levelCount - 1].next == NULL)
+	{
+		list->headNode->levels[list->levelCount - 1].span = 0;
+		list->levelCount--;
+	}
+
+	engine_delete(target);
+	list->elementsCount--;
+	return (true);
+}
+
+bool IndexedList_Remove(IndexedList list, void* value)
+{
+	int index = IndexedList_IndexOf(list, value);
+	if (index < 0)
+	{
+		printf("Failed to find the element in the list\n");
+		return (false);
+	}
+
+	return IndexedList_RemoveIndex(list, index);
+}
+
+void IndexedList_ForEach(IndexedList list, fnFunc function, void* context)
+{
+	if (list == NULL || function == NULL)
+	{
+		return;
+	}
+
+	IndexedListNode curr = list->headNode->levels[0].next;
+	while (curr != NULL)
+	{
+		IndexedListNode next = curr->levels[0].next;
+		function(curr->data, context);
+		curr = next;
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef __INDEXED_LIST_H__
+#define __INDEXED_LIST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "List.h"
+
+// Enough for 4^32 elements with the 1/4 promotion probability
+#define INDEXED_LIST_MAX_LEVEL 32
+
+typedef struct SIndexedListLevel
+{
+	struct SIndexedListNode* next; // Next Element on this level
+	size_t span; // How many positions 'next' is ahead of this node
+} SIndexedListLevel;
+
+typedef struct SIndexedListNode
+{
+	void* data;
+	int32_t levelCount;
+	SIndexedListLevel levels[]; // levelCount entries, allocated with the node
+} SIndexedListNode;
+
+typedef struct SIndexedListNode* IndexedListNode;
+
+// Skip list with span counts, positional operations are O(log n) instead of walking from the root
+typedef struct SIndexedList
+{
+	IndexedListNode headNode; // Sentinel with INDEXED_LIST_MAX_LEVEL levels, holds no data
+	int32_t levelCount; // Highest level currently in use
+	uint32_t randomState;
+	size_t elementsCount;
+} SIndexedList;
+
+typedef struct SIndexedList* IndexedList;
+
+bool IndexedList_Initialize(IndexedList* ppList);
+void IndexedList_Destroy(IndexedList* ppList);
+void IndexedList_Clear(IndexedList list);
+
+bool IndexedList_Insert(IndexedList list, void* value);
+bool IndexedList_InsertStart(IndexedList list, void* value);
+bool IndexedList_InsertAt(IndexedList list, void* value, int index);
+
+void* IndexedList_Get(IndexedList list, int index);
+bool IndexedList_Set(IndexedList list, int index, void* value);
+int IndexedList_IndexOf(IndexedList list, void* value);
+
+bool IndexedList_RemoveIndex(IndexedList list, int index);
+bool IndexedList_Remove(IndexedList list, void* value);
+
+void IndexedList_ForEach(IndexedList list, fnFunc function, void* context);
+
+#endif // __INDEXED_LIST_H__
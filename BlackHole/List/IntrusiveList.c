@@ -0,0 +1,217 @@
+#include "IntrusiveList.h"
+#include "../Stdafx.h"
+
+// Splice 'link' between two neighbours that are already linked to each other
+static void IntrusiveList_Link(IntrusiveLink prev, IntrusiveLink next, IntrusiveLink link)
+{
+	link->prev = prev;
+	link->next = next;
+	prev->next = link;
+	next->prev = link;
+}
+
+static void IntrusiveList_Unlink(IntrusiveLink link)
+{
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
+	link->prev = NULL;
+	link->next = NULL;
+}
+
+void IntrusiveList_Initialize(IntrusiveList list)
+{
+	if (list == NULL)
+	{
+		return;
+	}
+
+	// Empty list: the sentinel points to itself, so insert/remove never check for NULL
+	list->head.prev = &list->head;
+	list->head.next = &list->head;
+	list->elementsCount = 0;
+}
+
+void IntrusiveList_Clear(IntrusiveList list)
+{
+	if (list == NULL)
+	{
+		return;
+	}
+
+	// Owners are not freed, we only reset their links so they can be reinserted
+	IntrusiveLink curr = list->head.next;
+	while (curr != &list->head)
+	{
+		IntrusiveLink next = curr->next;
+		curr->prev = NULL;
+		curr->next = NULL;
+		curr = next;
+	}
+
+	IntrusiveList_Initialize(list);
+}
+
+void IntrusiveLink_Initialize(IntrusiveLink link)
+{
+	if (link == NULL)
+	{
+		return;
+	}
+
+	link->prev = NULL;
+	link->next = NULL;
+}
+
+bool IntrusiveLink_IsLinked(IntrusiveLink link)
+{
+	return (link != NULL && link->next != NULL);
+}
+
+bool IntrusiveList_IsEmpty(IntrusiveList list)
+{
+	return (list == NULL || list->head.next == &list->head);
+}
+
+IntrusiveLink IntrusiveList_Front(IntrusiveList list)
+{
+	if (IntrusiveList_IsEmpty(list))
+	{
+		return (NULL);
+	}
+
+	return (list->head.next);
+}
+
+IntrusiveLink IntrusiveList_Back(IntrusiveList list)
+{
+	if (IntrusiveList_IsEmpty(list))
+	{
+		return (NULL);
+	}
+
+	return (list->head.prev);
+}
+
+bool IntrusiveList_PushFront(IntrusiveList list, IntrusiveLink link)
+{
+	return IntrusiveList_InsertAfter(list, &list->head, link);
+}
+
+bool IntrusiveList_PushBack(IntrusiveList list, IntrusiveLink link)
+{
+	return IntrusiveList_InsertBefore(list, &list->head, link);
+}
+
+bool IntrusiveList_InsertBefore(IntrusiveList list, IntrusiveLink position, IntrusiveLink link)
+{
+	if (list == NULL || position == NULL || link == NULL)
+	{
+		return (false);
+	}
+
+	// A link can only be in one list at a time
+	if (IntrusiveLink_IsLinked(link))
+	{
+		syserr("IntrusiveList: trying to insert a link that is already linked (%p)", (void*)link);
+		return (false);
+	}
+
+	IntrusiveList_Link(position->prev, position, link);
+	list->elementsCount++;
+
+	return (true);
+}
+
+bool IntrusiveList_InsertAfter(IntrusiveList list, IntrusiveLink position, IntrusiveLink link)
+{
+	if (list == NULL || position == NULL || link == NULL)
+	{
+		return (false);
+	}
+
+	if (IntrusiveLink_IsLinked(link))
+	{
+		syserr("IntrusiveList: trying to insert a link that is already linked (%p)", (void*)link);
+		return (false);
+	}
+
+	IntrusiveList_Link(position, position->next, link);
+	list->elementsCount++;
+
+	return (true);
+}
+
+bool IntrusiveList_Remove(IntrusiveList list, IntrusiveLink link)
+{
+	if (list == NULL || !IntrusiveLink_IsLinked(link) || link == &list->head)
+	{
+		return (false);
+	}
+
+	IntrusiveList_Unlink(link);
+	list->elementsCount--;
+
+	return (true);
+}
+
+IntrusiveLink IntrusiveList_PopFront(IntrusiveList list)
+{
+	IntrusiveLink link = IntrusiveList_Front(list);
+	if (link != NULL)
+	{
+		IntrusiveList_Remove(list, link);
+	}
+
+	return (link);
+}
+
+IntrusiveLink IntrusiveList_PopBack(IntrusiveList list)
+{
+	IntrusiveLink link = IntrusiveList_Back(list);
+	if (link != NULL)
+	{
+		IntrusiveList_Remove(list, link);
+	}
+
+	return (link);
+}
+
+void IntrusiveList_MoveToFront(IntrusiveList list, IntrusiveLink link)
+{
+	if (list == NULL || !IntrusiveLink_IsLinked(link))
+	{
+		return;
+	}
+
+	// Relink without touching the elements count
+	IntrusiveList_Unlink(link);
+	IntrusiveList_Link(&list->head, list->head.next, link);
+}
+
+void IntrusiveList_MoveToBack(IntrusiveList list, IntrusiveLink link)
+{
+	if (list == NULL || !IntrusiveLink_IsLinked(link))
+	{
+		return;
+	}
+
+	IntrusiveList_Unlink(link);
+	IntrusiveList_Link(list->head.prev, &list->head, link);
+}
+
+void IntrusiveList_ForEach(IntrusiveList list, fnFunc function, void* context)
+{
+	if (list == NULL || function == NULL)
+	{
+		return;
+	}
+
+	IntrusiveLink curr = list->head.next;
+	while (curr != &list->head)
+	{
+		// Grab next first, the callback is allowed to unlink the current element
+		IntrusiveLink next = curr->next;
+		function(curr, context);
+		curr = next;
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef __INTRUSIVE_LIST_H__
+#define __INTRUSIVE_LIST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "List.h"
+
+// The link lives inside the user's struct, so linking/unlinking never allocates
+typedef struct SIntrusiveLink
+{
+	struct SIntrusiveLink* prev; // Previous Element
+	struct SIntrusiveLink* next; // Next Element
+} SIntrusiveLink;
+
+typedef struct SIntrusiveLink* IntrusiveLink;
+
+typedef struct SIntrusiveList
+{
+	SIntrusiveLink head; // Sentinel: head.next is the first element, head.prev is the last one
+	size_t elementsCount;
+} SIntrusiveList;
+
+typedef struct SIntrusiveList* IntrusiveList;
+
+// Get the owner struct back from its embedded link (container-of)
+#define IntrusiveList_Entry(link, type, member) ((type*)((char*)(link) - offsetof(type, member)))
+
+// Iterate the links, do NOT unlink 'it' inside the loop
+#define IntrusiveList_ForEachLink(list, it) \
+	for (IntrusiveLink it = (list)->head.next; it != &(list)->head; it = it->next)
+
+// Iterate the links, 'it' can be safely unlinked inside the loop
+#define IntrusiveList_ForEachLinkSafe(list, it, nextIt) \
+	for (IntrusiveLink it = (list)->head.next, nextIt = it->next; it != &(list)->head; it = nextIt, nextIt = it->next)
+
+// Lists are usually embedded in their owner system, so they are initialized in place
+void IntrusiveList_Initialize(IntrusiveList list);
+void IntrusiveList_Clear(IntrusiveList list);
+
+void IntrusiveLink_Initialize(IntrusiveLink link);
+bool IntrusiveLink_IsLinked(IntrusiveLink link);
+
+bool IntrusiveList_IsEmpty(IntrusiveList list);
+IntrusiveLink IntrusiveList_Front(IntrusiveList list);
+IntrusiveLink IntrusiveList_Back(IntrusiveList list);
+
+bool IntrusiveList_PushFront(IntrusiveList list, IntrusiveLink link);
+bool IntrusiveList_PushBack(IntrusiveList list, IntrusiveLink link);
+bool IntrusiveList_InsertBefore(IntrusiveList list, IntrusiveLink position, IntrusiveLink link);
+bool IntrusiveList_InsertAfter(IntrusiveList list, IntrusiveLink position, IntrusiveLink link);
+
+bool IntrusiveList_Remove(IntrusiveList list, IntrusiveLink link);
+IntrusiveLink IntrusiveList_PopFront(IntrusiveList list);
+IntrusiveLink IntrusiveList_PopBack(IntrusiveList list);
+
+// LRU helpers
+void IntrusiveList_MoveToFront(IntrusiveList list, IntrusiveLink link);
+void IntrusiveList_MoveToBack(IntrusiveList list, IntrusiveLink link);
+
+// The callback receives the link, use IntrusiveList_Entry to reach the owner
+void IntrusiveList_ForEach(IntrusiveList list, fnFunc function, void* context);
+
+#endif // __INTRUSIVE_LIST_H__
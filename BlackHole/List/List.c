@@ -1,8 +1,330 @@
 #include "List.h"
 #include "../MemoryManager/MemoryManager.h"
+#include "../Profiler/Profiler.h"
 #include "../Stdafx.h"
 
+#define LIST_INDEX_INITIAL_CAPACITY 16
+#define LIST_NODE_BLOCK_MIN 16
+#define LIST_NODE_BLOCK_MAX 4096
+
+typedef enum EListIndexSlot
+{
+	LIST_INDEX_SLOT_EMPTY = 0,
+	LIST_INDEX_SLOT_USED,
+	LIST_INDEX_SLOT_DELETED, // Tombstone, keeps probe chains intact
+} EListIndexSlot;
+
+// A singly linked node can only be unlinked through its predecessor, so the index
+// stores the predecessor (NULL for the root). (value, predecessor) is unique per node,
+// which also keeps duplicated values apart.
+typedef struct SListIndexEntry
+{
+	void* value;
+	ListNode prevNode;
+	uint32_t state;
+} SListIndexEntry;
+
+typedef struct SListIndex
+{
+	SListIndexEntry* entries;
+	size_t capacity; // Always a power of two
+	size_t usedCount;
+	size_t deletedCount;
+} SListIndex;
+
+static size_t ListIndex_Hash(void* value)
+{
+	// Pointers are aligned, shift the dead low bits away then mix (Fibonacci hashing)
+	uint64_t key = (uint64_t)(uintptr_t)value >> 4;
+	key *= 0x9E3779B97F4A7C15ull;
+	return (size_t)(key ^ (key >> 32));
+}
+
+static bool ListIndex_Resize(SListIndex* index, size_t newCapacity)
+{
+	SListIndexEntry* newEntries = engine_new_count_zero(SListIndexEntry, newCapacity, MEM_TAG_ENGINE);
+	if (newEntries == NULL)
+	{
+		return (false);
+	}
+
+	size_t mask = newCapacity - 1;
+	for (size_t i = 0; i < index->capacity; i++)
+	{
+		SListIndexEntry* entry = &index->entries[i];
+		if (entry->state != LIST_INDEX_SLOT_USED)
+		{
+			continue;
+		}
+
+		size_t slot = ListIndex_Hash(entry->value) & mask;
+		while (newEntries[slot].state != LIST_INDEX_SLOT_EMPTY)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		newEntries[slot] = *entry;
+	}
+
+	engine_free(index->entries);
+	index->entries = newEntries;
+	index->capacity = newCapacity;
+	index->deletedCount = 0;
+	return (true);
+}
+
+static SListIndexEntry* ListIndex_FindEntry(SListIndex* index, void* value, ListNode prevNode, bool anyPrev)
+{
+	size_t mask = index->capacity - 1;
+	size_t slot = ListIndex_Hash(value) & mask;
+
+	while (index->entries[slot].state != LIST_INDEX_SLOT_EMPTY)
+	{
+		SListIndexEntry* entry = &index->entries[slot];
+		if (entry->state == LIST_INDEX_SLOT_USED && entry->value == value && (anyPrev || entry->prevNode == prevNode))
+		{
+			return (entry);
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	return (NULL);
+}
+
+// Keeps probing past 'entry', equal values share its probe chain
+static bool ListIndex_HasDuplicate(SListIndex* index, SListIndexEntry* entry)
+{
+	size_t mask = index->capacity - 1;
+	size_t slot = ((size_t)(entry - index->entries) + 1) & mask;
+
+	while (index->entries[slot].state != LIST_INDEX_SLOT_EMPTY)
+	{
+		if (index->entries[slot].state == LIST_INDEX_SLOT_USED && index->entries[slot].value == entry->value)
+		{
+			return (true);
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	return (false);
+}
+
+static bool ListIndex_Add(SListIndex* index, void* value, ListNode prevNode)
+{
+	// Keep the load (tombstones included) under 75%
+	if ((index->usedCount + index->deletedCount + 1) * 4 > index->capacity * 3)
+	{
+		size_t newCapacity = index->capacity;
+		if ((index->usedCount + 1) * 2 > index->capacity)
+		{
+			newCapacity *= 2; // Really full, otherwise just flush the tombstones
+		}
+
+		if (!ListIndex_Resize(index, newCapacity))
+		{
+			return (false);
+		}
+	}
+
+	size_t mask = index->capacity - 1;
+	size_t slot = ListIndex_Hash(value) & mask;
+	while (index->entries[slot].state == LIST_INDEX_SLOT_USED)
+	{
+		slot = (slot + 1) & mask;
+	}
+
+	if (index->entries[slot].state == LIST_INDEX_SLOT_DELETED)
+	{
+		index->deletedCount--;
+	}
+
+	index->entries[slot].value = value;
+	index->entries[slot].prevNode = prevNode;
+	index->entries[slot].state = LIST_INDEX_SLOT_USED;
+	index->usedCount++;
+	return (true);
+}
+
+// Grows once so the next 'count' adds fit under the load limit without resizing
+static bool ListIndex_Reserve(SListIndex* index, size_t count)
+{
+	if ((index->usedCount + index->deletedCount + count) * 4 <= index->capacity * 3)
+	{
+		return (true);
+	}
+
+	// The resize drops the tombstones, only the live entries count
+	size_t newCapacity = index->capacity;
+	while ((index->usedCount + count) * 4 > newCapacity * 3)
+	{
+		newCapacity *= 2;
+	}
+
+	return ListIndex_Resize(index, newCapacity);
+}
+
+static void ListIndex_Erase(SListIndex* index, void* value, ListNode prevNode)
+{
+	SListIndexEntry* entry = ListIndex_FindEntry(index, value, prevNode, false);
+	if (entry == NULL)
+	{
+		return;
+	}
+
+	entry->state = LIST_INDEX_SLOT_DELETED;
+	index->usedCount--;
+	index->deletedCount++;
+}
+
+// 'node' got a new predecessor
+static void ListIndex_Relink(SListIndex* index, ListNode node, ListNode oldPrev, ListNode newPrev)
+{
+	if (node == NULL)
+	{
+		return;
+	}
+
+	SListIndexEntry* entry = ListIndex_FindEntry(index, node->data, oldPrev, false);
+	if (entry != NULL)
+	{
+		entry->prevNode = newPrev;
+	}
+}
+
+static void ListIndex_Reset(SListIndex* index)
+{
+	memset(index->entries, 0, sizeof(SListIndexEntry) * index->capacity);
+	index->usedCount = 0;
+	index->deletedCount = 0;
+}
+
+// Sorting moves nodes/data around, rebuilding is O(n) which is below the sort itself
+static void ListIndex_Rebuild(List list)
+{
+	if (list->valueIndex == NULL)
+	{
+		return;
+	}
+
+	ListIndex_Reset(list->valueIndex);
+
+	ListNode prev = NULL;
+	for (ListNode curr = list->rootNode; curr != NULL; curr = curr->next)
+	{
+		if (!ListIndex_Add(list->valueIndex, curr->data, prev))
+		{
+			syserr("List: failed to rebuild the value index");
+			return;
+		}
+
+		prev = curr;
+	}
+}
+
+// Finds the first node holding 'value' and its predecessor.
+// The index answers directly for a unique value, a duplicated one is walked from the root
+// so the first occurrence wins like without the index.
+static ListNode List_FindWithPrev(List list, void* value, ListNode* pPrev)
+{
+	*pPrev = NULL;
+
+	if (list->valueIndex != NULL)
+	{
+		SListIndexEntry* entry = ListIndex_FindEntry(list->valueIndex, value, NULL, true);
+		if (entry == NULL)
+		{
+			return (NULL);
+		}
+
+		if (!ListIndex_HasDuplicate(list->valueIndex, entry))
+		{
+			*pPrev = entry->prevNode;
+			return (entry->prevNode != NULL ? entry->prevNode->next : list->rootNode);
+		}
+	}
+
+	for (ListNode curr = list->rootNode; curr != NULL; curr = curr->next)
+	{
+		if (curr->data == value)
+		{
+			return (curr);
+		}
+
+		*pPrev = curr;
+	}
+
+	*pPrev = NULL;
+	return (NULL);
+}
+
+// Allocate one block of 'count' nodes and push them all to the freelist
+static bool List_AllocateNodeBlock(List list, size_t count)
+{
+	SListNodeBlock* block = engine_malloc(sizeof(SListNodeBlock) + sizeof(SListNode) * count, MEM_TAG_ENGINE);
+	if (block == NULL)
+	{
+		return (false);
+	}
+
+	block->nodesCount = count;
+	block->next = list->nodeBlocks;
+	list->nodeBlocks = block;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		block->nodes[i].data = NULL;
+		block->nodes[i].next = (i + 1 < count) ? &block->nodes[i + 1] : list->freeNode;
+	}
+
+	list->freeNode = &block->nodes[0];
+	list->freeCount += count;
+	return (true);
+}
+
+static ListNode List_AllocateNode(List list)
+{
+	if (list->freeNode == NULL)
+	{
+		// Grow geometrically so long lists need few blocks
+		size_t count = LIST_NODE_BLOCK_MIN;
+		if (list->nodeBlocks != NULL)
+		{
+			count = list->nodeBlocks->nodesCount * 2;
+			count = count < LIST_NODE_BLOCK_MIN ? LIST_NODE_BLOCK_MIN : count;
+			count = count > LIST_NODE_BLOCK_MAX ? LIST_NODE_BLOCK_MAX : count;
+		}
+
+		if (!List_AllocateNodeBlock(list, count))
+		{
+			return (NULL);
+		}
+	}
+
+	ListNode node = list->freeNode;
+	list->freeNode = node->next;
+	list->freeCount--;
+
+	node->data = NULL;
+	node->next = NULL;
+	return (node);
+}
+
+static void List_ReleaseNode(List list, ListNode node)
+{
+	node->data = NULL;
+	node->next = list->freeNode;
+	list->freeNode = node;
+	list->freeCount++;
+}
+
 bool List_Initialize(List* ppList)
+{
+	return List_InitializeWithFlags(ppList, LIST_FLAG_NONE);
+}
+
+bool List_InitializeWithFlags(List* ppList, uint32_t flags)
 {
 	if (ppList == NULL)
 	{
@@ -17,6 +339,25 @@ bool List_Initialize(List* ppList)
 		return (false);
 	}
 
+	if (flags & LIST_FLAG_VALUE_INDEX)
+	{
+		list->valueIndex = engine_new_zero(SListIndex, 1, MEM_TAG_ENGINE);
+		if (list->valueIndex == NULL)
+		{
+			List_Destroy(ppList);
+			return (false);
+		}
+
+		list->valueIndex->entries = engine_new_count_zero(SListIndexEntry, LIST_INDEX_INITIAL_CAPACITY, MEM_TAG_ENGINE);
+		if (list->valueIndex->entries == NULL)
+		{
+			List_Destroy(ppList);
+			return (false);
+		}
+
+		list->valueIndex->capacity = LIST_INDEX_INITIAL_CAPACITY;
+	}
+
 	return (true);
 }
 
@@ -31,6 +372,20 @@ void List_Destroy(List* ppList)
 
 	List_Clear(list);
 
+	if (list->valueIndex != NULL)
+	{
+		engine_free(list->valueIndex->entries);
+		engine_delete(list->valueIndex);
+	}
+
+	SListNodeBlock* block = list->nodeBlocks;
+	while (block != NULL)
+	{
+		SListNodeBlock* next = block->next;
+		engine_free(block);
+		block = next;
+	}
+
 	engine_delete(list);
 
 	*ppList = NULL;
@@ -43,28 +398,39 @@ void List_Clear(List list)
 		return;
 	}
 
-	ListNode curr = list->rootNode;
-	while(curr != NULL)
+	// The whole chain goes back to the freelist in one splice, nothing is freed
+	if (list->rootNode != NULL)
 	{
-		ListNode next = curr->next;
-		engine_free(curr);
-		curr = next;
+		list->tailNode->next = list->freeNode;
+		list->freeNode = list->rootNode;
+		list->freeCount += list->elementsCount;
 	}
 
 	list->rootNode = NULL;
 	list->tailNode = NULL;
 	list->elementsCount = 0;
+
+	if (list->valueIndex != NULL && list->valueIndex->entries != NULL)
+	{
+		ListIndex_Reset(list->valueIndex);
+	}
 }
 
 bool List_Insert(List list, void* value)
 {
-	ListNode newNode = engine_new_zero(SListNode, 1, MEM_TAG_ENGINE);
+	ListNode newNode = List_AllocateNode(list);
 	if (newNode == NULL)
 	{
 		return (false);
 	}
 
 	newNode->data = value;
+	if (list->valueIndex != NULL && !ListIndex_Add(list->valueIndex, value, list->tailNode))
+	{
+		List_ReleaseNode(list, newNode);
+		return (false);
+	}
+
 	if (list->rootNode == NULL)
 	{
 		list->rootNode = newNode;
@@ -82,13 +448,25 @@ bool List_Insert(List list, void* value)
 
 bool List_InsertStart(List list, void* value)
 {
-	ListNode newNode = engine_new_zero(SListNode, 1, MEM_TAG_ENGINE);
+	ListNode newNode = List_AllocateNode(list);
 	if (newNode == NULL)
 	{
 		return (false);
 	}
 
 	newNode->data = value;
+	if (list->valueIndex != NULL)
+	{
+		// Relink the old root first, it might hold the same value as the new node
+		ListIndex_Relink(list->valueIndex, list->rootNode, NULL, newNode);
+		if (!ListIndex_Add(list->valueIndex, value, NULL))
+		{
+			ListIndex_Relink(list->valueIndex, list->rootNode, newNode, NULL);
+			List_ReleaseNode(list, newNode);
+			return (false);
+		}
+	}
+
 	newNode->next = list->rootNode;
 	list->rootNode = newNode;
 
@@ -119,7 +497,7 @@ bool List_InsertAt(List list, void* value, int index)
 		return List_Insert(list, value);
 	}
 
-	ListNode newNode = engine_new_zero(SListNode, 1, MEM_TAG_ENGINE);
+	ListNode newNode = List_AllocateNode(list);
 	if (newNode == NULL)
 	{
 		return (false);
@@ -135,6 +513,17 @@ bool List_InsertAt(List list, void* value, int index)
 		prev = prev->next;
 	}
 
+	if (list->valueIndex != NULL)
+	{
+		ListIndex_Relink(list->valueIndex, prev->next, prev, newNode);
+		if (!ListIndex_Add(list->valueIndex, value, prev))
+		{
+			ListIndex_Relink(list->valueIndex, prev->next, newNode, prev);
+			List_ReleaseNode(list, newNode);
+			return (false);
+		}
+	}
+
 	newNode->next = prev->next;
 	prev->next = newNode;
 
@@ -142,20 +531,51 @@ bool List_InsertAt(List list, void* value, int index)
 	return (true);
 }
 
-ListNode List_FindNode(List list, void* value)
+bool List_InsertRange(List list, void** values, size_t count)
 {
-	ListNode curr = list->rootNode;
-	while (curr != NULL)
+	if (list == NULL || (values == NULL && count > 0))
 	{
-		if (value == curr->data)
-		{
-			return (curr);
-		}
+		return (false);
+	}
 
-		curr = curr->next;
+	if (!List_Reserve(list, count))
+	{
+		return (false);
 	}
 
-	return (NULL);
+	// Nodes and index slots are reserved, nothing below can fail half way
+	for (size_t i = 0; i < count; i++)
+	{
+		List_Insert(list, values[i]);
+	}
+
+	return (true);
+}
+
+bool List_Reserve(List list, size_t count)
+{
+	if (list == NULL)
+	{
+		return (false);
+	}
+
+	if (list->valueIndex != NULL && !ListIndex_Reserve(list->valueIndex, count))
+	{
+		return (false);
+	}
+
+	if (list->freeCount >= count)
+	{
+		return (true);
+	}
+
+	return List_AllocateNodeBlock(list, count - list->freeCount);
+}
+
+ListNode List_FindNode(List list, void* value)
+{
+	ListNode prev;
+	return List_FindWithPrev(list, value, &prev);
 }
 
 void* List_Find(List list, int index)
@@ -206,6 +626,12 @@ bool List_RemoveIndex(List list, int index)
 		curr = curr->next;
 	}
 
+	if (list->valueIndex != NULL)
+	{
+		ListIndex_Erase(list->valueIndex, curr->data, prev);
+		ListIndex_Relink(list->valueIndex, curr->next, curr, prev);
+	}
+
 	if (prev == NULL)
 	{
 		list->rootNode = curr->next;
@@ -220,25 +646,15 @@ bool List_RemoveIndex(List list, int index)
 		list->tailNode = prev;
 	}
 
-	engine_delete(curr);
+	List_ReleaseNode(list, curr);
 	list->elementsCount--;
 	return (true);
 }
 
 bool List_Remove(List list, void* value)
 {
-	ListNode curr = NULL;
 	ListNode prev = NULL;
-
-	for (curr = list->rootNode; curr != NULL; curr = curr->next)
-	{
-		if (curr->data == value) // found
-		{
-			break;
-		}
-
-		prev = curr;
-	}
+	ListNode curr = List_FindWithPrev(list, value, &prev);
 
 	if (curr == NULL)
 	{
@@ -246,6 +662,12 @@ bool List_Remove(List list, void* value)
 		return (false);
 	}
 
+	if (list->valueIndex != NULL)
+	{
+		ListIndex_Erase(list->valueIndex, curr->data, prev);
+		ListIndex_Relink(list->valueIndex, curr->next, curr, prev);
+	}
+
 	if (prev == NULL)
 	{
 		list->rootNode = curr->next;
@@ -260,7 +682,7 @@ bool List_Remove(List list, void* value)
 		list->tailNode = prev;
 	}
 
-	engine_delete(curr);
+	List_ReleaseNode(list, curr);
 	list->elementsCount--;
 	return (true);
 }
@@ -283,6 +705,81 @@ void List_ForEach(List list, fnFunc function, void* context)
 	}
 }
 
+typedef struct SListChunk
+{
+	ListNode firstNode;
+	size_t count;
+	fnFunc function;
+	void* context;
+} SListChunk;
+
+static void List_RunChunk(void* data)
+{
+	SListChunk* chunk = (SListChunk*)data;
+
+	ListNode curr = chunk->firstNode;
+	for (size_t i = 0; i < chunk->count; i++)
+	{
+		chunk->function(curr->data, chunk->context);
+		curr = curr->next;
+	}
+}
+
+void List_ParallelForEach(List list, ThreadPool pool, fnFunc function, void* context, size_t grainSize)
+{
+	if (list == NULL || function == NULL)
+	{
+		return;
+	}
+
+	if (grainSize == 0)
+	{
+		grainSize = 1;
+	}
+
+	// Nothing to split, skip the pool overhead
+	if (pool == NULL || list->elementsCount <= grainSize)
+	{
+		List_ForEach(list, function, context);
+		return;
+	}
+
+	size_t chunksCount = (list->elementsCount + grainSize - 1) / grainSize;
+	SListChunk* chunks = engine_new_count_zero(SListChunk, chunksCount, MEM_TAG_ENGINE);
+	if (chunks == NULL)
+	{
+		List_ForEach(list, function, context);
+		return;
+	}
+
+	// One walk to find where each chunk starts, the workers only walk their own range
+	ListNode curr = list->rootNode;
+	for (size_t i = 0; i < chunksCount; i++)
+	{
+		size_t remaining = list->elementsCount - i * grainSize;
+
+		chunks[i].firstNode = curr;
+		chunks[i].count = remaining < grainSize ? remaining : grainSize;
+		chunks[i].function = function;
+		chunks[i].context = context;
+
+		for (size_t j = 0; j < chunks[i].count; j++)
+		{
+			curr = curr->next;
+		}
+	}
+
+	STaskCounter counter = { 0 };
+	for (size_t i = 0; i < chunksCount; i++)
+	{
+		ThreadPool_Submit(pool, List_RunChunk, &chunks[i], &counter);
+	}
+
+	ThreadPool_Wait(pool, &counter);
+
+	engine_free(chunks);
+}
+
 void List_BubbleSort(List list, fnCompare compareFunc)
 {
 	if (list == NULL || compareFunc == NULL)
@@ -316,6 +813,8 @@ void List_BubbleSort(List list, fnCompare compareFunc)
 			curr = curr->next;
 		}
 	} while (swapped == true);
+
+	ListIndex_Rebuild(list);
 }
 
 ListNode List_SortedMerge(ListNode a, ListNode b, fnCompare compareFunc)
@@ -416,6 +915,8 @@ void List_MergeSort(List list, fnCompare compareFunc)
 	}
 
 	list->tailNode = curr;
+
+	ListIndex_Rebuild(list);
 }
 
 void List_Sort(List list, fnCompare compareFunc, bool isMerged)
@@ -425,6 +926,8 @@ void List_Sort(List list, fnCompare compareFunc, bool isMerged)
 		return;
 	}
 
+	PROFILE_ZONE_BEGIN(List_Sort);
+
 	if (isMerged)
 	{
 		List_MergeSort(list, compareFunc);
@@ -433,6 +936,8 @@ void List_Sort(List list, fnCompare compareFunc, bool isMerged)
 	{
 		List_BubbleSort(list, compareFunc);
 	}
+
+	PROFILE_ZONE_END(List_Sort);
 }
 
 void List_Print(List list)
@@ -2,7 +2,9 @@
 #define __LIST_H__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "../Threading/ThreadPool.h"
 
 typedef void(*fnFunc)(void* data, void* context);
 // Returns 1 if a > b, 0 if equal, -1 if a < b
@@ -16,23 +18,48 @@ typedef struct SListNode
 
 typedef struct SListNode* ListNode;
 
+typedef enum EListFlags
+{
+	LIST_FLAG_NONE = 0,
+	LIST_FLAG_VALUE_INDEX = 1 << 0, // Keep a value -> node hash index, List_FindNode/List_Remove become O(1) for unique values
+} EListFlags;
+
+// Nodes are carved out of contiguous blocks owned by the list
+typedef struct SListNodeBlock
+{
+	struct SListNodeBlock* next;
+	size_t nodesCount;
+	SListNode nodes[];
+} SListNodeBlock;
+
 typedef struct SList
 {
 	ListNode rootNode; // First Element
 	ListNode tailNode; // Last Element
 	size_t elementsCount;
+	struct SListIndex* valueIndex; // NULL unless created with LIST_FLAG_VALUE_INDEX
+
+	ListNode freeNode; // Recycled nodes, chained through 'next'
+	size_t freeCount;
+	SListNodeBlock* nodeBlocks; // Newest block first, released on List_Destroy
 } SList;
 
 typedef struct SList* List;
 
 bool List_Initialize(List* ppList);
+bool List_InitializeWithFlags(List* ppList, uint32_t flags);
 void List_Destroy(List* ppList);
 void List_Clear(List list);
 
 bool List_Insert(List list, void* value);
 bool List_InsertStart(List list, void* value);
 bool List_InsertAt(List list, void* value, int index);
+// Append 'count' values, needs at most one node block allocation. On failure nothing is appended.
+bool List_InsertRange(List list, void** values, size_t count);
+// Make sure the next 'count' inserts do not touch the allocator
+bool List_Reserve(List list, size_t count);
 
+// List_FindNode and List_Remove act on the first node holding 'value', with or without LIST_FLAG_VALUE_INDEX
 ListNode List_FindNode(List list, void* value);
 void* List_Find(List list, int index);
 void* List_Get(List list, int index);
@@ -41,6 +68,9 @@ bool List_RemoveIndex(List list, int index);
 bool List_Remove(List list, void* value);
 
 void List_ForEach(List list, fnFunc function, void* context);
+// Splits the list in chunks of 'grainSize' elements and runs them on the pool, returns once every chunk is done.
+// The callback runs concurrently: it must not modify the list and must be safe to call from any thread.
+void List_ParallelForEach(List list, ThreadPool pool, fnFunc function, void* context, size_t grainSize);
 
 // Sort the List
 void List_BubbleSort(List list, fnCompare compareFunc);
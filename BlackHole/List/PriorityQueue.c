@@ -0,0 +1,277 @@
+#include "PriorityQueue.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#define PRIORITY_QUEUE_INITIAL_CAPACITY 16
+
+static bool PriorityQueue_Resize(PriorityQueue queue, uint32_t capacity)
+{
+	SPriorityQueueEntry* entries = engine_realloc_array(queue->entries, SPriorityQueueEntry, capacity);
+	if (entries == NULL)
+	{
+		return (false);
+	}
+
+	queue->entries = entries;
+	queue->capacity = capacity;
+	return (true);
+}
+
+static uint32_t PriorityQueue_FindSlot(PriorityQueue queue, PriorityQueueHandle handle)
+{
+	return ((queue != NULL) ? HandleTable_Find(&queue->handles, handle) : HANDLE_TABLE_NO_SLOT);
+}
+
+static void PriorityQueue_Place(PriorityQueue queue, uint32_t position, SPriorityQueueEntry entry)
+{
+	queue->entries[position] = entry;
+	queue->handles.slots[entry.slot].value = position;
+}
+
+// Moves the entry at 'position' up while it compares lower than its parent.
+// The entry is held aside and parents slide down into the hole, one write per level.
+static uint32_t PriorityQueue_SiftUp(PriorityQueue queue, uint32_t position)
+{
+	SPriorityQueueEntry entry = queue->entries[position];
+
+	while (position > 0)
+	{
+		uint32_t parent = (position - 1) / queue->arity;
+		if (queue->compareFunc(entry.value, queue->entries[parent].value) >= 0)
+		{
+			break;
+		}
+
+		PriorityQueue_Place(queue, position, queue->entries[parent]);
+		position = parent;
+	}
+
+	PriorityQueue_Place(queue, position, entry);
+	return (position);
+}
+
+static void PriorityQueue_SiftDown(PriorityQueue queue, uint32_t position)
+{
+	SPriorityQueueEntry entry = queue->entries[position];
+
+	for (;;)
+	{
+		uint64_t firstChild = (uint64_t)position * queue->arity + 1;
+		if (firstChild >= queue->count)
+		{
+			break;
+		}
+
+		uint32_t lastChild = (firstChild + queue->arity < queue->count) ? (uint32_t)firstChild + queue->arity : queue->count;
+		uint32_t best = (uint32_t)firstChild;
+		for (uint32_t child = best + 1; child < lastChild; child++)
+		{
+			if (queue->compareFunc(queue->entries[child].value, queue->entries[best].value) < 0)
+			{
+				best = child;
+			}
+		}
+
+		if (queue->compareFunc(queue->entries[best].value, entry.value) >= 0)
+		{
+			break;
+		}
+
+		PriorityQueue_Place(queue, position, queue->entries[best]);
+		position = best;
+	}
+
+	PriorityQueue_Place(queue, position, entry);
+}
+
+// Takes the entry at 'position' out and fills the hole with the last one
+static void* PriorityQueue_RemoveAt(PriorityQueue queue, uint32_t position)
+{
+	SPriorityQueueEntry removed = queue->entries[position];
+	queue->count--;
+
+	if (position < queue->count)
+	{
+		PriorityQueue_Place(queue, position, queue->entries[queue->count]);
+
+		// The last entry may belong above or below the hole
+		if (PriorityQueue_SiftUp(queue, position) == position)
+		{
+			PriorityQueue_SiftDown(queue, position);
+		}
+	}
+
+	HandleTable_Release(&queue->handles, removed.slot);
+	return (removed.value);
+}
+
+bool PriorityQueue_Initialize(PriorityQueue* ppQueue, fnCompare compareFunc, uint32_t arity, EMemoryTag tag)
+{
+	if (ppQueue == NULL || compareFunc == NULL || arity == 1 || arity > PRIORITY_QUEUE_MAX_ARITY)
+	{
+		return (false);
+	}
+
+	*ppQueue = engine_new_zero(SPriorityQueue, 1, tag);
+	PriorityQueue queue = *ppQueue;
+
+	if (queue == NULL)
+	{
+		syserr("Failed to Allocate Memory for PriorityQueue");
+		return (false);
+	}
+
+	queue->arity = (arity == 0) ? PRIORITY_QUEUE_DEFAULT_ARITY : arity;
+	queue->compareFunc = compareFunc;
+
+	// realloc keeps the tag of the first block
+	queue->entries = engine_new_count_zero(SPriorityQueueEntry, PRIORITY_QUEUE_INITIAL_CAPACITY, tag);
+	if (queue->entries == NULL || !HandleTable_Initialize(&queue->handles, tag))
+	{
+		syserr("Failed to Allocate Memory for PriorityQueue entries");
+		PriorityQueue_Destroy(ppQueue);
+		return (false);
+	}
+
+	queue->capacity = PRIORITY_QUEUE_INITIAL_CAPACITY;
+	return (true);
+}
+
+void PriorityQueue_Destroy(PriorityQueue* ppQueue)
+{
+	if (ppQueue == NULL || *ppQueue == NULL)
+	{
+		return;
+	}
+
+	HandleTable_Destroy(&(*ppQueue)->handles);
+	engine_free((*ppQueue)->entries);
+	engine_delete(*ppQueue);
+	*ppQueue = NULL;
+}
+
+void PriorityQueue_Clear(PriorityQueue queue)
+{
+	if (queue == NULL)
+	{
+		return;
+	}
+
+	HandleTable_Clear(&queue->handles);
+	queue->count = 0;
+}
+
+bool PriorityQueue_Reserve(PriorityQueue queue, uint32_t count)
+{
+	if (queue == NULL || count > HANDLE_TABLE_MAX_SLOTS)
+	{
+		return (false);
+	}
+
+	if (count > queue->capacity && !PriorityQueue_Resize(queue, count))
+	{
+		return (false);
+	}
+
+	return HandleTable_Reserve(&queue->handles, count);
+}
+
+PriorityQueueHandle PriorityQueue_Push(PriorityQueue queue, void* value)
+{
+	if (queue == NULL)
+	{
+		return (PRIORITY_QUEUE_HANDLE_INVALID);
+	}
+
+	if (queue->count == queue->capacity)
+	{
+		if (queue->capacity >= HANDLE_TABLE_MAX_SLOTS || !PriorityQueue_Resize(queue, queue->capacity * 2))
+		{
+			syserr("PriorityQueue: out of memory at %u values", queue->count);
+			return (PRIORITY_QUEUE_HANDLE_INVALID);
+		}
+	}
+
+	uint32_t slot = HandleTable_Acquire(&queue->handles, queue->count);
+	if (slot == HANDLE_TABLE_NO_SLOT)
+	{
+		return (PRIORITY_QUEUE_HANDLE_INVALID);
+	}
+
+	SPriorityQueueEntry entry = { value, slot };
+	PriorityQueue_Place(queue, queue->count, entry);
+	queue->count++;
+
+	PriorityQueue_SiftUp(queue, queue->count - 1);
+	return (HandleTable_GetHandle(&queue->handles, slot));
+}
+
+void* PriorityQueue_Peek(PriorityQueue queue)
+{
+	if (queue == NULL || queue->count == 0)
+	{
+		return (NULL);
+	}
+
+	return (queue->entries[0].value);
+}
+
+void* PriorityQueue_Pop(PriorityQueue queue)
+{
+	if (queue == NULL || queue->count == 0)
+	{
+		return (NULL);
+	}
+
+	return PriorityQueue_RemoveAt(queue, 0);
+}
+
+bool PriorityQueue_DecreaseKey(PriorityQueue queue, PriorityQueueHandle handle)
+{
+	uint32_t slot = PriorityQueue_FindSlot(queue, handle);
+	if (slot == HANDLE_TABLE_NO_SLOT)
+	{
+		return (false);
+	}
+
+	PriorityQueue_SiftUp(queue, queue->handles.slots[slot].value);
+	return (true);
+}
+
+bool PriorityQueue_Update(PriorityQueue queue, PriorityQueueHandle handle)
+{
+	uint32_t slot = PriorityQueue_FindSlot(queue, handle);
+	if (slot == HANDLE_TABLE_NO_SLOT)
+	{
+		return (false);
+	}
+
+	uint32_t position = queue->handles.slots[slot].value;
+	if (PriorityQueue_SiftUp(queue, position) == position)
+	{
+		PriorityQueue_SiftDown(queue, position);
+	}
+
+	return (true);
+}
+
+void* PriorityQueue_Remove(PriorityQueue queue, PriorityQueueHandle handle)
+{
+	uint32_t slot = PriorityQueue_FindSlot(queue, handle);
+	if (slot == HANDLE_TABLE_NO_SLOT)
+	{
+		return (NULL);
+	}
+
+	return PriorityQueue_RemoveAt(queue, queue->handles.slots[slot].value);
+}
+
+bool PriorityQueue_Contains(PriorityQueue queue, PriorityQueueHandle handle)
+{
+	return (PriorityQueue_FindSlot(queue, handle) != HANDLE_TABLE_NO_SLOT);
+}
+
+uint32_t PriorityQueue_GetCount(PriorityQueue queue)
+{
+	return ((queue != NULL) ? queue->count : 0);
+}
@@ -0,0 +1,58 @@
+#ifndef __PRIORITY_QUEUE_H__
+#define __PRIORITY_QUEUE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "List.h"
+#include "../MemoryManager/MemoryTags.h"
+#include "../Map/HandleTable.h"
+
+#define PRIORITY_QUEUE_DEFAULT_ARITY 4 // Shallower than binary, the children of a node share a cache line
+#define PRIORITY_QUEUE_MAX_ARITY 16
+
+typedef GenerationalHandle PriorityQueueHandle;
+
+#define PRIORITY_QUEUE_HANDLE_INVALID GENERATIONAL_HANDLE_INVALID
+
+typedef struct SPriorityQueueEntry
+{
+	void* value;
+	uint32_t slot; // Handle slot, updated with the entry's position whenever it moves
+} SPriorityQueueEntry;
+
+// Array backed d-ary min heap: Peek returns the value that compares lowest
+typedef struct SPriorityQueue
+{
+	SPriorityQueueEntry* entries;
+	SHandleTable handles; // Slot value: position in the heap
+	uint32_t count;
+	uint32_t capacity;
+	uint32_t arity;
+	fnCompare compareFunc;
+} SPriorityQueue;
+
+typedef struct SPriorityQueue* PriorityQueue;
+
+// arity = 0 uses PRIORITY_QUEUE_DEFAULT_ARITY. Pass a reversed compare for a max heap.
+bool PriorityQueue_Initialize(PriorityQueue* ppQueue, fnCompare compareFunc, uint32_t arity, EMemoryTag tag);
+void PriorityQueue_Destroy(PriorityQueue* ppQueue);
+void PriorityQueue_Clear(PriorityQueue queue);
+bool PriorityQueue_Reserve(PriorityQueue queue, uint32_t count);
+
+// O(log n). The handle stays valid until the value is popped or removed.
+PriorityQueueHandle PriorityQueue_Push(PriorityQueue queue, void* value);
+void* PriorityQueue_Peek(PriorityQueue queue);
+void* PriorityQueue_Pop(PriorityQueue queue);
+
+// Call after lowering the key inside the queued value, only moves it towards the top
+bool PriorityQueue_DecreaseKey(PriorityQueue queue, PriorityQueueHandle handle);
+// Call after changing the key either way
+bool PriorityQueue_Update(PriorityQueue queue, PriorityQueueHandle handle);
+// Returns the removed value, NULL for a stale handle
+void* PriorityQueue_Remove(PriorityQueue queue, PriorityQueueHandle handle);
+
+bool PriorityQueue_Contains(PriorityQueue queue, PriorityQueueHandle handle);
+uint32_t PriorityQueue_GetCount(PriorityQueue queue);
+
+#endif // __PRIORITY_QUEUE_H__
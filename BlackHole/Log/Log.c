@@ -0,0 +1,909 @@
+#include "Log.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../Threading/Atomic.h"
+#include "../Threading/Thread.h"
+
+#define LOG_RECORD_ALIGNMENT 16
+#define LOG_RECORD_PADDING 0xFFFFu // Filler up to the ring end when a record would wrap
+#define LOG_LINE_SIZE 4096 // Longer lines are truncated
+#define LOG_OUTPUT_SIZE 65536 // Per stream, written with one fwrite
+#define LOG_SPEC_FORMAT_SIZE 32 // Longest conversion the writer can replay
+
+typedef enum ELogRingState
+{
+	LOG_RING_FREE = 0,
+	LOG_RING_OWNED,
+	LOG_RING_RELEASED, // The owner left, the writer frees it once drained
+} ELogRingState;
+
+typedef enum ELogArgType
+{
+	LOG_ARG_NONE = 0, // %% or a conversion we print as text
+	LOG_ARG_INT,
+	LOG_ARG_LONG,
+	LOG_ARG_LONG_LONG,
+	LOG_ARG_SIZE,
+	LOG_ARG_PTRDIFF,
+	LOG_ARG_INTMAX,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_LONG_DOUBLE,
+	LOG_ARG_POINTER,
+	LOG_ARG_STRING,
+	LOG_ARG_COUNT_POINTER, // %n, consumed but never written
+	LOG_ARG_WIDE, // %ls, %lc, %S, %C: pointer or wint_t, not copied
+	LOG_ARG_UNKNOWN, // Conversion we cannot classify, its argument size is unknown
+} ELogArgType;
+
+// One printf conversion
+typedef struct SLogSpec
+{
+	size_t length; // From the '%' to the conversion character included
+	int starsCount; // '*' width and precision, each one an int argument before the value
+	int precision; // Literal precision, -1 if none
+	bool isPrecisionStar;
+	ELogArgType type;
+} SLogSpec;
+
+typedef struct SLogRecord
+{
+	uint32_t size; // Header included, multiple of LOG_RECORD_ALIGNMENT
+	uint32_t level; // ELogLevel, or LOG_RECORD_PADDING
+	const char* format;
+	// Arguments follow in 8 byte slots, strings as length + bytes
+} SLogRecord;
+
+// Single producer, single consumer: the owning thread writes, the writer thread reads
+typedef struct SLogRing
+{
+	volatile int64_t writeIndex;
+	char writePadding[64 - sizeof(int64_t)];
+	volatile int64_t readIndex;
+	char readPadding[64 - sizeof(int64_t)];
+	volatile int32_t state; // ELogRingState
+	uint8_t data[LOG_RING_SIZE];
+} SLogRing;
+
+typedef struct SLogOutput
+{
+	FILE* stream;
+	size_t size;
+	char buffer[LOG_OUTPUT_SIZE];
+} SLogOutput;
+
+typedef struct SLogger
+{
+	SLogRing* volatile rings[LOG_MAX_THREADS];
+	SLogRing* sharedRing; // Threads past LOG_MAX_THREADS push here under sharedLock
+	Mutex sharedLock;
+
+	ThreadHandle writer;
+	Mutex wakeLock;
+	ConditionVariable wakeCondition;
+	ConditionVariable flushCondition;
+	volatile int32_t isWriterSleeping;
+	volatile int32_t isRunning;
+	volatile int32_t activeCalls; // Callers past the isRunning check, Destroy waits for them
+	volatile int32_t isShuttingDown;
+	volatile int32_t generation; // Bumped by Initialize/Destroy so threads drop their stale ring
+	volatile int32_t minLevel;
+
+	volatile int64_t flushRequested;
+	volatile int64_t flushCompleted;
+
+	// Writer thread only
+	SLogOutput outputs[2]; // stdout, stderr
+} SLogger;
+
+static SLogger s_logger = { 0 };
+static THREAD_LOCAL SLogRing* s_logRing = NULL;
+static THREAD_LOCAL int32_t s_logGeneration = 0;
+
+static size_t Log_Align(size_t size, size_t alignment)
+{
+	return ((size + alignment - 1) & ~(alignment - 1));
+}
+
+// 'format' points at the '%'
+static void Log_ParseSpec(const char* format, SLogSpec* spec)
+{
+	const char* p = format + 1;
+	spec->starsCount = 0;
+	spec->precision = -1;
+	spec->isPrecisionStar = false;
+	spec->type = LOG_ARG_NONE;
+
+	if (*p == '%')
+	{
+		spec->length = 2;
+		return;
+	}
+
+	while (*p != '\0' && strchr("-+ #0'", *p) != NULL)
+	{
+		p++;
+	}
+
+	if (*p == '*')
+	{
+		spec->starsCount++;
+		p++;
+	}
+
+	while (*p >= '0' && *p <= '9')
+	{
+		p++;
+	}
+
+	if (*p == '.')
+	{
+		p++;
+		if (*p == '*')
+		{
+			spec->starsCount++;
+			spec->isPrecisionStar = true;
+			p++;
+		}
+		else
+		{
+			spec->precision = 0;
+			while (*p >= '0' && *p <= '9')
+			{
+				spec->precision = spec->precision * 10 + (*p - '0');
+				p++;
+			}
+		}
+	}
+
+	char modifier = '\0';
+	bool isDoubled = false;
+	if (*p == 'h' || *p == 'l' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L')
+	{
+		modifier = *p++;
+		if ((modifier == 'h' || modifier == 'l') && *p == modifier)
+		{
+			isDoubled = true;
+			p++;
+		}
+	}
+
+	if (*p == '\0')
+	{
+		// Unfinished conversion, printed as text
+		spec->length = (size_t)(p - format);
+		spec->starsCount = 0;
+		return;
+	}
+
+	switch (*p)
+	{
+	case 'c':
+		spec->type = (modifier == 'l') ? LOG_ARG_WIDE : LOG_ARG_INT;
+		break;
+	case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+		if (modifier == 'l')
+		{
+			spec->type = isDoubled ? LOG_ARG_LONG_LONG : LOG_ARG_LONG;
+		}
+		else if (modifier == 'z')
+		{
+			spec->type = LOG_ARG_SIZE;
+		}
+		else if (modifier == 't')
+		{
+			spec->type = LOG_ARG_PTRDIFF;
+		}
+		else if (modifier == 'j')
+		{
+			spec->type = LOG_ARG_INTMAX;
+		}
+		else
+		{
+			spec->type = LOG_ARG_INT; // char and short are promoted
+		}
+		break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		spec->type = (modifier == 'L') ? LOG_ARG_LONG_DOUBLE : LOG_ARG_DOUBLE;
+		break;
+	case 'p':
+		spec->type = LOG_ARG_POINTER;
+		break;
+	case 's':
+		spec->type = (modifier == 'l') ? LOG_ARG_WIDE : LOG_ARG_STRING;
+		break;
+	case 'S': case 'C':
+		spec->type = LOG_ARG_WIDE;
+		break;
+	case 'n':
+		spec->type = LOG_ARG_COUNT_POINTER;
+		break;
+	default:
+		spec->type = LOG_ARG_UNKNOWN;
+		break;
+	}
+
+	spec->length = (size_t)(p + 1 - format);
+}
+
+// Once one argument did not fit, the following ones are dropped too so the reader stays in sync
+static void Log_Store(uint8_t* record, size_t* pSize, bool* pIsFull, const void* value, size_t valueSize, size_t slotSize)
+{
+	if (*pIsFull || *pSize + slotSize > LOG_MAX_RECORD_SIZE)
+	{
+		*pIsFull = true;
+		return;
+	}
+
+	memcpy(record + *pSize, value, valueSize);
+	*pSize += slotSize;
+}
+
+static void Log_StoreString(uint8_t* record, size_t* pSize, bool* pIsFull, const char* string, int precision)
+{
+	size_t length = 0;
+	while (string[length] != '\0' && (precision < 0 || length < (size_t)precision))
+	{
+		length++;
+	}
+
+	// Length, bytes and the terminator, truncated to what is left
+	size_t available = (*pSize + sizeof(uint32_t) + 1 < LOG_MAX_RECORD_SIZE) ? LOG_MAX_RECORD_SIZE - *pSize - sizeof(uint32_t) - 1 : 0;
+	if (*pIsFull || available == 0)
+	{
+		*pIsFull = true;
+		return;
+	}
+
+	if (length > available)
+	{
+		length = available;
+	}
+
+	uint32_t storedLength = (uint32_t)length;
+	memcpy(record + *pSize, &storedLength, sizeof(uint32_t));
+	memcpy(record + *pSize + sizeof(uint32_t), string, length);
+	record[*pSize + sizeof(uint32_t) + length] = '\0';
+
+	size_t slotSize = Log_Align(sizeof(uint32_t) + length + 1, sizeof(uint64_t));
+	*pSize = (*pSize + slotSize < LOG_MAX_RECORD_SIZE) ? *pSize + slotSize : LOG_MAX_RECORD_SIZE;
+}
+
+static size_t Log_EncodeHeader(uint8_t* record, size_t size, ELogLevel level, const char* format)
+{
+	size = Log_Align(size, LOG_RECORD_ALIGNMENT);
+
+	SLogRecord header;
+	header.size = (uint32_t)size;
+	header.level = (uint32_t)level;
+	header.format = format;
+	memcpy(record, &header, sizeof(SLogRecord));
+
+	return (size);
+}
+
+// Copies the arguments, the text is built later by the writer.
+// Returns 0 when a conversion cannot be replayed later, the caller then formats it right away.
+static size_t Log_Encode(uint8_t* record, ELogLevel level, const char* format, va_list args)
+{
+	size_t size = sizeof(SLogRecord);
+	bool isFull = false;
+
+	for (const char* p = format; *p != '\0'; )
+	{
+		if (*p != '%')
+		{
+			p++;
+			continue;
+		}
+
+		SLogSpec spec;
+		Log_ParseSpec(p, &spec);
+		p += spec.length;
+
+		// Skipping its argument would shift every following one
+		if (spec.type == LOG_ARG_WIDE || spec.type == LOG_ARG_UNKNOWN || spec.length >= LOG_SPEC_FORMAT_SIZE)
+		{
+			return (0);
+		}
+
+		int stars[2] = { 0, 0 };
+		for (int i = 0; i < spec.starsCount; i++)
+		{
+			stars[i] = va_arg(args, int);
+			Log_Store(record, &size, &isFull, &stars[i], sizeof(int), sizeof(uint64_t));
+		}
+
+		switch (spec.type)
+		{
+		case LOG_ARG_INT: { int value = va_arg(args, int); Log_Store(record, &size, &isFull, &value, sizeof(value), sizeof(uint64_t)); break; }
+		case LOG_ARG_LONG: { long value = va_arg(args, long); Log_Store(record, &size, &isFull, &value, sizeof(value), sizeof(uint64_t)); break; }
+		case LOG_ARG_LONG_LONG: { long long value = va_arg(args, long long); Log_Store(record, &size, &isFull, &value, sizeof(value), sizeof(uint64_t)); break; }
+		case LOG_ARG_SIZE: { size_t value = va_arg(args, size_t); Log_Store(record, &size, &isFull, &value, sizeof(value), sizeof(uint64_t)); break; }
+		case LOG_ARG_PTRDIFF: { ptrdiff_t value = va_arg(args, ptrdiff_t); Log_Store(record, &size, &isFull, &value, sizeof(value), sizeof(uint64_t)); break; }
+		case LOG_ARG_INTMAX: { intmax_t value = va_arg(args, intmax_t); Log_Store(record, &size, &isFull, &value, sizeof(value), sizeof(uint64_t)); break; }
+		case LOG_ARG_DOUBLE: { double value = va_arg(args, double); Log_Store(record, &size, &isFull, &value, sizeof(value), sizeof(uint64_t)); break; }
+		case LOG_ARG_LONG_DOUBLE: { long double value = va_arg(args, long double); Log_Store(record, &size, &isFull, &value, sizeof(value), Log_Align(sizeof(value), sizeof(uint64_t))); break; }
+		case LOG_ARG_POINTER: { void* value = va_arg(args, void*); Log_Store(record, &size, &isFull, &value, sizeof(value), sizeof(uint64_t)); break; }
+		case LOG_ARG_COUNT_POINTER: { (void)va_arg(args, void*); break; }
+		case LOG_ARG_STRING:
+		{
+			const char* value = va_arg(args, const char*);
+			int precision = spec.isPrecisionStar ? stars[spec.starsCount - 1] : spec.precision;
+			Log_StoreString(record, &size, &isFull, (value != NULL) ? value : "(null)", precision);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	return (Log_EncodeHeader(record, size, level, format));
+}
+
+// A line formatted by the caller, replayed through "%s"
+static size_t Log_EncodeText(uint8_t* record, ELogLevel level, const char* line)
+{
+	size_t size = sizeof(SLogRecord);
+	bool isFull = false;
+	Log_StoreString(record, &size, &isFull, line, -1);
+	return (Log_EncodeHeader(record, size, level, "%s"));
+}
+
+// Arguments missing from a truncated record read as zero
+static void Log_Load(const uint8_t* record, size_t recordSize, size_t* pOffset, void* value, size_t valueSize, size_t slotSize)
+{
+	if (*pOffset + slotSize > recordSize)
+	{
+		memset(value, 0, valueSize);
+		return;
+	}
+
+	memcpy(value, record + *pOffset, valueSize);
+	*pOffset += slotSize;
+}
+
+static const char* Log_LoadString(const uint8_t* record, size_t recordSize, size_t* pOffset)
+{
+	uint32_t length = 0;
+	if (*pOffset + sizeof(uint32_t) + 1 > recordSize)
+	{
+		return ("");
+	}
+
+	memcpy(&length, record + *pOffset, sizeof(uint32_t));
+	const char* string = (const char*)(record + *pOffset + sizeof(uint32_t));
+	*pOffset += Log_Align(sizeof(uint32_t) + length + 1, sizeof(uint64_t));
+	return (string);
+}
+
+#define LOG_FORMAT_VALUE(value) \
+	((spec.starsCount == 0) ? snprintf(out, available, specFormat, value) : \
+	(spec.starsCount == 1) ? snprintf(out, available, specFormat, stars[0], value) : \
+	snprintf(out, available, specFormat, stars[0], stars[1], value))
+
+// Replays the conversions of the format with the copied arguments
+static size_t Log_Decode(const uint8_t* record, char* line, size_t lineSize)
+{
+	SLogRecord header;
+	memcpy(&header, record, sizeof(SLogRecord));
+
+	size_t offset = sizeof(SLogRecord);
+	size_t length = 0;
+
+	for (const char* p = header.format; *p != '\0' && length + 1 < lineSize; )
+	{
+		if (*p != '%')
+		{
+			line[length++] = *p++;
+			continue;
+		}
+
+		SLogSpec spec;
+		Log_ParseSpec(p, &spec);
+
+		char specFormat[LOG_SPEC_FORMAT_SIZE];
+		if (spec.type == LOG_ARG_NONE || spec.type == LOG_ARG_WIDE || spec.type == LOG_ARG_UNKNOWN || spec.length >= sizeof(specFormat))
+		{
+			// %% prints one '%', anything we do not understand is copied as it is
+			const char* text = (spec.length == 2 && p[1] == '%') ? "%" : p;
+			size_t textLength = (text == p) ? spec.length : 1;
+			for (size_t i = 0; i < textLength && length + 1 < lineSize; i++)
+			{
+				line[length++] = text[i];
+			}
+
+			p += spec.length;
+			continue;
+		}
+
+		memcpy(specFormat, p, spec.length);
+		specFormat[spec.length] = '\0';
+		p += spec.length;
+
+		int stars[2] = { 0, 0 };
+		for (int i = 0; i < spec.starsCount; i++)
+		{
+			Log_Load(record, header.size, &offset, &stars[i], sizeof(int), sizeof(uint64_t));
+		}
+
+		char* out = line + length;
+		size_t available = lineSize - length;
+		int written = 0;
+
+		switch (spec.type)
+		{
+		case LOG_ARG_INT: { int value; Log_Load(record, header.size, &offset, &value, sizeof(value), sizeof(uint64_t)); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_LONG: { long value; Log_Load(record, header.size, &offset, &value, sizeof(value), sizeof(uint64_t)); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_LONG_LONG: { long long value; Log_Load(record, header.size, &offset, &value, sizeof(value), sizeof(uint64_t)); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_SIZE: { size_t value; Log_Load(record, header.size, &offset, &value, sizeof(value), sizeof(uint64_t)); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_PTRDIFF: { ptrdiff_t value; Log_Load(record, header.size, &offset, &value, sizeof(value), sizeof(uint64_t)); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_INTMAX: { intmax_t value; Log_Load(record, header.size, &offset, &value, sizeof(value), sizeof(uint64_t)); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_DOUBLE: { double value; Log_Load(record, header.size, &offset, &value, sizeof(value), sizeof(uint64_t)); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_LONG_DOUBLE: { long double value; Log_Load(record, header.size, &offset, &value, sizeof(value), Log_Align(sizeof(value), sizeof(uint64_t))); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_POINTER: { void* value; Log_Load(record, header.size, &offset, &value, sizeof(value), sizeof(uint64_t)); written = LOG_FORMAT_VALUE(value); break; }
+		case LOG_ARG_STRING: { const char* value = Log_LoadString(record, header.size, &offset); written = LOG_FORMAT_VALUE(value); break; }
+		default:
+			break;
+		}
+
+		if (written > 0)
+		{
+			length += ((size_t)written < available) ? (size_t)written : available - 1;
+		}
+	}
+
+	return (length);
+}
+
+static void Log_FlushOutput(SLogOutput* output)
+{
+	if (output->size > 0)
+	{
+		fwrite(output->buffer, 1, output->size, output->stream);
+		output->size = 0;
+	}
+
+	fflush(output->stream);
+}
+
+static void Log_Output(ELogLevel level, const char* line, size_t length)
+{
+	SLogOutput* output = &s_logger.outputs[(level >= LOG_LEVEL_WARNING) ? 1 : 0];
+	if (output->size + length + 1 > LOG_OUTPUT_SIZE)
+	{
+		fwrite(output->buffer, 1, output->size, output->stream);
+		output->size = 0;
+	}
+
+	memcpy(output->buffer + output->size, line, length);
+	output->buffer[output->size + length] = '\n';
+	output->size += length + 1;
+}
+
+// Writer thread: formats everything committed so far, returns false if the ring was empty
+static bool Log_DrainRing(SLogRing* ring)
+{
+	int64_t readIndex = ring->readIndex;
+	int64_t writeIndex = Atomic_Load64(&ring->writeIndex);
+	if (readIndex == writeIndex)
+	{
+		return (false);
+	}
+
+	char line[LOG_LINE_SIZE];
+	while (readIndex < writeIndex)
+	{
+		const uint8_t* record = &ring->data[readIndex & (LOG_RING_SIZE - 1)];
+
+		SLogRecord header;
+		memcpy(&header, record, sizeof(SLogRecord));
+
+		if (header.level != LOG_RECORD_PADDING)
+		{
+			size_t length = Log_Decode(record, line, sizeof(line));
+			Log_Output((ELogLevel)header.level, line, length);
+		}
+
+		readIndex += header.size;
+
+		// release: the producer may reuse the space once it sees the new index
+		Atomic_Store64(&ring->readIndex, readIndex);
+	}
+
+	return (true);
+}
+
+static bool Log_Drain()
+{
+	bool hasWritten = false;
+	for (int i = 0; i < LOG_MAX_THREADS; i++)
+	{
+		SLogRing* ring = (SLogRing*)Atomic_LoadPtr((void* volatile*)&s_logger.rings[i]);
+		if (ring == NULL)
+		{
+			continue;
+		}
+
+		hasWritten |= Log_DrainRing(ring);
+
+		// The owner released it after its last message, reading the state first makes that message visible
+		if (Atomic_Load32(&ring->state) == LOG_RING_RELEASED && Atomic_Load64(&ring->writeIndex) == ring->readIndex)
+		{
+			Atomic_CompareExchange32(&ring->state, LOG_RING_RELEASED, LOG_RING_FREE);
+		}
+	}
+
+	hasWritten |= Log_DrainRing(s_logger.sharedRing);
+	return (hasWritten);
+}
+
+static bool Log_HasPending()
+{
+	for (int i = 0; i < LOG_MAX_THREADS; i++)
+	{
+		SLogRing* ring = (SLogRing*)Atomic_LoadPtr((void* volatile*)&s_logger.rings[i]);
+		if (ring != NULL && Atomic_Load64(&ring->writeIndex) != ring->readIndex)
+		{
+			return (true);
+		}
+	}
+
+	return (Atomic_Load64(&s_logger.sharedRing->writeIndex) != s_logger.sharedRing->readIndex);
+}
+
+static void Log_WriterMain(void* arg)
+{
+	(void)arg;
+
+	for (;;)
+	{
+		// Read before draining: everything queued before the request gets written by this pass
+		int64_t flushTarget = Atomic_Load64(&s_logger.flushRequested);
+		bool hasWritten = Log_Drain();
+
+		if (hasWritten || flushTarget != Atomic_Load64(&s_logger.flushCompleted))
+		{
+			// One flush per pass instead of one per line
+			Log_FlushOutput(&s_logger.outputs[0]);
+			Log_FlushOutput(&s_logger.outputs[1]);
+		}
+
+		if (flushTarget != Atomic_Load64(&s_logger.flushCompleted))
+		{
+			Mutex_Lock(&s_logger.wakeLock);
+			Atomic_Store64(&s_logger.flushCompleted, flushTarget);
+			ConditionVariable_Broadcast(&s_logger.flushCondition);
+			Mutex_Unlock(&s_logger.wakeLock);
+		}
+
+		if (hasWritten)
+		{
+			continue;
+		}
+
+		if (Atomic_Load32(&s_logger.isShuttingDown) != 0)
+		{
+			break;
+		}
+
+		Mutex_Lock(&s_logger.wakeLock);
+		Atomic_Store32(&s_logger.isWriterSleeping, 1);
+
+		// Pairs with the fence in Log_WakeWriter: either we see the message or the producer sees us asleep
+		Atomic_ThreadFence();
+
+		if (!Log_HasPending() && Atomic_Load32(&s_logger.isShuttingDown) == 0
+			&& Atomic_Load64(&s_logger.flushRequested) == Atomic_Load64(&s_logger.flushCompleted))
+		{
+			ConditionVariable_Wait(&s_logger.wakeCondition, &s_logger.wakeLock);
+		}
+
+		Atomic_Store32(&s_logger.isWriterSleeping, 0);
+		Mutex_Unlock(&s_logger.wakeLock);
+	}
+}
+
+static void Log_WakeWriter()
+{
+	Atomic_ThreadFence();
+
+	// Only the first producer to find the writer asleep pays for the signal
+	if (Atomic_Load32(&s_logger.isWriterSleeping) != 0 && Atomic_Exchange32(&s_logger.isWriterSleeping, 0) != 0)
+	{
+		Mutex_Lock(&s_logger.wakeLock);
+		ConditionVariable_Signal(&s_logger.wakeCondition);
+		Mutex_Unlock(&s_logger.wakeLock);
+	}
+}
+
+static SLogRing* Log_AllocateRing(ELogRingState state)
+{
+	// Not through the MemoryManager: it logs while holding its own lock
+	SLogRing* ring = (SLogRing*)calloc(1, sizeof(SLogRing));
+	if (ring != NULL)
+	{
+		ring->state = state;
+	}
+
+	return (ring);
+}
+
+// A free slot or a new ring, NULL once LOG_MAX_THREADS rings are owned
+static SLogRing* Log_AcquireRing()
+{
+	for (int i = 0; i < LOG_MAX_THREADS; i++)
+	{
+		SLogRing* ring = (SLogRing*)Atomic_LoadPtr((void* volatile*)&s_logger.rings[i]);
+		if (ring == NULL)
+		{
+			SLogRing* newRing = Log_AllocateRing(LOG_RING_OWNED);
+			if (newRing == NULL)
+			{
+				return (NULL);
+			}
+
+			if (Atomic_CompareExchangePtr((void* volatile*)&s_logger.rings[i], NULL, newRing))
+			{
+				return (newRing);
+			}
+
+			// Another thread filled the slot first
+			free(newRing);
+			ring = (SLogRing*)Atomic_LoadPtr((void* volatile*)&s_logger.rings[i]);
+		}
+
+		if (Atomic_CompareExchange32(&ring->state, LOG_RING_FREE, LOG_RING_OWNED))
+		{
+			return (ring);
+		}
+	}
+
+	return (NULL);
+}
+
+static SLogRing* Log_GetThreadRing()
+{
+	int32_t generation = Atomic_Load32(&s_logger.generation);
+	if (s_logGeneration != generation)
+	{
+		s_logGeneration = generation;
+		s_logRing = Log_AcquireRing();
+	}
+
+	return (s_logRing);
+}
+
+// Owner of the ring only (or sharedLock held)
+static void Log_Push(SLogRing* ring, const uint8_t* record, size_t size)
+{
+	int64_t writeIndex = ring->writeIndex;
+	size_t offset = (size_t)(writeIndex & (LOG_RING_SIZE - 1));
+	size_t padding = (offset + size > LOG_RING_SIZE) ? LOG_RING_SIZE - offset : 0;
+
+	// Full: wait for the writer rather than losing the message
+	while (writeIndex + (int64_t)(padding + size) - Atomic_Load64(&ring->readIndex) > LOG_RING_SIZE)
+	{
+		Log_WakeWriter();
+		Thread_Yield();
+	}
+
+	if (padding > 0)
+	{
+		SLogRecord filler = { (uint32_t)padding, LOG_RECORD_PADDING, NULL };
+		memcpy(&ring->data[offset], &filler, sizeof(SLogRecord));
+		writeIndex += (int64_t)padding;
+		offset = 0;
+	}
+
+	memcpy(&ring->data[offset], record, size);
+
+	// release: the record is complete before the writer can see it
+	Atomic_Store64(&ring->writeIndex, writeIndex + (int64_t)size);
+}
+
+// Pins the rings for the caller, false once Destroy started (or before Initialize)
+static bool Log_EnterCall()
+{
+	// Both are full barriers: either Destroy sees us in its wait, or we see isRunning cleared
+	Atomic_Increment32(&s_logger.activeCalls);
+	if (Atomic_FetchAdd32(&s_logger.isRunning, 0) != 0)
+	{
+		return (true);
+	}
+
+	Atomic_Decrement32(&s_logger.activeCalls);
+	return (false);
+}
+
+static void Log_LeaveCall()
+{
+	Atomic_Decrement32(&s_logger.activeCalls);
+}
+
+bool Log_Initialize()
+{
+	if (Atomic_Load32(&s_logger.isRunning) != 0)
+	{
+		return (true);
+	}
+
+	s_logger.sharedRing = Log_AllocateRing(LOG_RING_OWNED);
+	if (s_logger.sharedRing == NULL)
+	{
+		fprintf(stderr, "Failed to Allocate Memory for the log ring\n");
+		return (false);
+	}
+
+	Mutex_Initialize(&s_logger.sharedLock);
+	Mutex_Initialize(&s_logger.wakeLock);
+	ConditionVariable_Initialize(&s_logger.wakeCondition);
+	ConditionVariable_Initialize(&s_logger.flushCondition);
+
+	s_logger.outputs[0].stream = stdout;
+	s_logger.outputs[0].size = 0;
+	s_logger.outputs[1].stream = stderr;
+	s_logger.outputs[1].size = 0;
+	s_logger.isShuttingDown = 0;
+	s_logger.isWriterSleeping = 0;
+	s_logger.flushRequested = 0;
+	s_logger.flushCompleted = 0;
+
+	Atomic_Increment32(&s_logger.generation);
+
+	if (!Thread_Create(&s_logger.writer, Log_WriterMain, NULL))
+	{
+		fprintf(stderr, "Failed to start the log writer thread\n");
+		ConditionVariable_Destroy(&s_logger.flushCondition);
+		ConditionVariable_Destroy(&s_logger.wakeCondition);
+		Mutex_Destroy(&s_logger.wakeLock);
+		Mutex_Destroy(&s_logger.sharedLock);
+		free(s_logger.sharedRing);
+		s_logger.sharedRing = NULL;
+		return (false);
+	}
+
+	Atomic_Store32(&s_logger.isRunning, 1);
+	return (true);
+}
+
+void Log_Destroy()
+{
+	if (Atomic_Load32(&s_logger.isRunning) == 0)
+	{
+		return;
+	}
+
+	// New messages go out synchronously, the writer drains what is queued then exits
+	Atomic_Exchange32(&s_logger.isRunning, 0);
+
+	// Calls already past the check finish with the writer still running
+	while (Atomic_Load32(&s_logger.activeCalls) != 0)
+	{
+		Thread_Yield();
+	}
+
+	Mutex_Lock(&s_logger.wakeLock);
+	Atomic_Store32(&s_logger.isShuttingDown, 1);
+	ConditionVariable_Signal(&s_logger.wakeCondition);
+	Mutex_Unlock(&s_logger.wakeLock);
+
+	Thread_Join(s_logger.writer);
+
+	Atomic_Increment32(&s_logger.generation);
+	for (int i = 0; i < LOG_MAX_THREADS; i++)
+	{
+		free(s_logger.rings[i]);
+		s_logger.rings[i] = NULL;
+	}
+
+	free(s_logger.sharedRing);
+	s_logger.sharedRing = NULL;
+
+	ConditionVariable_Destroy(&s_logger.flushCondition);
+	ConditionVariable_Destroy(&s_logger.wakeCondition);
+	Mutex_Destroy(&s_logger.wakeLock);
+	Mutex_Destroy(&s_logger.sharedLock);
+}
+
+void Log_SetLevel(ELogLevel level)
+{
+	Atomic_Store32(&s_logger.minLevel, (int32_t)level);
+}
+
+void Log_Flush()
+{
+	if (!Log_EnterCall())
+	{
+		fflush(stdout);
+		fflush(stderr);
+		return;
+	}
+
+	Mutex_Lock(&s_logger.wakeLock);
+
+	int64_t target = Atomic_FetchAdd64(&s_logger.flushRequested, 1) + 1;
+	ConditionVariable_Signal(&s_logger.wakeCondition);
+
+	while (Atomic_Load64(&s_logger.flushCompleted) < target)
+	{
+		ConditionVariable_Wait(&s_logger.flushCondition, &s_logger.wakeLock);
+	}
+
+	Mutex_Unlock(&s_logger.wakeLock);
+	Log_LeaveCall();
+}
+
+void Log_ReleaseThread()
+{
+	if (s_logRing != NULL && Log_EnterCall())
+	{
+		if (s_logGeneration == Atomic_Load32(&s_logger.generation))
+		{
+			// release: the writer sees our last message before the state change
+			Atomic_Store32(&s_logRing->state, LOG_RING_RELEASED);
+		}
+
+		Log_LeaveCall();
+	}
+
+	s_logRing = NULL;
+	s_logGeneration = 0;
+}
+
+void Log_Write(ELogLevel level, const char* format, ...)
+{
+	if (format == NULL || (int32_t)level < Atomic_Load32(&s_logger.minLevel))
+	{
+		return;
+	}
+
+	va_list args;
+	va_start(args, format);
+
+	if (!Log_EnterCall())
+	{
+		// No writer thread: same as the old syslog/syserr
+		// One call per line, so threads logging at the same time do not split each other's lines
+		char line[LOG_LINE_SIZE];
+		vsnprintf(line, sizeof(line), format, args);
+
+		FILE* stream = (level >= LOG_LEVEL_WARNING) ? stderr : stdout;
+		fprintf(stream, "%s\n", line);
+		fflush(stream);
+		va_end(args);
+		return;
+	}
+
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+
+	uint8_t record[LOG_MAX_RECORD_SIZE];
+	size_t size = Log_Encode(record, level, format, args);
+	if (size == 0)
+	{
+		// Formatted here instead, it still goes through the ring to keep the order
+		char line[LOG_LINE_SIZE];
+		vsnprintf(line, sizeof(line), format, argsCopy);
+		size = Log_EncodeText(record, level, line);
+	}
+
+	va_end(argsCopy);
+	va_end(args);
+
+	SLogRing* ring = Log_GetThreadRing();
+	if (ring != NULL)
+	{
+		Log_Push(ring, record, size);
+	}
+	else
+	{
+		Mutex_Lock(&s_logger.sharedLock);
+		Log_Push(s_logger.sharedRing, record, size);
+		Mutex_Unlock(&s_logger.sharedLock);
+	}
+
+	Log_WakeWriter();
+	Log_LeaveCall();
+}
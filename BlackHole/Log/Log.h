@@ -0,0 +1,60 @@
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum ELogLevel
+{
+	LOG_LEVEL_TRACE = 0,
+	LOG_LEVEL_DEBUG,
+	LOG_LEVEL_INFO, // stdout
+	LOG_LEVEL_WARNING, // stderr from here on
+	LOG_LEVEL_ERROR,
+	LOG_LEVEL_COUNT
+} ELogLevel;
+
+// Calls below this level are compiled out
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_MAX_THREADS 64 // Threads with their own ring, later ones share a locked ring
+#define LOG_RING_SIZE 65536 // Bytes per thread, must be a power of two
+#define LOG_MAX_RECORD_SIZE 2048 // Longer messages get their strings truncated
+
+#if defined(__GNUC__)
+#define LOG_PRINTF_FORMAT(formatIndex, argsIndex) __attribute__((format(printf, formatIndex, argsIndex)))
+#else
+#define LOG_PRINTF_FORMAT(formatIndex, argsIndex)
+#endif
+
+// Starts the writer thread. Until then, and after Destroy, messages are written synchronously.
+bool Log_Initialize();
+// Waits for the calls already in progress, writes everything still queued, then stops the writer.
+// Calls made after that are written synchronously again.
+void Log_Destroy();
+
+// Messages below 'level' are dropped at runtime
+void Log_SetLevel(ELogLevel level);
+// Returns once every message queued before the call is written and flushed
+void Log_Flush();
+// Hands the ring of the calling thread back, call it before a thread that logged exits
+void Log_ReleaseThread();
+
+// The caller only copies the arguments, formatting and I/O happen on the writer thread.
+// 'format' must stay valid until written (a string literal), %s arguments are copied.
+// Wide (%ls, %lc) and non standard conversions are formatted by the caller instead.
+// When the ring is full the caller waits for the writer, nothing is dropped.
+void Log_Write(ELogLevel level, const char* format, ...) LOG_PRINTF_FORMAT(2, 3);
+
+#define LOG_AT_LEVEL(level, ...) do { if ((level) >= LOG_COMPILE_LEVEL) { Log_Write(level, __VA_ARGS__); } } while (0)
+
+#define log_trace(...) LOG_AT_LEVEL(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define log_debug(...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define log_info(...) LOG_AT_LEVEL(LOG_LEVEL_INFO, __VA_ARGS__)
+#define log_warning(...) LOG_AT_LEVEL(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define log_error(...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif // __LOG_H__
@@ -5,6 +5,7 @@
 
 #include "Map/Map.h"
 #include "List/List.h"
+#include "Log/Log.h"
 int compare(int* a, int* b)
 {
 	if (*a > *b)
@@ -29,6 +30,8 @@ int main()
 		return (EXIT_FAILURE);
 	}
 
+	Log_Initialize();
+
 	List list;
 	List_Initialize(&list);
 
@@ -66,6 +69,7 @@ int main()
 
 	List_Destroy(&list);
 
+	Log_Destroy(); // Joins the writer thread, its start block would otherwise show as a leak
 	MemoryManager_DumpLeaks();
 	MemoryManager_Destroy(&memManager);
 
@@ -0,0 +1,648 @@
+#include "BTreeMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint64_t BTreeMap_PackPrefix(const char* key)
+{
+	uint64_t prefix = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		unsigned char c = (unsigned char)key[i];
+		prefix |= (uint64_t)c << (56 - 8 * i);
+
+		if (c == 0)
+		{
+			break;
+		}
+	}
+
+	return (prefix);
+}
+
+// Same order as strcmp
+static int BTreeMap_Compare(uint64_t prefixA, const char* keyA, uint64_t prefixB, const char* keyB)
+{
+	if (prefixA != prefixB)
+	{
+		return (prefixA < prefixB ? -1 : 1);
+	}
+
+	// equal prefixes ending in a 0 byte: both keys are shorter than 8 and identical
+	if ((prefixA & 0xFF) == 0)
+	{
+		return (0);
+	}
+
+	return strcmp(keyA + 8, keyB + 8);
+}
+
+// First slot whose key is >= key
+static uint16_t BTreeMap_LowerBound(BTreeMapNode node, uint64_t prefix, const char* key)
+{
+	uint16_t low = 0;
+	uint16_t high = node->keysCount;
+
+	while (low < high)
+	{
+		uint16_t middle = (uint16_t)((low + high) / 2);
+		if (BTreeMap_Compare(node->prefixes[middle], node->keys[middle], prefix, key) < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return (low);
+}
+
+// First slot whose key is > key, for inner nodes that is the child to descend into
+static uint16_t BTreeMap_UpperBound(BTreeMapNode node, uint64_t prefix, const char* key)
+{
+	uint16_t low = 0;
+	uint16_t high = node->keysCount;
+
+	while (low < high)
+	{
+		uint16_t middle = (uint16_t)((low + high) / 2);
+		if (BTreeMap_Compare(node->prefixes[middle], node->keys[middle], prefix, key) <= 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return (low);
+}
+
+static char* BTreeMap_CopyKey(BTreeMap map, const char* key)
+{
+	size_t size = strlen(key) + 1;
+	char* copy = (char*)MemoryPool_Alloc(map->keyPool, size);
+
+	if (copy != NULL)
+	{
+		memcpy(copy, key, size);
+	}
+
+	return (copy);
+}
+
+static void BTreeMap_FreeKey(BTreeMap map, char* key)
+{
+	MemoryPool_Free(map->keyPool, key, strlen(key) + 1);
+}
+
+static BTreeMapNode BTreeMap_CreateNode(BTreeMap map, bool isLeaf)
+{
+	BTreeMapNode node = (BTreeMapNode)engine_calloc(1, sizeof(SBTreeMapNode), map->memoryTag);
+	if (node != NULL)
+	{
+		node->isLeaf = isLeaf;
+	}
+
+	return (node);
+}
+
+// Keys are released separately (or all at once through the pool)
+static void BTreeMap_FreeNodes(BTreeMapNode node)
+{
+	if (!node->isLeaf)
+	{
+		for (uint16_t i = 0; i <= node->keysCount; i++)
+		{
+			BTreeMap_FreeNodes(node->children[i]);
+		}
+	}
+
+	engine_free(node);
+}
+
+static void BTreeMap_InsertSeparator(BTreeMapNode parent, uint16_t index, uint64_t prefix, char* key, BTreeMapNode rightChild)
+{
+	uint16_t moved = parent->keysCount - index;
+
+	memmove(&parent->prefixes[index + 1], &parent->prefixes[index], moved * sizeof(uint64_t));
+	memmove(&parent->keys[index + 1], &parent->keys[index], moved * sizeof(char*));
+	memmove(&parent->children[index + 2], &parent->children[index + 1], moved * sizeof(BTreeMapNode));
+
+	parent->prefixes[index] = prefix;
+	parent->keys[index] = key;
+	parent->children[index + 1] = rightChild;
+	parent->keysCount++;
+}
+
+static void BTreeMap_RemoveSeparator(BTreeMapNode parent, uint16_t index)
+{
+	uint16_t moved = parent->keysCount - index - 1;
+
+	memmove(&parent->prefixes[index], &parent->prefixes[index + 1], moved * sizeof(uint64_t));
+	memmove(&parent->keys[index], &parent->keys[index + 1], moved * sizeof(char*));
+	memmove(&parent->children[index + 1], &parent->children[index + 2], moved * sizeof(BTreeMapNode));
+	parent->keysCount--;
+}
+
+// Splits the full parent->children[index] in two, the parent must have room for one more key
+static bool BTreeMap_SplitChild(BTreeMap map, BTreeMapNode parent, uint16_t index)
+{
+	BTreeMapNode child = parent->children[index];
+	BTreeMapNode right = BTreeMap_CreateNode(map, child->isLeaf);
+	if (right == NULL)
+	{
+		return (false);
+	}
+
+	uint64_t separatorPrefix = 0;
+	char* separator = NULL;
+
+	if (child->isLeaf)
+	{
+		// B+ tree: every key stays in a leaf, the parent gets a copy of the right half's first key
+		uint16_t rightCount = BTREE_MAP_MAX_KEYS - BTREE_MAP_MIN_KEYS;
+		separator = BTreeMap_CopyKey(map, child->keys[BTREE_MAP_MIN_KEYS]);
+		if (separator == NULL)
+		{
+			engine_free(right);
+			return (false);
+		}
+
+		separatorPrefix = child->prefixes[BTREE_MAP_MIN_KEYS];
+		memcpy(right->prefixes, &child->prefixes[BTREE_MAP_MIN_KEYS], rightCount * sizeof(uint64_t));
+		memcpy(right->keys, &child->keys[BTREE_MAP_MIN_KEYS], rightCount * sizeof(char*));
+		memcpy(right->values, &child->values[BTREE_MAP_MIN_KEYS], rightCount * sizeof(void*));
+		right->keysCount = rightCount;
+
+		right->nextLeaf = child->nextLeaf;
+		child->nextLeaf = right;
+	}
+	else
+	{
+		// the middle key moves up
+		uint16_t rightCount = BTREE_MAP_MAX_KEYS - BTREE_MAP_MIN_KEYS - 1;
+		separator = child->keys[BTREE_MAP_MIN_KEYS];
+		separatorPrefix = child->prefixes[BTREE_MAP_MIN_KEYS];
+
+		memcpy(right->prefixes, &child->prefixes[BTREE_MAP_MIN_KEYS + 1], rightCount * sizeof(uint64_t));
+		memcpy(right->keys, &child->keys[BTREE_MAP_MIN_KEYS + 1], rightCount * sizeof(char*));
+		memcpy(right->children, &child->children[BTREE_MAP_MIN_KEYS + 1], (rightCount + 1) * sizeof(BTreeMapNode));
+		right->keysCount = rightCount;
+	}
+
+	child->keysCount = BTREE_MAP_MIN_KEYS;
+	BTreeMap_InsertSeparator(parent, index, separatorPrefix, separator, right);
+
+	return (true);
+}
+
+// Moves the last key of children[index - 1] to the front of children[index]
+static void BTreeMap_BorrowFromLeft(BTreeMap map, BTreeMapNode parent, uint16_t index)
+{
+	BTreeMapNode child = parent->children[index];
+	BTreeMapNode left = parent->children[index - 1];
+	uint16_t last = left->keysCount - 1;
+
+	if (child->isLeaf)
+	{
+		char* separator = BTreeMap_CopyKey(map, left->keys[last]);
+		if (separator == NULL)
+		{
+			return; // the child stays small, lookups are still correct
+		}
+
+		BTreeMap_FreeKey(map, parent->keys[index - 1]);
+		parent->keys[index - 1] = separator;
+		parent->prefixes[index - 1] = left->prefixes[last];
+
+		memmove(&child->values[1], &child->values[0], child->keysCount * sizeof(void*));
+		child->values[0] = left->values[last];
+	}
+	else
+	{
+		// rotate through the parent: its separator comes down, the left key goes up
+		memmove(&child->children[1], &child->children[0], (child->keysCount + 1) * sizeof(BTreeMapNode));
+		child->children[0] = left->children[last + 1];
+
+		uint64_t prefix = parent->prefixes[index - 1];
+		char* key = parent->keys[index - 1];
+		parent->prefixes[index - 1] = left->prefixes[last];
+		parent->keys[index - 1] = left->keys[last];
+		left->prefixes[last] = prefix;
+		left->keys[last] = key;
+	}
+
+	memmove(&child->prefixes[1], &child->prefixes[0], child->keysCount * sizeof(uint64_t));
+	memmove(&child->keys[1], &child->keys[0], child->keysCount * sizeof(char*));
+	child->prefixes[0] = left->prefixes[last];
+	child->keys[0] = left->keys[last];
+
+	child->keysCount++;
+	left->keysCount--;
+}
+
+// Moves the first key of children[index + 1] to the end of children[index]
+static void BTreeMap_BorrowFromRight(BTreeMap map, BTreeMapNode parent, uint16_t index)
+{
+	BTreeMapNode child = parent->children[index];
+	BTreeMapNode right = parent->children[index + 1];
+
+	if (child->isLeaf)
+	{
+		char* separator = BTreeMap_CopyKey(map, right->keys[1]);
+		if (separator == NULL)
+		{
+			return;
+		}
+
+		BTreeMap_FreeKey(map, parent->keys[index]);
+		parent->keys[index] = separator;
+		parent->prefixes[index] = right->prefixes[1];
+
+		child->prefixes[child->keysCount] = right->prefixes[0];
+		child->keys[child->keysCount] = right->keys[0];
+		child->values[child->keysCount] = right->values[0];
+		memmove(&right->values[0], &right->values[1], (right->keysCount - 1) * sizeof(void*));
+	}
+	else
+	{
+		child->prefixes[child->keysCount] = parent->prefixes[index];
+		child->keys[child->keysCount] = parent->keys[index];
+		child->children[child->keysCount + 1] = right->children[0];
+
+		parent->prefixes[index] = right->prefixes[0];
+		parent->keys[index] = right->keys[0];
+		memmove(&right->children[0], &right->children[1], right->keysCount * sizeof(BTreeMapNode));
+	}
+
+	memmove(&right->prefixes[0], &right->prefixes[1], (right->keysCount - 1) * sizeof(uint64_t));
+	memmove(&right->keys[0], &right->keys[1], (right->keysCount - 1) * sizeof(char*));
+
+	child->keysCount++;
+	right->keysCount--;
+}
+
+// Folds children[index + 1] into children[index], both hold at most BTREE_MAP_MIN_KEYS
+static void BTreeMap_MergeChildren(BTreeMap map, BTreeMapNode parent, uint16_t index)
+{
+	BTreeMapNode left = parent->children[index];
+	BTreeMapNode right = parent->children[index + 1];
+
+	if (left->isLeaf)
+	{
+		memcpy(&left->prefixes[left->keysCount], right->prefixes, right->keysCount * sizeof(uint64_t));
+		memcpy(&left->keys[left->keysCount], right->keys, right->keysCount * sizeof(char*));
+		memcpy(&left->values[left->keysCount], right->values, right->keysCount * sizeof(void*));
+		left->keysCount += right->keysCount;
+		left->nextLeaf = right->nextLeaf;
+
+		BTreeMap_FreeKey(map, parent->keys[index]);
+	}
+	else
+	{
+		// the separator comes down between the two halves
+		left->prefixes[left->keysCount] = parent->prefixes[index];
+		left->keys[left->keysCount] = parent->keys[index];
+		left->keysCount++;
+
+		memcpy(&left->prefixes[left->keysCount], right->prefixes, right->keysCount * sizeof(uint64_t));
+		memcpy(&left->keys[left->keysCount], right->keys, right->keysCount * sizeof(char*));
+		memcpy(&left->children[left->keysCount], right->children, (right->keysCount + 1) * sizeof(BTreeMapNode));
+		left->keysCount += right->keysCount;
+	}
+
+	BTreeMap_RemoveSeparator(parent, index);
+	engine_free(right);
+}
+
+// Makes sure parent->children[index] can lose a key, returns the index of the child now covering it
+static uint16_t BTreeMap_FillChild(BTreeMap map, BTreeMapNode parent, uint16_t index)
+{
+	if (index > 0 && parent->children[index - 1]->keysCount > BTREE_MAP_MIN_KEYS)
+	{
+		BTreeMap_BorrowFromLeft(map, parent, index);
+		return (index);
+	}
+
+	if (index < parent->keysCount && parent->children[index + 1]->keysCount > BTREE_MAP_MIN_KEYS)
+	{
+		BTreeMap_BorrowFromRight(map, parent, index);
+		return (index);
+	}
+
+	if (index > 0)
+	{
+		BTreeMap_MergeChildren(map, parent, index - 1);
+		return (index - 1);
+	}
+
+	BTreeMap_MergeChildren(map, parent, index);
+	return (index);
+}
+
+static BTreeMapNode BTreeMap_FindLeaf(BTreeMap map, uint64_t prefix, const char* key)
+{
+	BTreeMapNode node = map->rootNode;
+	while (!node->isLeaf)
+	{
+		node = node->children[BTreeMap_UpperBound(node, prefix, key)];
+	}
+
+	return (node);
+}
+
+bool BTreeMap_Initialize(BTreeMap* ppMap, EMemoryTag tag)
+{
+	if (!ppMap)
+	{
+		return (false);
+	}
+
+	*ppMap = engine_new_zero(SBTreeMap, 1, tag);
+	BTreeMap map = *ppMap;
+
+	if (map == NULL)
+	{
+		syserr("Failed to Allocate BTreeMap Memory");
+		return (false);
+	}
+
+	map->memoryTag = tag;
+
+	if (!MemoryPool_Initialize(&map->keyPool, tag))
+	{
+		engine_delete(map);
+		*ppMap = NULL;
+		return (false);
+	}
+
+	map->rootNode = BTreeMap_CreateNode(map, true);
+	if (map->rootNode == NULL)
+	{
+		MemoryPool_Destroy(&map->keyPool);
+		engine_delete(map);
+		*ppMap = NULL;
+		return (false);
+	}
+
+	return (true);
+}
+
+void BTreeMap_Destroy(BTreeMap* ppMap)
+{
+	if (!ppMap || !*ppMap)
+	{
+		return;
+	}
+
+	BTreeMap_FreeNodes((*ppMap)->rootNode);
+	MemoryPool_Destroy(&(*ppMap)->keyPool);
+
+	engine_delete(*ppMap);
+	*ppMap = NULL;
+}
+
+bool BTreeMap_Insert(BTreeMap map, const char* key, void* value)
+{
+	if (map == NULL)
+	{
+		return (false);
+	}
+
+	if (key == NULL || value == NULL)
+	{
+		syserr("Trying to insert wrong data! %p - %p", key, value);
+		return (false);
+	}
+
+	uint64_t prefix = BTreeMap_PackPrefix(key);
+
+	// Full nodes are split on the way down so there is always room for a separator
+	if (map->rootNode->keysCount == BTREE_MAP_MAX_KEYS)
+	{
+		BTreeMapNode newRoot = BTreeMap_CreateNode(map, false);
+		if (newRoot == NULL)
+		{
+			syserr("Failed to allocate btree node");
+			return (false);
+		}
+
+		newRoot->children[0] = map->rootNode;
+		if (!BTreeMap_SplitChild(map, newRoot, 0))
+		{
+			engine_free(newRoot);
+			syserr("Failed to allocate btree node");
+			return (false);
+		}
+
+		map->rootNode = newRoot;
+	}
+
+	BTreeMapNode node = map->rootNode;
+	while (!node->isLeaf)
+	{
+		uint16_t index = BTreeMap_UpperBound(node, prefix, key);
+
+		if (node->children[index]->keysCount == BTREE_MAP_MAX_KEYS)
+		{
+			if (!BTreeMap_SplitChild(map, node, index))
+			{
+				syserr("Failed to allocate btree node");
+				return (false);
+			}
+
+			if (BTreeMap_Compare(prefix, key, node->prefixes[index], node->keys[index]) >= 0)
+			{
+				index++;
+			}
+		}
+
+		node = node->children[index];
+	}
+
+	uint16_t position = BTreeMap_LowerBound(node, prefix, key);
+	if (position < node->keysCount && BTreeMap_Compare(node->prefixes[position], node->keys[position], prefix, key) == 0)
+	{
+		node->values[position] = value;
+		return (true);
+	}
+
+	char* keyCopy = BTreeMap_CopyKey(map, key);
+	if (keyCopy == NULL)
+	{
+		syserr("Failed to allocate btree key");
+		return (false);
+	}
+
+	uint16_t moved = node->keysCount - position;
+	memmove(&node->prefixes[position + 1], &node->prefixes[position], moved * sizeof(uint64_t));
+	memmove(&node->keys[position + 1], &node->keys[position], moved * sizeof(char*));
+	memmove(&node->values[position + 1], &node->values[position], moved * sizeof(void*));
+
+	node->prefixes[position] = prefix;
+	node->keys[position] = keyCopy;
+	node->values[position] = value;
+	node->keysCount++;
+	map->elementsCount++;
+
+	return (true);
+}
+
+void* BTreeMap_Find(BTreeMap map, const char* key)
+{
+	if (map == NULL || key == NULL)
+	{
+		return (NULL);
+	}
+
+	uint64_t prefix = BTreeMap_PackPrefix(key);
+	BTreeMapNode leaf = BTreeMap_FindLeaf(map, prefix, key);
+
+	uint16_t position = BTreeMap_LowerBound(leaf, prefix, key);
+	if (position < leaf->keysCount && BTreeMap_Compare(leaf->prefixes[position], leaf->keys[position], prefix, key) == 0)
+	{
+		return (leaf->values[position]);
+	}
+
+	return (NULL);
+}
+
+void BTreeMap_Delete(BTreeMap map, const char* key)
+{
+	if (map == NULL || key == NULL)
+	{
+		return;
+	}
+
+	uint64_t prefix = BTreeMap_PackPrefix(key);
+
+	// Small children are refilled on the way down so the leaf can always lose a key
+	BTreeMapNode node = map->rootNode;
+	while (!node->isLeaf)
+	{
+		uint16_t index = BTreeMap_UpperBound(node, prefix, key);
+
+		if (node->children[index]->keysCount <= BTREE_MAP_MIN_KEYS)
+		{
+			index = BTreeMap_FillChild(map, node, index);
+		}
+
+		if (node->keysCount == 0)
+		{
+			// only the root can run empty, its single child takes over
+			map->rootNode = node->children[0];
+			engine_free(node);
+			node = map->rootNode;
+			continue;
+		}
+
+		node = node->children[index];
+	}
+
+	uint16_t position = BTreeMap_LowerBound(node, prefix, key);
+	if (position >= node->keysCount || BTreeMap_Compare(node->prefixes[position], node->keys[position], prefix, key) != 0)
+	{
+		return;
+	}
+
+	BTreeMap_FreeKey(map, node->keys[position]);
+
+	uint16_t moved = node->keysCount - position - 1;
+	memmove(&node->prefixes[position], &node->prefixes[position + 1], moved * sizeof(uint64_t));
+	memmove(&node->keys[position], &node->keys[position + 1], moved * sizeof(char*));
+	memmove(&node->values[position], &node->values[position + 1], moved * sizeof(void*));
+
+	node->keysCount--;
+	map->elementsCount--;
+}
+
+void BTreeMap_Clear(BTreeMap map)
+{
+	if (map == NULL)
+	{
+		return;
+	}
+
+	BTreeMapNode emptyRoot = BTreeMap_CreateNode(map, true);
+	if (emptyRoot == NULL)
+	{
+		syserr("Failed to allocate btree node");
+		return;
+	}
+
+	BTreeMap_FreeNodes(map->rootNode);
+	MemoryPool_Reset(map->keyPool); // every key and separator at once
+
+	map->rootNode = emptyRoot;
+	map->elementsCount = 0;
+}
+
+void BTreeMap_ForEach(BTreeMap map, fnBTreeMapFunc function, void* context)
+{
+	BTreeMap_ForEachInRange(map, NULL, NULL, function, context);
+}
+
+void BTreeMap_ForEachInRange(BTreeMap map, const char* fromKey, const char* toKey, fnBTreeMapFunc function, void* context)
+{
+	if (map == NULL || function == NULL)
+	{
+		return;
+	}
+
+	BTreeMapNode leaf = map->rootNode;
+	uint16_t position = 0;
+
+	if (fromKey != NULL)
+	{
+		uint64_t fromPrefix = BTreeMap_PackPrefix(fromKey);
+		leaf = BTreeMap_FindLeaf(map, fromPrefix, fromKey);
+		position = BTreeMap_LowerBound(leaf, fromPrefix, fromKey);
+	}
+	else
+	{
+		while (!leaf->isLeaf)
+		{
+			leaf = leaf->children[0];
+		}
+	}
+
+	uint64_t toPrefix = (toKey != NULL) ? BTreeMap_PackPrefix(toKey) : 0;
+
+	// walk the leaf chain, each leaf is a handful of consecutive cache lines
+	while (leaf != NULL)
+	{
+		for (; position < leaf->keysCount; position++)
+		{
+			if (toKey != NULL && BTreeMap_Compare(leaf->prefixes[position], leaf->keys[position], toPrefix, toKey) >= 0)
+			{
+				return;
+			}
+
+			function(leaf->keys[position], leaf->values[position], context);
+		}
+
+		leaf = leaf->nextLeaf;
+		position = 0;
+	}
+}
+
+size_t BTreeMap_GetHeight(BTreeMap map)
+{
+	if (map == NULL)
+	{
+		return (0);
+	}
+
+	size_t height = 1;
+	for (BTreeMapNode node = map->rootNode; !node->isLeaf; node = node->children[0])
+	{
+		height++;
+	}
+
+	return (height);
+}
@@ -0,0 +1,61 @@
+#ifndef __BTREE_MAP_H__
+#define __BTREE_MAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../MemoryManager/MemoryPool.h"
+
+#define BTREE_MAP_MAX_KEYS 31 // Odd so a full node splits into two nodes of at least BTREE_MAP_MIN_KEYS
+#define BTREE_MAP_MIN_KEYS (BTREE_MAP_MAX_KEYS / 2)
+
+typedef void(*fnBTreeMapFunc)(const char* key, void* value, void* context);
+
+// B+ tree node: values live in the leaves, inner nodes only route.
+// The first 8 key bytes are packed big endian in 'prefixes' so most comparisons
+// are integer compares on the node's own cache lines, the key string is read only on a tie.
+typedef struct SBTreeMapNode
+{
+	uint16_t keysCount;
+	bool isLeaf;
+
+	uint64_t prefixes[BTREE_MAP_MAX_KEYS];
+	char* keys[BTREE_MAP_MAX_KEYS]; // Leaves own their keys, inner nodes own copies of the separators
+
+	union
+	{
+		void* values[BTREE_MAP_MAX_KEYS]; // Leaves
+		struct SBTreeMapNode* children[BTREE_MAP_MAX_KEYS + 1]; // Inner nodes, children[i] holds the keys below keys[i]
+	};
+
+	struct SBTreeMapNode* nextLeaf; // Leaves are chained in key order for scans
+} SBTreeMapNode;
+
+typedef struct SBTreeMapNode* BTreeMapNode;
+
+typedef struct SBTreeMap
+{
+	BTreeMapNode rootNode;
+	size_t elementsCount;
+	MemoryPool keyPool;
+	EMemoryTag memoryTag;
+} SBTreeMap;
+
+typedef struct SBTreeMap* BTreeMap;
+
+bool BTreeMap_Initialize(BTreeMap* ppMap, EMemoryTag tag);
+void BTreeMap_Destroy(BTreeMap* ppMap);
+
+bool BTreeMap_Insert(BTreeMap map, const char* key, void* value);
+void* BTreeMap_Find(BTreeMap map, const char* key);
+void BTreeMap_Delete(BTreeMap map, const char* key);
+void BTreeMap_Clear(BTreeMap map);
+
+// Key order, the callback must not modify the map
+void BTreeMap_ForEach(BTreeMap map, fnBTreeMapFunc function, void* context);
+// Keys in [fromKey, toKey), NULL leaves that side open
+void BTreeMap_ForEachInRange(BTreeMap map, const char* fromKey, const char* toKey, fnBTreeMapFunc function, void* context);
+
+size_t BTreeMap_GetHeight(BTreeMap map);
+
+#endif // __BTREE_MAP_H__
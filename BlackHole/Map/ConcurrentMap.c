@@ -0,0 +1,425 @@
+#include "ConcurrentMap.h"
+#include "HashMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../MemoryManager/MemoryPool.h"
+#include "../Threading/Atomic.h"
+#include "../Threading/Epoch.h"
+#include "../Threading/Thread.h"
+#include "../Stdafx.h"
+
+#define CONCURRENT_MAP_SHARD_SHIFT 58 // top 6 bits pick the shard, the low bits pick the bucket
+#define CONCURRENT_MAP_MIN_BUCKETS 16
+
+// Key and hash never change after publication, only 'next' and 'pValue' are written concurrently
+typedef struct SConcurrentMapEntry
+{
+	struct SConcurrentMapEntry* volatile next;
+	void* volatile pValue;
+	uint64_t hash;
+	uint32_t keyLength;
+	char szKey[];
+} SConcurrentMapEntry;
+
+typedef struct SConcurrentMapTable
+{
+	size_t bucketsMask;
+	SConcurrentMapEntry* volatile buckets[];
+} SConcurrentMapTable;
+
+// Unlinked entry or table waiting until no reader can reach it
+typedef struct SConcurrentMapRetired
+{
+	struct SConcurrentMapRetired* next;
+	void* pObject;
+	size_t size; // 0 for tables, which live outside the pool
+	int64_t epoch;
+} SConcurrentMapRetired;
+
+typedef struct SConcurrentMapShard
+{
+	SConcurrentMapTable* volatile table;
+	Mutex writeLock;
+	MemoryPool entryPool; // only touched under writeLock
+	SConcurrentMapRetired* retired;
+	volatile int64_t elementsCount; // written under writeLock, read by GetCount
+	char padding[64]; // keeps neighbouring locks off the same cache line
+} SConcurrentMapShard;
+
+typedef struct SConcurrentMap
+{
+	SConcurrentMapShard shards[CONCURRENT_MAP_SHARDS];
+	EMemoryTag memoryTag;
+} SConcurrentMap;
+
+static size_t ConcurrentMap_EntrySize(uint32_t keyLength)
+{
+	return sizeof(SConcurrentMapEntry) + keyLength + 1;
+}
+
+static SConcurrentMapShard* ConcurrentMap_GetShard(ConcurrentMap map, uint64_t hash)
+{
+	return &map->shards[(hash >> CONCURRENT_MAP_SHARD_SHIFT) & (CONCURRENT_MAP_SHARDS - 1)];
+}
+
+static SConcurrentMapTable* ConcurrentMap_CreateTable(ConcurrentMap map, size_t bucketsCount)
+{
+	SConcurrentMapTable* table = (SConcurrentMapTable*)engine_calloc(1, sizeof(SConcurrentMapTable) + bucketsCount * sizeof(SConcurrentMapEntry*), map->memoryTag);
+	if (table == NULL)
+	{
+		return (NULL);
+	}
+
+	table->bucketsMask = bucketsCount - 1;
+	return (table);
+}
+
+static SConcurrentMapEntry* ConcurrentMap_CreateEntry(SConcurrentMapShard* shard, const char* key, uint32_t keyLength, uint64_t hash, void* value)
+{
+	SConcurrentMapEntry* entry = (SConcurrentMapEntry*)MemoryPool_Alloc(shard->entryPool, ConcurrentMap_EntrySize(keyLength));
+	if (entry == NULL)
+	{
+		return (NULL);
+	}
+
+	entry->next = NULL;
+	entry->pValue = value;
+	entry->hash = hash;
+	entry->keyLength = keyLength;
+	memcpy(entry->szKey, key, keyLength + 1);
+
+	return (entry);
+}
+
+static void ConcurrentMap_FreeRetired(SConcurrentMapShard* shard, SConcurrentMapRetired* retired)
+{
+	if (retired->size == 0)
+	{
+		engine_free(retired->pObject);
+	}
+	else
+	{
+		MemoryPool_Free(shard->entryPool, retired->pObject, retired->size);
+	}
+
+	MemoryPool_Free(shard->entryPool, retired, sizeof(SConcurrentMapRetired));
+}
+
+// Frees what every reader has moved past, called with the shard locked
+static void ConcurrentMap_Reclaim(SConcurrentMapShard* shard)
+{
+	if (shard->retired == NULL)
+	{
+		return;
+	}
+
+	int64_t minActive = Epoch_GetMinActive();
+	SConcurrentMapRetired** link = &shard->retired;
+
+	while (*link != NULL)
+	{
+		SConcurrentMapRetired* retired = *link;
+		if (retired->epoch < minActive)
+		{
+			*link = retired->next;
+			ConcurrentMap_FreeRetired(shard, retired);
+		}
+		else
+		{
+			link = &retired->next;
+		}
+	}
+}
+
+// 'pObject' must already be unreachable for new readers
+static void ConcurrentMap_Retire(SConcurrentMapShard* shard, void* pObject, size_t size, int64_t epoch)
+{
+	SConcurrentMapRetired* retired = (SConcurrentMapRetired*)MemoryPool_Alloc(shard->entryPool, sizeof(SConcurrentMapRetired));
+	if (retired == NULL)
+	{
+		syserr("ConcurrentMap: failed to record a retired object, leaking it");
+		return;
+	}
+
+	retired->pObject = pObject;
+	retired->size = size;
+	retired->epoch = epoch;
+	retired->next = shard->retired;
+	shard->retired = retired;
+}
+
+// Copy on write: readers keep walking the old table while the new one is built,
+// then the old table and its entries are retired together
+static void ConcurrentMap_Grow(ConcurrentMap map, SConcurrentMapShard* shard)
+{
+	SConcurrentMapTable* oldTable = shard->table;
+	SConcurrentMapTable* newTable = ConcurrentMap_CreateTable(map, (oldTable->bucketsMask + 1) * 2);
+	if (newTable == NULL)
+	{
+		return; // chains just get longer
+	}
+
+	for (size_t i = 0; i <= oldTable->bucketsMask; i++)
+	{
+		for (SConcurrentMapEntry* entry = oldTable->buckets[i]; entry != NULL; entry = entry->next)
+		{
+			SConcurrentMapEntry* copy = ConcurrentMap_CreateEntry(shard, entry->szKey, entry->keyLength, entry->hash, entry->pValue);
+			if (copy == NULL)
+			{
+				// drop the half built table, nobody has seen it
+				for (size_t j = 0; j <= newTable->bucketsMask; j++)
+				{
+					while (newTable->buckets[j] != NULL)
+					{
+						SConcurrentMapEntry* next = newTable->buckets[j]->next;
+						MemoryPool_Free(shard->entryPool, newTable->buckets[j], ConcurrentMap_EntrySize(newTable->buckets[j]->keyLength));
+						newTable->buckets[j] = next;
+					}
+				}
+
+				engine_free(newTable);
+				return;
+			}
+
+			size_t bucket = copy->hash & newTable->bucketsMask;
+			copy->next = newTable->buckets[bucket];
+			newTable->buckets[bucket] = copy;
+		}
+	}
+
+	Atomic_StorePtr((void* volatile*)&shard->table, newTable);
+	int64_t epoch = Epoch_Advance();
+
+	for (size_t i = 0; i <= oldTable->bucketsMask; i++)
+	{
+		for (SConcurrentMapEntry* entry = oldTable->buckets[i]; entry != NULL; entry = entry->next)
+		{
+			ConcurrentMap_Retire(shard, entry, ConcurrentMap_EntrySize(entry->keyLength), epoch);
+		}
+	}
+
+	ConcurrentMap_Retire(shard, oldTable, 0, epoch);
+}
+
+bool ConcurrentMap_Initialize(ConcurrentMap* ppMap, EMemoryTag tag)
+{
+	if (!ppMap)
+	{
+		return (false);
+	}
+
+	*ppMap = engine_new_zero(SConcurrentMap, 1, tag);
+	ConcurrentMap map = *ppMap;
+
+	if (map == NULL)
+	{
+		syserr("Failed to Allocate ConcurrentMap Memory");
+		return (false);
+	}
+
+	map->memoryTag = tag;
+
+	// every lock first, so a failed initialization can go through Destroy
+	for (uint32_t i = 0; i < CONCURRENT_MAP_SHARDS; i++)
+	{
+		Mutex_Initialize(&map->shards[i].writeLock);
+	}
+
+	for (uint32_t i = 0; i < CONCURRENT_MAP_SHARDS; i++)
+	{
+		SConcurrentMapShard* shard = &map->shards[i];
+		shard->table = ConcurrentMap_CreateTable(map, CONCURRENT_MAP_MIN_BUCKETS);
+		if (shard->table == NULL || !MemoryPool_Initialize(&shard->entryPool, tag))
+		{
+			ConcurrentMap_Destroy(ppMap);
+			return (false);
+		}
+	}
+
+	return (true);
+}
+
+void ConcurrentMap_Destroy(ConcurrentMap* ppMap)
+{
+	if (!ppMap || !*ppMap)
+	{
+		return;
+	}
+
+	ConcurrentMap map = *ppMap;
+
+	// entries and retire records live in the shard pools, tables do not
+	for (uint32_t i = 0; i < CONCURRENT_MAP_SHARDS; i++)
+	{
+		SConcurrentMapShard* shard = &map->shards[i];
+
+		for (SConcurrentMapRetired* retired = shard->retired; retired != NULL; retired = retired->next)
+		{
+			if (retired->size == 0)
+			{
+				engine_free(retired->pObject);
+			}
+		}
+
+		if (shard->table != NULL)
+		{
+			engine_free(shard->table);
+		}
+
+		MemoryPool_Destroy(&shard->entryPool);
+		Mutex_Destroy(&shard->writeLock);
+	}
+
+	engine_delete(map);
+	*ppMap = NULL;
+}
+
+bool ConcurrentMap_Insert(ConcurrentMap map, const char* key, void* value)
+{
+	if (map == NULL)
+	{
+		return (false);
+	}
+
+	if (key == NULL || value == NULL)
+	{
+		syserr("Trying to insert wrong data! %p - %p", key, value);
+		return (false);
+	}
+
+	uint64_t hash = HashMap_HashString(key);
+	size_t keyLength = strlen(key);
+	SConcurrentMapShard* shard = ConcurrentMap_GetShard(map, hash);
+
+	Mutex_Lock(&shard->writeLock);
+
+	SConcurrentMapTable* table = shard->table;
+	SConcurrentMapEntry* volatile* bucket = &table->buckets[hash & table->bucketsMask];
+
+	for (SConcurrentMapEntry* entry = *bucket; entry != NULL; entry = entry->next)
+	{
+		if (entry->hash == hash && strcmp(entry->szKey, key) == 0)
+		{
+			// readers see either the old or the new value, never a torn one
+			Atomic_StorePtr(&entry->pValue, value);
+			Mutex_Unlock(&shard->writeLock);
+			return (true);
+		}
+	}
+
+	SConcurrentMapEntry* newEntry = ConcurrentMap_CreateEntry(shard, key, (uint32_t)keyLength, hash, value);
+	if (newEntry == NULL)
+	{
+		Mutex_Unlock(&shard->writeLock);
+		syserr("Failed to allocate concurrent map entry");
+		return (false);
+	}
+
+	// fully built before it becomes reachable
+	newEntry->next = *bucket;
+	Atomic_StorePtr((void* volatile*)bucket, newEntry);
+	Atomic_Store64(&shard->elementsCount, shard->elementsCount + 1);
+
+	if ((size_t)shard->elementsCount > table->bucketsMask + 1)
+	{
+		ConcurrentMap_Grow(map, shard);
+	}
+
+	ConcurrentMap_Reclaim(shard);
+	Mutex_Unlock(&shard->writeLock);
+
+	return (true);
+}
+
+void* ConcurrentMap_Find(ConcurrentMap map, const char* key)
+{
+	if (map == NULL || key == NULL)
+	{
+		return (NULL);
+	}
+
+	uint64_t hash = HashMap_HashString(key);
+	SConcurrentMapShard* shard = ConcurrentMap_GetShard(map, hash);
+
+	bool lockFree = Epoch_Enter();
+	if (!lockFree)
+	{
+		Mutex_Lock(&shard->writeLock);
+	}
+
+	void* value = NULL;
+	SConcurrentMapTable* table = (SConcurrentMapTable*)Atomic_LoadPtr((void* volatile*)&shard->table);
+	SConcurrentMapEntry* entry = (SConcurrentMapEntry*)Atomic_LoadPtr((void* volatile*)&table->buckets[hash & table->bucketsMask]);
+
+	while (entry != NULL)
+	{
+		if (entry->hash == hash && strcmp(entry->szKey, key) == 0)
+		{
+			value = Atomic_LoadPtr(&entry->pValue);
+			break;
+		}
+
+		entry = (SConcurrentMapEntry*)Atomic_LoadPtr((void* volatile*)&entry->next);
+	}
+
+	if (lockFree)
+	{
+		Epoch_Exit();
+	}
+	else
+	{
+		Mutex_Unlock(&shard->writeLock);
+	}
+
+	return (value);
+}
+
+void ConcurrentMap_Delete(ConcurrentMap map, const char* key)
+{
+	if (map == NULL || key == NULL)
+	{
+		return;
+	}
+
+	uint64_t hash = HashMap_HashString(key);
+	SConcurrentMapShard* shard = ConcurrentMap_GetShard(map, hash);
+
+	Mutex_Lock(&shard->writeLock);
+
+	SConcurrentMapTable* table = shard->table;
+	SConcurrentMapEntry* volatile* link = &table->buckets[hash & table->bucketsMask];
+
+	while (*link != NULL)
+	{
+		SConcurrentMapEntry* entry = *link;
+		if (entry->hash == hash && strcmp(entry->szKey, key) == 0)
+		{
+			// readers already on 'entry' can still follow its next pointer
+			Atomic_StorePtr((void* volatile*)link, entry->next);
+			ConcurrentMap_Retire(shard, entry, ConcurrentMap_EntrySize(entry->keyLength), Epoch_Advance());
+			Atomic_Store64(&shard->elementsCount, shard->elementsCount - 1);
+			break;
+		}
+
+		link = &entry->next;
+	}
+
+	ConcurrentMap_Reclaim(shard);
+	Mutex_Unlock(&shard->writeLock);
+}
+
+size_t ConcurrentMap_GetCount(ConcurrentMap map)
+{
+	if (map == NULL)
+	{
+		return (0);
+	}
+
+	// approximate while writers are running
+	size_t count = 0;
+	for (uint32_t i = 0; i < CONCURRENT_MAP_SHARDS; i++)
+	{
+		count += (size_t)Atomic_Load64(&map->shards[i].elementsCount);
+	}
+
+	return (count);
+}
@@ -0,0 +1,28 @@
+#ifndef __CONCURRENT_MAP_H__
+#define __CONCURRENT_MAP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "../MemoryManager/MemoryTags.h"
+
+#define CONCURRENT_MAP_SHARDS 64 // Must be a power of two
+
+// String keyed map shared between threads without an outer lock.
+// Find never blocks: readers walk the shard tables inside an epoch section.
+// Writers lock only the shard owning the key, unlinked entries are freed once
+// no reader can still see them.
+typedef struct SConcurrentMap* ConcurrentMap;
+
+bool ConcurrentMap_Initialize(ConcurrentMap* ppMap, EMemoryTag tag);
+// No other thread may use the map anymore
+void ConcurrentMap_Destroy(ConcurrentMap* ppMap);
+
+// Inserts or replaces the value of 'key'
+bool ConcurrentMap_Insert(ConcurrentMap map, const char* key, void* value);
+void* ConcurrentMap_Find(ConcurrentMap map, const char* key);
+void ConcurrentMap_Delete(ConcurrentMap map, const char* key);
+
+size_t ConcurrentMap_GetCount(ConcurrentMap map);
+
+#endif // __CONCURRENT_MAP_H__
@@ -0,0 +1,134 @@
+#include "HandleTable.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#include <string.h>
+
+#define HANDLE_TABLE_INITIAL_CAPACITY 16
+
+static bool HandleTable_Resize(SHandleTable* table, uint32_t capacity)
+{
+	SHandleSlot* slots = engine_realloc_array(table->slots, SHandleSlot, capacity);
+	if (slots == NULL)
+	{
+		return (false);
+	}
+
+	table->slots = slots;
+	table->capacity = capacity;
+	return (true);
+}
+
+static void HandleTable_NextGeneration(SHandleSlot* slot)
+{
+	// Skip 0 on wrap, it would make GENERATIONAL_HANDLE_INVALID look valid
+	slot->generation = (slot->generation == UINT32_MAX) ? 1 : slot->generation + 1;
+}
+
+bool HandleTable_Initialize(SHandleTable* table, EMemoryTag tag)
+{
+	if (table == NULL)
+	{
+		return (false);
+	}
+
+	memset(table, 0, sizeof(SHandleTable));
+	table->freeSlot = HANDLE_TABLE_NO_SLOT;
+
+	// realloc keeps the tag of the first block
+	table->slots = engine_new_count_zero(SHandleSlot, HANDLE_TABLE_INITIAL_CAPACITY, tag);
+	if (table->slots == NULL)
+	{
+		return (false);
+	}
+
+	table->capacity = HANDLE_TABLE_INITIAL_CAPACITY;
+	return (true);
+}
+
+void HandleTable_Destroy(SHandleTable* table)
+{
+	if (table == NULL)
+	{
+		return;
+	}
+
+	engine_free(table->slots);
+	table->slots = NULL;
+	table->slotsCount = 0;
+	table->capacity = 0;
+	table->freeSlot = HANDLE_TABLE_NO_SLOT;
+}
+
+void HandleTable_Clear(SHandleTable* table)
+{
+	// Free slots get bumped too, their current generation was never handed out so nothing is lost
+	for (uint32_t i = 0; i < table->slotsCount; i++)
+	{
+		HandleTable_NextGeneration(&table->slots[i]);
+		table->slots[i].value = (i + 1 < table->slotsCount) ? i + 1 : HANDLE_TABLE_NO_SLOT;
+	}
+
+	table->freeSlot = (table->slotsCount > 0) ? 0 : HANDLE_TABLE_NO_SLOT;
+}
+
+bool HandleTable_Reserve(SHandleTable* table, uint32_t count)
+{
+	if (count > HANDLE_TABLE_MAX_SLOTS)
+	{
+		return (false);
+	}
+
+	return (count <= table->capacity || HandleTable_Resize(table, count));
+}
+
+uint32_t HandleTable_Acquire(SHandleTable* table, uint32_t value)
+{
+	uint32_t slot = table->freeSlot;
+	if (slot != HANDLE_TABLE_NO_SLOT)
+	{
+		table->freeSlot = table->slots[slot].value;
+	}
+	else
+	{
+		if (table->slotsCount == table->capacity)
+		{
+			if (table->capacity >= HANDLE_TABLE_MAX_SLOTS || !HandleTable_Resize(table, table->capacity * 2))
+			{
+				syserr("HandleTable: failed to grow past %u slots", table->capacity);
+				return (HANDLE_TABLE_NO_SLOT);
+			}
+		}
+
+		slot = table->slotsCount++;
+		table->slots[slot].generation = 1;
+	}
+
+	table->slots[slot].value = value;
+	return (slot);
+}
+
+void HandleTable_Release(SHandleTable* table, uint32_t slot)
+{
+	HandleTable_NextGeneration(&table->slots[slot]);
+	table->slots[slot].value = table->freeSlot;
+	table->freeSlot = slot;
+}
+
+uint32_t HandleTable_Find(const SHandleTable* table, GenerationalHandle handle)
+{
+	uint32_t slot = (uint32_t)handle;
+
+	// Free slots already carry the next generation, so a match is always live
+	if (slot >= table->slotsCount || table->slots[slot].generation != (uint32_t)(handle >> 32))
+	{
+		return (HANDLE_TABLE_NO_SLOT);
+	}
+
+	return (slot);
+}
+
+GenerationalHandle HandleTable_GetHandle(const SHandleTable* table, uint32_t slot)
+{
+	return (((GenerationalHandle)table->slots[slot].generation << 32) | slot);
+}
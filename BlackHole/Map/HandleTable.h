@@ -0,0 +1,45 @@
+#ifndef __HANDLE_TABLE_H__
+#define __HANDLE_TABLE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../MemoryManager/MemoryTags.h"
+
+// Generation in the high 32 bits, slot index in the low 32. Generations start at 1, so 0 is never valid.
+typedef uint64_t GenerationalHandle;
+
+#define GENERATIONAL_HANDLE_INVALID ((GenerationalHandle)0)
+#define HANDLE_TABLE_MAX_SLOTS 0x80000000u
+#define HANDLE_TABLE_NO_SLOT UINT32_MAX
+
+typedef struct SHandleSlot
+{
+	uint32_t value; // Owner defined while live (a position in its array), next free slot while free
+	uint32_t generation; // Bumped on release, stale handles stop matching
+} SHandleSlot;
+
+// Sparse slots behind generational handles, embedded by the containers that hand them out
+typedef struct SHandleTable
+{
+	SHandleSlot* slots;
+	uint32_t slotsCount; // Slots ever handed out, free ones are chained from freeSlot
+	uint32_t capacity;
+	uint32_t freeSlot;
+} SHandleTable;
+
+bool HandleTable_Initialize(SHandleTable* table, EMemoryTag tag);
+void HandleTable_Destroy(SHandleTable* table);
+// Every handle handed out so far becomes stale
+void HandleTable_Clear(SHandleTable* table);
+bool HandleTable_Reserve(SHandleTable* table, uint32_t count);
+
+// Takes a free slot holding 'value', HANDLE_TABLE_NO_SLOT when the table cannot grow
+uint32_t HandleTable_Acquire(SHandleTable* table, uint32_t value);
+void HandleTable_Release(SHandleTable* table, uint32_t slot);
+
+// Slot of a live handle, HANDLE_TABLE_NO_SLOT otherwise
+uint32_t HandleTable_Find(const SHandleTable* table, GenerationalHandle handle);
+GenerationalHandle HandleTable_GetHandle(const SHandleTable* table, uint32_t slot);
+
+#endif // __HANDLE_TABLE_H__
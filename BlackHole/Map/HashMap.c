@@ -0,0 +1,480 @@
+#include "HashMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h> // SSE2
+#define HASH_MAP_USE_SSE2 1
+#else
+#define HASH_MAP_USE_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define HASH_MAP_CONTROL_EMPTY ((int8_t)-128) // 0b10000000
+#define HASH_MAP_CONTROL_DELETED ((int8_t)-2) // 0b11111110, full slots are 0b0xxxxxxx
+#define HASH_MAP_INITIAL_CAPACITY HASH_MAP_GROUP_WIDTH
+
+static uint32_t HashMap_TrailingZeros(uint32_t mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+// Bit i set when control byte i of the group equals 'value'
+static uint32_t HashMap_MatchByte(const int8_t* group, int8_t value)
+{
+#if HASH_MAP_USE_SSE2
+	__m128i control = _mm_load_si128((const __m128i*)group);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value)));
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < HASH_MAP_GROUP_WIDTH; i++)
+	{
+		mask |= (uint32_t)(group[i] == value) << i;
+	}
+	return (mask);
+#endif
+}
+
+// Empty and deleted are the only control values with the sign bit set
+static uint32_t HashMap_MatchEmptyOrDeleted(const int8_t* group)
+{
+#if HASH_MAP_USE_SSE2
+	return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)group));
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < HASH_MAP_GROUP_WIDTH; i++)
+	{
+		mask |= (uint32_t)(group[i] < 0) << i;
+	}
+	return (mask);
+#endif
+}
+
+static size_t HashMap_MaxLoad(size_t capacity)
+{
+	return (capacity - capacity / 8);
+}
+
+// h1 picks the first group, h2 (7 bits) goes into the control byte
+static size_t HashMap_H1(uint64_t hash)
+{
+	return (size_t)(hash >> 7);
+}
+
+static int8_t HashMap_H2(uint64_t hash)
+{
+	return (int8_t)(hash & 0x7F);
+}
+
+uint64_t HashMap_HashString(const char* key)
+{
+	// FNV-1a followed by a final mix, the low 7 bits feed the control bytes so they must be well spread
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (const unsigned char* curr = (const unsigned char*)key; *curr != '\0'; curr++)
+	{
+		hash ^= *curr;
+		hash *= 0x100000001B3ull;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	return (hash);
+}
+
+static bool HashMap_Allocate(HashMap map, size_t capacity)
+{
+	// Control bytes first (capacity is a multiple of 16, so the slots stay aligned)
+	uint8_t* memory = engine_malloc(capacity + capacity * sizeof(SHashMapSlot), map->memoryTag);
+	if (memory == NULL)
+	{
+		return (false);
+	}
+
+	map->controlBytes = (int8_t*)memory;
+	map->slots = (SHashMapSlot*)(memory + capacity);
+	map->capacity = capacity;
+	map->growthLeft = HashMap_MaxLoad(capacity);
+
+	memset(map->controlBytes, (uint8_t)HASH_MAP_CONTROL_EMPTY, capacity);
+	return (true);
+}
+
+// First empty or deleted slot on the probe sequence of 'hash'
+static size_t HashMap_FindInsertSlot(HashMap map, uint64_t hash)
+{
+	size_t groupMask = map->capacity / HASH_MAP_GROUP_WIDTH - 1;
+	size_t group = HashMap_H1(hash) & groupMask;
+
+	// Triangular probing over groups visits every group once when the count is a power of two
+	for (size_t probe = 1; ; probe++)
+	{
+		int8_t* control = map->controlBytes + group * HASH_MAP_GROUP_WIDTH;
+		uint32_t mask = HashMap_MatchEmptyOrDeleted(control);
+		if (mask != 0)
+		{
+			return (group * HASH_MAP_GROUP_WIDTH + HashMap_TrailingZeros(mask));
+		}
+
+		group = (group + probe) & groupMask;
+	}
+}
+
+static bool HashMap_Resize(HashMap map, size_t newCapacity)
+{
+	int8_t* oldControl = map->controlBytes;
+	SHashMapSlot* oldSlots = map->slots;
+	size_t oldCapacity = map->capacity;
+
+	if (!HashMap_Allocate(map, newCapacity))
+	{
+		return (false);
+	}
+
+	// Deleted markers are dropped here, only live entries move
+	for (size_t i = 0; i < oldCapacity; i++)
+	{
+		if (oldControl[i] < 0)
+		{
+			continue;
+		}
+
+		size_t slot = HashMap_FindInsertSlot(map, oldSlots[i].hash);
+		map->controlBytes[slot] = HashMap_H2(oldSlots[i].hash);
+		map->slots[slot] = oldSlots[i];
+	}
+
+	map->growthLeft -= map->elementsCount;
+
+	engine_free(oldControl);
+	return (true);
+}
+
+static SHashMapSlot* HashMap_FindSlot(HashMap map, const char* key, uint64_t hash, size_t* outIndex)
+{
+	size_t groupMask = map->capacity / HASH_MAP_GROUP_WIDTH - 1;
+	size_t group = HashMap_H1(hash) & groupMask;
+	int8_t h2 = HashMap_H2(hash);
+
+	for (size_t probe = 1; probe <= groupMask + 1; probe++)
+	{
+		int8_t* control = map->controlBytes + group * HASH_MAP_GROUP_WIDTH;
+
+		uint32_t mask = HashMap_MatchByte(control, h2);
+		while (mask != 0)
+		{
+			size_t index = group * HASH_MAP_GROUP_WIDTH + HashMap_TrailingZeros(mask);
+			SHashMapSlot* slot = &map->slots[index];
+
+			// 1 in 128 false positives reach the strcmp, interned keys compare by address
+			if (slot->hash == hash && (map->internedKeys ? slot->szKey == key : strcmp(slot->szKey, key) == 0))
+			{
+				if (outIndex != NULL)
+				{
+					*outIndex = index;
+				}
+				return (slot);
+			}
+
+			mask &= mask - 1;
+		}
+
+		// An empty slot ends the probe sequence, the key would have been placed there
+		if (HashMap_MatchByte(control, HASH_MAP_CONTROL_EMPTY) != 0)
+		{
+			return (NULL);
+		}
+
+		group = (group + probe) & groupMask;
+	}
+
+	return (NULL);
+}
+
+static bool HashMap_Create(HashMap* ppMap, EMemoryTag tag, bool internedKeys)
+{
+	if (ppMap == NULL)
+	{
+		return (false);
+	}
+
+	*ppMap = engine_new_zero(SHashMap, 1, tag);
+	HashMap map = *ppMap;
+
+	if (map == NULL)
+	{
+		syserr("Failed to Allocate HashMap Memory");
+		return (false);
+	}
+
+	map->memoryTag = tag;
+	map->internedKeys = internedKeys;
+
+	if (!HashMap_Allocate(map, HASH_MAP_INITIAL_CAPACITY))
+	{
+		syserr("Failed to Allocate HashMap table");
+		engine_delete(map);
+		*ppMap = NULL;
+		return (false);
+	}
+
+	if (!internedKeys && !MemoryPool_Initialize(&map->keyPool, tag))
+	{
+		syserr("Failed to Allocate HashMap key pool");
+		engine_free(map->controlBytes);
+		engine_delete(map);
+		*ppMap = NULL;
+		return (false);
+	}
+
+	return (true);
+}
+
+bool HashMap_Initialize(HashMap* ppMap, EMemoryTag tag)
+{
+	return HashMap_Create(ppMap, tag, false);
+}
+
+bool HashMap_InitializeInterned(HashMap* ppMap, EMemoryTag tag)
+{
+	return HashMap_Create(ppMap, tag, true);
+}
+
+void HashMap_Destroy(HashMap* ppMap)
+{
+	if (ppMap == NULL || *ppMap == NULL)
+	{
+		return;
+	}
+
+	HashMap map = *ppMap;
+
+	HashMap_Clear(map);
+
+	MemoryPool_Destroy(&map->keyPool);
+	engine_free(map->controlBytes);
+	engine_delete(map);
+
+	*ppMap = NULL;
+}
+
+static bool HashMap_InsertHashed(HashMap map, char* key, uint64_t hash, void* value)
+{
+	SHashMapSlot* existing = HashMap_FindSlot(map, key, hash, NULL);
+	if (existing != NULL) // keys match, update
+	{
+		existing->pValue = value;
+		return (true);
+	}
+
+	size_t index = HashMap_FindInsertSlot(map, hash);
+
+	// Reusing a deleted slot costs no growth, a fresh empty one does
+	if (map->growthLeft == 0 && map->controlBytes[index] == HASH_MAP_CONTROL_EMPTY)
+	{
+		// Mostly tombstones: rebuild in place, otherwise double
+		size_t newCapacity = map->capacity;
+		if (map->elementsCount * 2 >= HashMap_MaxLoad(map->capacity))
+		{
+			newCapacity *= 2;
+		}
+
+		if (!HashMap_Resize(map, newCapacity))
+		{
+			syserr("Failed to grow HashMap to %zu slots", newCapacity);
+			return (false);
+		}
+
+		index = HashMap_FindInsertSlot(map, hash);
+	}
+
+	// Interned characters already live in their StringTable
+	char* keyCopy = key;
+	if (!map->internedKeys)
+	{
+		size_t keyLength = strlen(key) + 1;
+		keyCopy = MemoryPool_Alloc(map->keyPool, keyLength);
+		if (keyCopy == NULL)
+		{
+			printf("Failed to allocate new slot key memory\n");
+			return (false);
+		}
+
+		memcpy(keyCopy, key, keyLength);
+	}
+
+	if (map->controlBytes[index] == HASH_MAP_CONTROL_EMPTY)
+	{
+		map->growthLeft--;
+	}
+
+	map->controlBytes[index] = HashMap_H2(hash);
+	map->slots[index].szKey = keyCopy;
+	map->slots[index].pValue = value;
+	map->slots[index].hash = hash;
+	map->elementsCount++;
+
+	return (true);
+}
+
+static void HashMap_DeleteHashed(HashMap map, char* key, uint64_t hash)
+{
+	size_t index = 0;
+	SHashMapSlot* slot = HashMap_FindSlot(map, key, hash, &index);
+	if (slot == NULL)
+	{
+		return;
+	}
+
+	if (!map->internedKeys)
+	{
+		MemoryPool_Free(map->keyPool, slot->szKey, strlen(slot->szKey) + 1);
+	}
+
+	slot->szKey = NULL;
+	slot->pValue = NULL;
+
+	// If the group still has an empty slot no probe ever continued past it, so the slot can be empty again
+	int8_t* group = map->controlBytes + (index & ~(size_t)(HASH_MAP_GROUP_WIDTH - 1));
+	if (HashMap_MatchByte(group, HASH_MAP_CONTROL_EMPTY) != 0)
+	{
+		map->controlBytes[index] = HASH_MAP_CONTROL_EMPTY;
+		map->growthLeft++;
+	}
+	else
+	{
+		map->controlBytes[index] = HASH_MAP_CONTROL_DELETED;
+	}
+
+	map->elementsCount--;
+}
+
+bool HashMap_Insert(HashMap map, char* key, void* value)
+{
+	if (map == NULL)
+	{
+		return (false);
+	}
+
+	if (key == NULL || value == NULL || map->internedKeys)
+	{
+		printf("Trying to insert wrong data! %p - %p", key, value);
+		return (false);
+	}
+
+	return HashMap_InsertHashed(map, key, HashMap_HashString(key), value);
+}
+
+void* HashMap_Find(HashMap map, char* key)
+{
+	if (map == NULL)
+	{
+		return (NULL);
+	}
+
+	if (key == NULL || map->internedKeys)
+	{
+		printf("Trying to search for wrong data! %p", key);
+		return (NULL);
+	}
+
+	SHashMapSlot* slot = HashMap_FindSlot(map, key, HashMap_HashString(key), NULL);
+	if (slot == NULL)
+	{
+		return (NULL);
+	}
+
+	return (slot->pValue);
+}
+
+void HashMap_Delete(HashMap map, char* key)
+{
+	if (map == NULL || key == NULL || map->internedKeys)
+	{
+		return;
+	}
+
+	HashMap_DeleteHashed(map, key, HashMap_HashString(key));
+}
+
+bool HashMap_InsertInterned(HashMap map, InternedString key, void* value)
+{
+	if (map == NULL)
+	{
+		return (false);
+	}
+
+	if (key == NULL || value == NULL || !map->internedKeys)
+	{
+		printf("Trying to insert wrong data! %p - %p", (void*)key, value);
+		return (false);
+	}
+
+	return HashMap_InsertHashed(map, (char*)key->szString, key->hash, value);
+}
+
+void* HashMap_FindInterned(HashMap map, InternedString key)
+{
+	if (map == NULL || key == NULL || !map->internedKeys)
+	{
+		return (NULL);
+	}
+
+	SHashMapSlot* slot = HashMap_FindSlot(map, key->szString, key->hash, NULL);
+	if (slot == NULL)
+	{
+		return (NULL);
+	}
+
+	return (slot->pValue);
+}
+
+void HashMap_DeleteInterned(HashMap map, InternedString key)
+{
+	if (map == NULL || key == NULL || !map->internedKeys)
+	{
+		return;
+	}
+
+	HashMap_DeleteHashed(map, (char*)key->szString, key->hash);
+}
+
+void HashMap_Clear(HashMap map)
+{
+	if (map == NULL)
+	{
+		return;
+	}
+
+	// Every key copy goes at once
+	MemoryPool_Reset(map->keyPool);
+
+	memset(map->controlBytes, (uint8_t)HASH_MAP_CONTROL_EMPTY, map->capacity);
+	map->elementsCount = 0;
+	map->growthLeft = HashMap_MaxLoad(map->capacity);
+}
+
+void HashMap_ForEach(HashMap map, fnHashMapFunc function, void* context)
+{
+	if (map == NULL || function == NULL)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < map->capacity; i++)
+	{
+		if (map->controlBytes[i] >= 0) // full
+		{
+			function(map->slots[i].szKey, map->slots[i].pValue, context);
+		}
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef __HASH_MAP_H__
+#define __HASH_MAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../Strings/StringTable.h"
+#include "../MemoryManager/MemoryPool.h"
+
+#define HASH_MAP_GROUP_WIDTH 16 // Control bytes probed at once (one SSE2 register)
+
+typedef struct SHashMapSlot
+{
+	char* szKey;
+	void* pValue;
+	uint64_t hash; // Cached so growing never rehashes the strings
+} SHashMapSlot;
+
+// Swiss table: one control byte per slot holding 7 bits of the hash (or empty/deleted),
+// lookups compare a whole group of control bytes first and only strcmp the candidates
+typedef struct SHashMap
+{
+	int8_t* controlBytes; // capacity bytes, the slots array follows in the same allocation
+	SHashMapSlot* slots;
+	size_t capacity; // Power of two, multiple of HASH_MAP_GROUP_WIDTH
+	size_t elementsCount;
+	size_t growthLeft; // Inserts into empty slots before we must grow (7/8 max load)
+	bool internedKeys; // Keys are InternedString characters: compared by address and not owned
+	MemoryPool keyPool; // Copies of the keys when they are not interned
+	EMemoryTag memoryTag;
+} SHashMap;
+
+typedef struct SHashMap* HashMap;
+
+typedef void(*fnHashMapFunc)(const char* key, void* value, void* context);
+
+bool HashMap_Initialize(HashMap* ppMap, EMemoryTag tag);
+// Keyed by InternedString handles, use the *Interned functions only
+bool HashMap_InitializeInterned(HashMap* ppMap, EMemoryTag tag);
+void HashMap_Destroy(HashMap* ppMap);
+
+bool HashMap_Insert(HashMap map, char* key, void* value);
+void* HashMap_Find(HashMap map, char* key);
+
+void HashMap_Delete(HashMap map, char* key);
+void HashMap_Clear(HashMap map);
+
+// No hashing and no strcmp: the cached hash picks the group, the address is the key
+bool HashMap_InsertInterned(HashMap map, InternedString key, void* value);
+void* HashMap_FindInterned(HashMap map, InternedString key);
+void HashMap_DeleteInterned(HashMap map, InternedString key);
+
+// Slot order, the callback must not modify the map
+void HashMap_ForEach(HashMap map, fnHashMapFunc function, void* context);
+
+uint64_t HashMap_HashString(const char* key);
+
+#endif // __HASH_MAP_H__
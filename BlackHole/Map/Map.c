@@ -1,32 +1,370 @@
 #include "Map.h"
+#include "HashMap.h"
+#include "MappedMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Profiler/Profiler.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
-#if defined(_WIN32) || defined(_WIN64)
-#define strdup _strdup
-#endif
+#define MAP_COLOR_RED 'r'
+#define MAP_COLOR_BLACK 'b'
 
-bool Map_Initialize(Map* ppMap)
+static bool Map_IsRed(MapNode node)
 {
-	if (!ppMap)
+	return (node != NULL && node->color == MAP_COLOR_RED);
+}
+
+static void Map_RotateLeft(Map map, MapNode node)
+{
+	MapNode pivot = node->rightNode;
+
+	node->rightNode = pivot->leftNode;
+	if (pivot->leftNode != NULL)
 	{
-		return (false);
+		pivot->leftNode->parentNode = node;
+	}
+
+	pivot->parentNode = node->parentNode;
+	if (node->parentNode == NULL)
+	{
+		map->headNode = pivot;
+	}
+	else if (node == node->parentNode->leftNode)
+	{
+		node->parentNode->leftNode = pivot;
+	}
+	else
+	{
+		node->parentNode->rightNode = pivot;
+	}
+
+	pivot->leftNode = node;
+	node->parentNode = pivot;
+}
+
+static void Map_RotateRight(Map map, MapNode node)
+{
+	MapNode pivot = node->leftNode;
+
+	node->leftNode = pivot->rightNode;
+	if (pivot->rightNode != NULL)
+	{
+		pivot->rightNode->parentNode = node;
+	}
+
+	pivot->parentNode = node->parentNode;
+	if (node->parentNode == NULL)
+	{
+		map->headNode = pivot;
+	}
+	else if (node == node->parentNode->rightNode)
+	{
+		node->parentNode->rightNode = pivot;
+	}
+	else
+	{
+		node->parentNode->leftNode = pivot;
+	}
+
+	pivot->rightNode = node;
+	node->parentNode = pivot;
+}
+
+// New nodes are red, walk up fixing red-red pairs by recoloring or rotating
+static void Map_InsertFixup(Map map, MapNode node)
+{
+	while (Map_IsRed(node->parentNode))
+	{
+		MapNode parent = node->parentNode;
+		MapNode grandParent = parent->parentNode; // exists, a red node is never the head
+
+		if (parent == grandParent->leftNode)
+		{
+			MapNode uncle = grandParent->rightNode;
+			if (Map_IsRed(uncle))
+			{
+				parent->color = MAP_COLOR_BLACK;
+				uncle->color = MAP_COLOR_BLACK;
+				grandParent->color = MAP_COLOR_RED;
+				node = grandParent;
+				continue;
+			}
+
+			if (node == parent->rightNode)
+			{
+				node = parent;
+				Map_RotateLeft(map, node);
+				parent = node->parentNode;
+			}
+
+			parent->color = MAP_COLOR_BLACK;
+			grandParent->color = MAP_COLOR_RED;
+			Map_RotateRight(map, grandParent);
+		}
+		else
+		{
+			MapNode uncle = grandParent->leftNode;
+			if (Map_IsRed(uncle))
+			{
+				parent->color = MAP_COLOR_BLACK;
+				uncle->color = MAP_COLOR_BLACK;
+				grandParent->color = MAP_COLOR_RED;
+				node = grandParent;
+				continue;
+			}
+
+			if (node == parent->leftNode)
+			{
+				node = parent;
+				Map_RotateRight(map, node);
+				parent = node->parentNode;
+			}
+
+			parent->color = MAP_COLOR_BLACK;
+			grandParent->color = MAP_COLOR_RED;
+			Map_RotateLeft(map, grandParent);
+		}
+	}
+
+	map->headNode->color = MAP_COLOR_BLACK;
+}
+
+// Put 'replacement' where 'node' was in its parent
+static void Map_Transplant(Map map, MapNode node, MapNode replacement)
+{
+	if (node->parentNode == NULL)
+	{
+		map->headNode = replacement;
+	}
+	else if (node == node->parentNode->leftNode)
+	{
+		node->parentNode->leftNode = replacement;
+	}
+	else
+	{
+		node->parentNode->rightNode = replacement;
+	}
+
+	if (replacement != NULL)
+	{
+		replacement->parentNode = node->parentNode;
+	}
+}
+
+// 'node' (possibly NULL) carries an extra black, push it up or absorb it by rotating
+static void Map_DeleteFixup(Map map, MapNode node, MapNode parent)
+{
+	while (node != map->headNode && !Map_IsRed(node))
+	{
+		if (node == parent->leftNode)
+		{
+			MapNode sibling = parent->rightNode;
+			if (Map_IsRed(sibling))
+			{
+				sibling->color = MAP_COLOR_BLACK;
+				parent->color = MAP_COLOR_RED;
+				Map_RotateLeft(map, parent);
+				sibling = parent->rightNode;
+			}
+
+			if (!Map_IsRed(sibling->leftNode) && !Map_IsRed(sibling->rightNode))
+			{
+				sibling->color = MAP_COLOR_RED;
+				node = parent;
+				parent = node->parentNode;
+				continue;
+			}
+
+			if (!Map_IsRed(sibling->rightNode))
+			{
+				sibling->leftNode->color = MAP_COLOR_BLACK;
+				sibling->color = MAP_COLOR_RED;
+				Map_RotateRight(map, sibling);
+				sibling = parent->rightNode;
+			}
+
+			sibling->color = parent->color;
+			parent->color = MAP_COLOR_BLACK;
+			sibling->rightNode->color = MAP_COLOR_BLACK;
+			Map_RotateLeft(map, parent);
+			node = map->headNode;
+		}
+		else
+		{
+			MapNode sibling = parent->leftNode;
+			if (Map_IsRed(sibling))
+			{
+				sibling->color = MAP_COLOR_BLACK;
+				parent->color = MAP_COLOR_RED;
+				Map_RotateRight(map, parent);
+				sibling = parent->leftNode;
+			}
+
+			if (!Map_IsRed(sibling->leftNode) && !Map_IsRed(sibling->rightNode))
+			{
+				sibling->color = MAP_COLOR_RED;
+				node = parent;
+				parent = node->parentNode;
+				continue;
+			}
+
+			if (!Map_IsRed(sibling->leftNode))
+			{
+				sibling->rightNode->color = MAP_COLOR_BLACK;
+				sibling->color = MAP_COLOR_RED;
+				Map_RotateLeft(map, sibling);
+				sibling = parent->leftNode;
+			}
+
+			sibling->color = parent->color;
+			parent->color = MAP_COLOR_BLACK;
+			sibling->leftNode->color = MAP_COLOR_BLACK;
+			Map_RotateRight(map, parent);
+			node = map->headNode;
+		}
 	}
 
+	if (node != NULL)
+	{
+		node->color = MAP_COLOR_BLACK;
+	}
+}
+
+// The key is stored right after the node, one pool block per entry
+static MapNode Map_CreateNode(Map map, const char* key)
+{
+	size_t keyLength = strlen(key) + 1;
+
+	MapNode node = MemoryPool_Alloc(map->nodePool, sizeof(SMapNode) + keyLength);
+	if (node == NULL)
+	{
+		return (NULL);
+	}
+
+	memset(node, 0, sizeof(SMapNode));
+	node->szKey = (char*)(node + 1);
+	memcpy(node->szKey, key, keyLength);
+	return (node);
+}
+
+static void Map_FreeNode(Map map, MapNode node)
+{
+	MemoryPool_Free(map->nodePool, node, sizeof(SMapNode) + strlen(node->szKey) + 1);
+}
+
+static void Map_DestroyValue(const char* key, void* value, void* context)
+{
+	(void)key;
+	((Map)context)->destructor(value);
+}
+
+static Map Map_Allocate(Map* ppMap, EMemoryTag tag)
+{
 	// Initialize with everything to Zero and NULL
-	*ppMap = calloc(1, sizeof(SMap));
+	*ppMap = engine_new_zero(SMap, 1, tag);
 	Map map = *ppMap;
 
 	if (map == NULL)
 	{
 		printf("Failed to Allocate Map Memory\n");
+		return (NULL);
+	}
+
+	map->memoryTag = tag;
+	return (map);
+}
+
+static size_t Map_GetHeightRecursive(MapNode node)
+{
+	if (node == NULL)
+	{
+		return (0);
+	}
+
+	// Balanced, so the recursion depth is bounded by the height itself
+	size_t leftHeight = Map_GetHeightRecursive(node->leftNode);
+	size_t rightHeight = Map_GetHeightRecursive(node->rightNode);
+	return (1 + (leftHeight > rightHeight ? leftHeight : rightHeight));
+}
+
+bool Map_Initialize(Map* ppMap)
+{
+	return Map_InitializeWithBackend(ppMap, MAP_BACKEND_TREE, MEM_TAG_ENGINE);
+}
+
+bool Map_InitializeWithBackend(Map* ppMap, EMapBackend backend, EMemoryTag tag)
+{
+	if (!ppMap)
+	{
+		return (false);
+	}
+
+	Map map = Map_Allocate(ppMap, tag);
+	if (map == NULL)
+	{
+		return (false);
+	}
+
+	bool initialized = (backend == MAP_BACKEND_HASH) ? HashMap_Initialize(&map->hashMap, tag) : MemoryPool_Initialize(&map->nodePool, tag);
+	if (!initialized)
+	{
+		engine_delete(map);
+		*ppMap = NULL;
 		return (false);
 	}
 
 	return (true);
 }
 
+bool Map_InitializeInterned(Map* ppMap, StringTable table, EMemoryTag tag)
+{
+	if (!ppMap || table == NULL)
+	{
+		return (false);
+	}
+
+	Map map = Map_Allocate(ppMap, tag);
+	if (map == NULL)
+	{
+		return (false);
+	}
+
+	if (!HashMap_InitializeInterned(&map->hashMap, tag))
+	{
+		engine_delete(map);
+		*ppMap = NULL;
+		return (false);
+	}
+
+	map->stringTable = table;
+	return (true);
+}
+
+bool Map_InitializeMapped(Map* ppMap, const char* szPath, EMemoryTag tag)
+{
+	if (!ppMap || szPath == NULL)
+	{
+		return (false);
+	}
+
+	Map map = Map_Allocate(ppMap, tag);
+	if (map == NULL)
+	{
+		return (false);
+	}
+
+	if (!MappedMap_Open(&map->mappedMap, szPath, tag))
+	{
+		engine_delete(map);
+		*ppMap = NULL;
+		return (false);
+	}
+
+	map->elementsCount = MappedMap_GetCount(map->mappedMap);
+	return (true);
+}
+
 void Map_Destroy(Map* ppMap)
 {
 	if (!ppMap || !*ppMap)
@@ -35,12 +373,15 @@ void Map_Destroy(Map* ppMap)
 	}
 
 	Map_Clear(*ppMap);
+	HashMap_Destroy(&(*ppMap)->hashMap);
+	MappedMap_Close(&(*ppMap)->mappedMap);
+	MemoryPool_Destroy(&(*ppMap)->nodePool);
 
-	free(*ppMap);
+	engine_delete(*ppMap);
 	*ppMap = NULL;
 }
 
-bool Map_Insert(Map map, char* key, void* value)
+static bool Map_InsertInternal(Map map, char* key, void* value)
 {
 	if (map == NULL)
 	{
@@ -53,28 +394,38 @@ bool Map_Insert(Map map, char* key, void* value)
 		return (false);
 	}
 
+	if (map->mappedMap != NULL)
+	{
+		printf("Trying to insert into a read only mapped map: %s\n", key);
+		return (false);
+	}
+
+	if (map->stringTable != NULL)
+	{
+		return Map_InsertInterned(map, StringTable_Intern(map->stringTable, key), value);
+	}
+
+	if (map->hashMap != NULL)
+	{
+		bool inserted = HashMap_Insert(map->hashMap, key, value);
+		map->elementsCount = map->hashMap->elementsCount;
+		return (inserted);
+	}
+
 	// first Check Map Head
 	if (map->headNode == NULL)
 	{
 		// Initialize Zero Head
-		MapNode newHead = calloc(1, sizeof(SMapNode));
+		MapNode newHead = Map_CreateNode(map, key);
 		if (newHead == NULL)
 		{
 			printf("Failed to allocate head memory\n");
 			return (false);
 		}
 
-		newHead->szKey = strdup(key);
-		if (newHead->szKey == NULL)
-		{
-			printf("Failed to allocate head key memory\n");
-			free(newHead);
-			return (false);
-		}
-
 		// assign value
 		newHead->pValue = value;
-		newHead->pos = 'h';
+		newHead->color = MAP_COLOR_BLACK; // the head is always black
 		map->headNode = newHead;
 		map->elementsCount++;
 
@@ -100,42 +451,43 @@ bool Map_Insert(Map map, char* key, void* value)
 	}
 
 	// create new room to insert
-	MapNode newNode = calloc(1, sizeof(SMapNode));
+	MapNode newNode = Map_CreateNode(map, key);
 	if (newNode == NULL)
 	{
 		printf("Failed to allocate new node memory\n");
 		return (false);
 	}
 
-	newNode->szKey = strdup(key);
-	if (newNode->szKey == NULL)
-	{
-		printf("Failed to allocate new node key memory\n");
-		free(newNode);
-		return (false);
-	}
-
 	newNode->pValue = value;
 	newNode->parentNode = parentNode;
+	newNode->color = MAP_COLOR_RED;
 
 	// attach node
 	if (cmp > 0)
 	{
-		newNode->pos = 'r';
 		parentNode->rightNode = newNode;
 	}
 	else
 	{
-		newNode->pos = 'l';
 		parentNode->leftNode = newNode;
 	}
 
+	Map_InsertFixup(map, newNode);
 	map->elementsCount++;
 
 	return (true);
 }
 
-void* Map_Find(Map map, char* key)
+bool Map_Insert(Map map, char* key, void* value)
+{
+	PROFILE_ZONE_BEGIN(Map_Insert);
+	bool inserted = Map_InsertInternal(map, key, value);
+	PROFILE_ZONE_END(Map_Insert);
+
+	return (inserted);
+}
+
+static void* Map_FindInternal(Map map, char* key)
 {
 	if (map == NULL)
 	{
@@ -148,6 +500,23 @@ void* Map_Find(Map map, char* key)
 		return (NULL);
 	}
 
+	if (map->mappedMap != NULL)
+	{
+		return (void*)MappedMap_Find(map->mappedMap, key, NULL);
+	}
+
+	if (map->stringTable != NULL)
+	{
+		// A string that was never interned cannot be a key
+		InternedString handle = StringTable_Find(map->stringTable, key);
+		return (handle != NULL ? HashMap_FindInterned(map->hashMap, handle) : NULL);
+	}
+
+	if (map->hashMap != NULL)
+	{
+		return HashMap_Find(map->hashMap, key);
+	}
+
 	MapNode currentNode = map->headNode;
 	int cmp = 0;
 
@@ -165,6 +534,15 @@ void* Map_Find(Map map, char* key)
 	return (NULL);
 }
 
+void* Map_Find(Map map, char* key)
+{
+	PROFILE_ZONE_BEGIN(Map_Find);
+	void* value = Map_FindInternal(map, key);
+	PROFILE_ZONE_END(Map_Find);
+
+	return (value);
+}
+
 void* Map_FindNode(Map map, char* key)
 {
 	if (map == NULL)
@@ -197,35 +575,262 @@ void* Map_FindNode(Map map, char* key)
 
 void Map_Delete(Map map, char* key)
 {
-	if (map == NULL || key == NULL)
+	if (map == NULL || key == NULL || map->mappedMap != NULL)
+	{
+		return;
+	}
+
+	if (map->stringTable != NULL)
 	{
+		Map_DeleteInterned(map, StringTable_Find(map->stringTable, key));
 		return;
 	}
 
+	if (map->hashMap != NULL)
+	{
+		HashMap_Delete(map->hashMap, key);
+		map->elementsCount = map->hashMap->elementsCount;
+		return;
+	}
+
+	MapNode node = Map_FindNode(map, key);
+	if (node == NULL)
+	{
+		return;
+	}
+
+	MapNode fixNode = NULL; // Node that moved into the removed black position
+	MapNode fixParent = NULL; // Its parent, fixNode itself can be NULL
+	char removedColor = node->color;
+
+	if (node->leftNode == NULL)
+	{
+		fixNode = node->rightNode;
+		fixParent = node->parentNode;
+		Map_Transplant(map, node, node->rightNode);
+	}
+	else if (node->rightNode == NULL)
+	{
+		fixNode = node->leftNode;
+		fixParent = node->parentNode;
+		Map_Transplant(map, node, node->leftNode);
+	}
+	else
+	{
+		// Two children: the in-order successor takes the node's place
+		MapNode successor = node->rightNode;
+		while (successor->leftNode != NULL)
+		{
+			successor = successor->leftNode;
+		}
+
+		removedColor = successor->color;
+		fixNode = successor->rightNode;
+
+		if (successor->parentNode == node)
+		{
+			fixParent = successor;
+		}
+		else
+		{
+			fixParent = successor->parentNode;
+			Map_Transplant(map, successor, successor->rightNode);
+			successor->rightNode = node->rightNode;
+			successor->rightNode->parentNode = successor;
+		}
+
+		Map_Transplant(map, node, successor);
+		successor->leftNode = node->leftNode;
+		successor->leftNode->parentNode = successor;
+		successor->color = node->color;
+	}
+
+	if (removedColor == MAP_COLOR_BLACK)
+	{
+		Map_DeleteFixup(map, fixNode, fixParent);
+	}
+
+	Map_FreeNode(map, node);
+	map->elementsCount--;
+}
+
+bool Map_InsertInterned(Map map, InternedString key, void* value)
+{
+	if (map == NULL || map->stringTable == NULL)
+	{
+		return (false);
+	}
+
+	bool inserted = HashMap_InsertInterned(map->hashMap, key, value);
+	map->elementsCount = map->hashMap->elementsCount;
+	return (inserted);
+}
+
+void* Map_FindInterned(Map map, InternedString key)
+{
+	if (map == NULL || map->stringTable == NULL)
+	{
+		return (NULL);
+	}
 
+	return HashMap_FindInterned(map->hashMap, key);
+}
+
+void Map_DeleteInterned(Map map, InternedString key)
+{
+	if (map == NULL || map->stringTable == NULL || key == NULL)
+	{
+		return;
+	}
+
+	HashMap_DeleteInterned(map->hashMap, key);
+	map->elementsCount = map->hashMap->elementsCount;
 }
 
 void Map_Clear(Map map)
 {
-	if (map == NULL)
+	if (map == NULL || map->mappedMap != NULL)
 	{
 		return;
 	}
 
-	Map_ClearRecursive(map, map->headNode);
+	if (map->destructor != NULL)
+	{
+		Map_ForEach(map, Map_DestroyValue, map);
+	}
+
+	HashMap_Clear(map->hashMap);
+
+	// Tree nodes and their keys all live in the pool: no walk, no per node free
+	MemoryPool_Reset(map->nodePool);
+
+	map->headNode = NULL;
+	map->elementsCount = 0;
+}
+
+void Map_SetDestructor(Map map, MapDestructorFunc destructor)
+{
+	if (map != NULL)
+	{
+		map->destructor = destructor;
+	}
 }
 
 void Map_ClearRecursive(Map map, MapNode node)
 {
-	if (node == NULL)
+	if (map == NULL || node == NULL)
+	{
+		return;
+	}
+
+	// A subtree alone would leave the parent pointing at freed nodes and break the red-black balance
+	if (node != map->headNode)
 	{
+		printf("Map_ClearRecursive: only the head node can be cleared\n");
 		return;
 	}
 
-	Map_ClearRecursive(map, node->leftNode);
-	Map_ClearRecursive(map, node->rightNode);
+	// Post-order without a stack: go down while there are children,
+	// free the leaf, unhook it and climb back to its parent
+	MapNode stopNode = node->parentNode;
+	MapNode currentNode = node;
 
-	free(node->szKey);
-	free(node);
+	while (currentNode != stopNode)
+	{
+		if (currentNode->leftNode != NULL)
+		{
+			currentNode = currentNode->leftNode;
+			continue;
+		}
+
+		if (currentNode->rightNode != NULL)
+		{
+			currentNode = currentNode->rightNode;
+			continue;
+		}
+
+		MapNode parentNode = currentNode->parentNode;
+		if (parentNode != stopNode)
+		{
+			if (parentNode->leftNode == currentNode)
+			{
+				parentNode->leftNode = NULL;
+			}
+			else
+			{
+				parentNode->rightNode = NULL;
+			}
+		}
+
+		if (map->destructor != NULL)
+		{
+			map->destructor(currentNode->pValue);
+		}
+
+		Map_FreeNode(map, currentNode);
+		currentNode = parentNode;
+	}
+
+	map->headNode = NULL;
+	map->elementsCount = 0;
 }
 
+size_t Map_GetHeight(Map map)
+{
+	if (map == NULL)
+	{
+		return (0);
+	}
+
+	return Map_GetHeightRecursive(map->headNode);
+}
+
+void Map_ForEach(Map map, fnMapFunc function, void* context)
+{
+	if (map == NULL || function == NULL)
+	{
+		return;
+	}
+
+	if (map->mappedMap != NULL)
+	{
+		MappedMap_ForEach(map->mappedMap, function, context);
+		return;
+	}
+
+	if (map->hashMap != NULL)
+	{
+		HashMap_ForEach(map->hashMap, function, context);
+		return;
+	}
+
+	// In-order walk through the parent links, no stack needed
+	MapNode node = map->headNode;
+	while (node != NULL && node->leftNode != NULL)
+	{
+		node = node->leftNode;
+	}
+
+	while (node != NULL)
+	{
+		function(node->szKey, node->pValue, context);
+
+		if (node->rightNode != NULL)
+		{
+			node = node->rightNode;
+			while (node->leftNode != NULL)
+			{
+				node = node->leftNode;
+			}
+		}
+		else
+		{
+			while (node->parentNode != NULL && node == node->parentNode->rightNode)
+			{
+				node = node->parentNode;
+			}
+
+			node = node->parentNode;
+		}
+	}
+}
\ No newline at end of file
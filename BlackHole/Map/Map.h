@@ -3,18 +3,28 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "../Strings/StringTable.h"
+#include "../MemoryManager/MemoryPool.h"
 
 typedef struct SMapNode* MapNode;
 typedef struct SMap* Map;
 
-typedef void(*MapDestructorFunc)();
+typedef void(*MapDestructorFunc)(void* value);
+typedef void(*fnMapFunc)(const char* key, void* value, void* context);
+
+typedef enum EMapBackend
+{
+	MAP_BACKEND_TREE = 0, // Ordered red-black tree
+	MAP_BACKEND_HASH, // Unordered Swiss table, O(1) lookups
+} EMapBackend;
 
 typedef struct SMapNode
 {
 	char* szKey;
 	void* pValue;
 
-	char pos; // r - l - h (right, left, head)
+	char color; // r - b (red, black), the tree is kept red-black balanced
 
 	MapNode leftNode; // Alphabetically smaller
 	MapNode rightNode; // Alphabetically larger
@@ -27,18 +37,47 @@ typedef struct SMap
 {
 	MapNode headNode;
 	size_t elementsCount;
-	MapDestructorFunc destructor;
+	MapDestructorFunc destructor; // Called for every value still in the map by Map_Clear and Map_Destroy
+	struct SHashMap* hashMap; // Set when created with MAP_BACKEND_HASH, the tree stays empty
+	StringTable stringTable; // Set by Map_InitializeInterned, keys are stored there once
+	struct SMappedMap* mappedMap; // Set by Map_InitializeMapped, read only
+	MemoryPool nodePool; // Tree backend: each node and its key share one pool block
+	EMemoryTag memoryTag; // Every allocation of this map is accounted under this tag
 } SMap;
 
+// Tree backend accounted under MEM_TAG_ENGINE
 bool Map_Initialize(Map* ppMap);
+bool Map_InitializeWithBackend(Map* ppMap, EMapBackend backend, EMemoryTag tag);
+// Hash map keyed by handles from 'table' (which must outlive the map).
+// Map_Insert/Find/Delete still accept plain strings and intern/look them up first.
+bool Map_InitializeInterned(Map* ppMap, StringTable table, EMemoryTag tag);
+// Read only view of a file written by MappedMap_Write: no parsing and no per key allocation.
+// Map_Find returns pointers to the value bytes inside the mapping.
+bool Map_InitializeMapped(Map* ppMap, const char* szPath, EMemoryTag tag);
 void Map_Destroy(Map* ppMap);
 
 bool Map_Insert(Map map, char* key, void* value);
 void* Map_Find(Map map, char* key);
-void* Map_FindNode(Map map, char* key);
+void* Map_FindNode(Map map, char* key); // Tree backend only, hash maps have no nodes
 
 void Map_Delete(Map map, char* key);
+// Runs the destructor over the values, then drops every node with one pool reset
 void Map_Clear(Map map);
+
+void Map_SetDestructor(Map map, MapDestructorFunc destructor);
+
+// Tree: key order, other backends: storage order. The callback must not modify the map.
+void Map_ForEach(Map map, fnMapFunc function, void* context);
+
+// Interned maps only: pointer compare, no hashing and no strcmp
+bool Map_InsertInterned(Map map, InternedString key, void* value);
+void* Map_FindInterned(Map map, InternedString key);
+void Map_DeleteInterned(Map map, InternedString key);
+// Frees the tree node by node (post-order through the parent links, constant stack) and empties the map.
+// 'node' must be the head node, Map_Clear is faster as it resets the node pool at once.
 void Map_ClearRecursive(Map map, MapNode node);
 
+// Longest root to leaf path, stays under 2 * log2(n + 1)
+size_t Map_GetHeight(Map map);
+
 #endif // __MAP_H__
\ No newline at end of file
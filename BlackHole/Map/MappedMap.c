@@ -0,0 +1,430 @@
+#include "MappedMap.h"
+#include "HashMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#endif
+
+typedef struct SMappedMapEntry
+{
+	const char* szKey;
+	uint64_t hash;
+	uint32_t keyLength;
+	uint32_t keyOffset;
+	const void* pValueBytes;
+	uint64_t valueSize;
+	uint64_t valueOffset;
+} SMappedMapEntry;
+
+typedef struct SMappedMapWriter
+{
+	SMappedMapEntry* entries;
+	size_t entriesCount;
+	size_t entriesCapacity;
+	fnMapValueBytes valueBytes;
+	void* context;
+} SMappedMapWriter;
+
+static uint64_t MappedMap_AlignValue(uint64_t offset)
+{
+	return (offset + MAPPED_MAP_VALUE_ALIGNMENT - 1) & ~(uint64_t)(MAPPED_MAP_VALUE_ALIGNMENT - 1);
+}
+
+// Index order: hash first, the key bytes only break ties
+static int MappedMap_Compare(uint64_t hashA, const char* keyA, uint32_t lengthA, uint64_t hashB, const char* keyB, uint32_t lengthB)
+{
+	if (hashA != hashB)
+	{
+		return (hashA < hashB ? -1 : 1);
+	}
+
+	int cmp = memcmp(keyA, keyB, lengthA < lengthB ? lengthA : lengthB);
+	if (cmp != 0)
+	{
+		return (cmp);
+	}
+
+	return (lengthA < lengthB ? -1 : (lengthA > lengthB ? 1 : 0));
+}
+
+static int MappedMap_CompareKeys(const void* pFirst, const void* pSecond)
+{
+	return strcmp(((const SMappedMapEntry*)pFirst)->szKey, ((const SMappedMapEntry*)pSecond)->szKey);
+}
+
+static int MappedMap_CompareIndex(const void* pFirst, const void* pSecond)
+{
+	const SMappedMapEntry* first = (const SMappedMapEntry*)pFirst;
+	const SMappedMapEntry* second = (const SMappedMapEntry*)pSecond;
+
+	return MappedMap_Compare(first->hash, first->szKey, first->keyLength, second->hash, second->szKey, second->keyLength);
+}
+
+static void MappedMap_CollectEntry(const char* key, void* value, void* context)
+{
+	SMappedMapWriter* writer = (SMappedMapWriter*)context;
+	if (writer->entriesCount == writer->entriesCapacity)
+	{
+		return; // the map changed under us, Write reports it
+	}
+
+	SMappedMapEntry* entry = &writer->entries[writer->entriesCount++];
+	entry->szKey = key;
+	entry->hash = HashMap_HashString(key);
+	entry->keyLength = (uint32_t)strlen(key);
+	entry->valueSize = writer->valueBytes(value, &entry->pValueBytes, writer->context);
+}
+
+// In-order walk of the implicit tree: sorted[i] lands where a binary search visits it,
+// so the first levels of every lookup share the same few cache lines
+static size_t MappedMap_BuildEytzinger(const SMappedMapEntry* sorted, size_t sortedIndex, SMappedMapRecord* records, size_t k, size_t count)
+{
+	if (k > count)
+	{
+		return (sortedIndex);
+	}
+
+	sortedIndex = MappedMap_BuildEytzinger(sorted, sortedIndex, records, 2 * k, count);
+
+	const SMappedMapEntry* entry = &sorted[sortedIndex++];
+	SMappedMapRecord* record = &records[k - 1];
+	record->hash = entry->hash;
+	record->keyOffset = entry->keyOffset;
+	record->keyLength = entry->keyLength;
+	record->valueOffset = entry->valueOffset;
+	record->valueSize = entry->valueSize;
+
+	return MappedMap_BuildEytzinger(sorted, sortedIndex, records, 2 * k + 1, count);
+}
+
+// Assigns key/value offsets in key order and builds the index
+static bool MappedMap_BuildLayout(SMappedMapWriter* writer, SMappedMapHeader* header, SMappedMapEntry* keyOrder, SMappedMapRecord* records)
+{
+	size_t count = writer->entriesCount;
+	if (count > 0)
+	{
+		qsort(writer->entries, count, sizeof(SMappedMapEntry), MappedMap_CompareKeys);
+	}
+
+	header->magic = MAPPED_MAP_MAGIC;
+	header->version = MAPPED_MAP_VERSION;
+	header->elementsCount = count;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		SMappedMapEntry* entry = &writer->entries[i];
+		if (header->keysSize + entry->keyLength + 1 > UINT32_MAX)
+		{
+			syserr("Mapped map keys do not fit in 4GB");
+			return (false);
+		}
+
+		entry->keyOffset = (uint32_t)header->keysSize;
+		header->keysSize += entry->keyLength + 1;
+
+		header->valuesSize = MappedMap_AlignValue(header->valuesSize);
+		entry->valueOffset = header->valuesSize;
+		header->valuesSize += entry->valueSize;
+	}
+
+	header->indexOffset = sizeof(SMappedMapHeader);
+	header->keysOffset = header->indexOffset + count * sizeof(SMappedMapRecord);
+	header->valuesOffset = MappedMap_AlignValue(header->keysOffset + header->keysSize);
+	header->fileSize = MappedMap_AlignValue(header->valuesOffset + header->valuesSize);
+
+	if (count > 0)
+	{
+		memcpy(keyOrder, writer->entries, count * sizeof(SMappedMapEntry));
+		qsort(writer->entries, count, sizeof(SMappedMapEntry), MappedMap_CompareIndex);
+		MappedMap_BuildEytzinger(writer->entries, 0, records, 1, count);
+	}
+
+	return (true);
+}
+
+// Swaps the finished image in, a reader that still maps the old file keeps its pages
+static bool MappedMap_ReplaceFile(const char* szTempPath, const char* szPath)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	return (MoveFileExA(szTempPath, szPath, MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+	return (rename(szTempPath, szPath) == 0);
+#endif
+}
+
+// Writes next to the target then renames over it: the previous image is never truncated,
+// and a crash or a full disk half way leaves it intact
+static bool MappedMap_WriteFile(const char* szPath, const SMappedMapHeader* header, const SMappedMapRecord* records, const SMappedMapEntry* keyOrder)
+{
+	size_t pathLength = strlen(szPath);
+	char* szTempPath = engine_malloc(pathLength + sizeof(".tmp"), MEM_TAG_STRINGS);
+	if (szTempPath == NULL)
+	{
+		syserr("Failed to Allocate Memory for the path of %s", szPath);
+		return (false);
+	}
+
+	memcpy(szTempPath, szPath, pathLength);
+	memcpy(szTempPath + pathLength, ".tmp", sizeof(".tmp"));
+
+	FILE* pFile = fopen(szTempPath, "wb");
+	if (pFile == NULL)
+	{
+		syserr("Failed to open %s for writing", szTempPath);
+		engine_free(szTempPath);
+		return (false);
+	}
+
+	static const uint8_t zeroes[MAPPED_MAP_VALUE_ALIGNMENT] = { 0 };
+	size_t count = (size_t)header->elementsCount;
+	bool written = fwrite(header, sizeof(SMappedMapHeader), 1, pFile) == 1;
+
+	if (written && count > 0)
+	{
+		written = fwrite(records, sizeof(SMappedMapRecord), count, pFile) == count;
+	}
+
+	for (size_t i = 0; written && i < count; i++)
+	{
+		written = fwrite(keyOrder[i].szKey, 1, keyOrder[i].keyLength + 1, pFile) == keyOrder[i].keyLength + 1;
+	}
+
+	uint64_t position = header->keysOffset + header->keysSize;
+	for (size_t i = 0; written && i <= count; i++)
+	{
+		// pad up to the next value (or the end of the file)
+		uint64_t target = (i < count) ? header->valuesOffset + keyOrder[i].valueOffset : header->fileSize;
+		written = fwrite(zeroes, 1, (size_t)(target - position), pFile) == target - position;
+		position = target;
+
+		if (written && i < count && keyOrder[i].valueSize > 0)
+		{
+			written = fwrite(keyOrder[i].pValueBytes, 1, (size_t)keyOrder[i].valueSize, pFile) == keyOrder[i].valueSize;
+			position += keyOrder[i].valueSize;
+		}
+	}
+
+	if (fclose(pFile) != 0)
+	{
+		written = false;
+	}
+
+	if (!written)
+	{
+		syserr("Failed to write %s", szTempPath);
+		remove(szTempPath);
+	}
+	else if (!MappedMap_ReplaceFile(szTempPath, szPath))
+	{
+		syserr("Failed to replace %s with %s", szPath, szTempPath);
+		remove(szTempPath);
+		written = false;
+	}
+
+	engine_free(szTempPath);
+	return (written);
+}
+
+bool MappedMap_Write(Map map, const char* szPath, fnMapValueBytes valueBytes, void* context)
+{
+	if (map == NULL || szPath == NULL || valueBytes == NULL)
+	{
+		return (false);
+	}
+
+	SMappedMapWriter writer = { 0 };
+	writer.entriesCapacity = map->elementsCount;
+	writer.valueBytes = valueBytes;
+	writer.context = context;
+
+	size_t count = map->elementsCount;
+	SMappedMapEntry* keyOrder = NULL;
+	SMappedMapRecord* records = NULL;
+
+	if (count > 0)
+	{
+		writer.entries = engine_new_count_zero(SMappedMapEntry, count, map->memoryTag);
+		keyOrder = engine_new_count_zero(SMappedMapEntry, count, map->memoryTag);
+		records = engine_new_count_zero(SMappedMapRecord, count, map->memoryTag);
+
+		if (writer.entries == NULL || keyOrder == NULL || records == NULL)
+		{
+			syserr("Failed to allocate mapped map writer memory");
+			engine_free(writer.entries);
+			engine_free(keyOrder);
+			engine_free(records);
+			return (false);
+		}
+	}
+
+	Map_ForEach(map, MappedMap_CollectEntry, &writer);
+
+	SMappedMapHeader header = { 0 };
+	bool result = (writer.entriesCount == count);
+
+	if (!result)
+	{
+		syserr("Map changed while being written to %s", szPath);
+	}
+	else
+	{
+		result = MappedMap_BuildLayout(&writer, &header, keyOrder, records)
+			&& MappedMap_WriteFile(szPath, &header, records, keyOrder);
+	}
+
+	engine_free(writer.entries);
+	engine_free(keyOrder);
+	engine_free(records);
+	return (result);
+}
+
+static bool MappedMap_IsSectionValid(uint64_t offset, uint64_t size, uint64_t fileSize)
+{
+	return (offset <= fileSize && size <= fileSize - offset);
+}
+
+bool MappedMap_Open(MappedMap* ppMap, const char* szPath, EMemoryTag tag)
+{
+	if (!ppMap || szPath == NULL)
+	{
+		return (false);
+	}
+
+	*ppMap = engine_new_zero(SMappedMap, 1, tag);
+	MappedMap map = *ppMap;
+
+	if (map == NULL)
+	{
+		syserr("Failed to Allocate MappedMap Memory");
+		return (false);
+	}
+
+	if (!MappedFile_Open(&map->file, szPath, tag))
+	{
+		MappedMap_Close(ppMap);
+		return (false);
+	}
+
+	const SMappedMapHeader* header = (const SMappedMapHeader*)map->file->pData;
+	uint64_t fileSize = map->file->size;
+
+	bool valid = fileSize >= sizeof(SMappedMapHeader)
+		&& header->magic == MAPPED_MAP_MAGIC
+		&& header->version == MAPPED_MAP_VERSION
+		&& header->fileSize == fileSize
+		&& header->indexOffset % sizeof(uint64_t) == 0
+		&& header->valuesOffset % MAPPED_MAP_VALUE_ALIGNMENT == 0
+		&& header->elementsCount <= fileSize / sizeof(SMappedMapRecord)
+		&& MappedMap_IsSectionValid(header->indexOffset, header->elementsCount * sizeof(SMappedMapRecord), fileSize)
+		&& MappedMap_IsSectionValid(header->keysOffset, header->keysSize, fileSize)
+		&& MappedMap_IsSectionValid(header->valuesOffset, header->valuesSize, fileSize);
+
+	if (!valid)
+	{
+		syserr("%s is not a valid mapped map", szPath);
+		MappedMap_Close(ppMap);
+		return (false);
+	}
+
+	const uint8_t* pBase = (const uint8_t*)map->file->pData;
+	map->header = header;
+	map->records = (const SMappedMapRecord*)(pBase + header->indexOffset);
+	map->keys = (const char*)(pBase + header->keysOffset);
+	map->values = pBase + header->valuesOffset;
+
+	return (true);
+}
+
+void MappedMap_Close(MappedMap* ppMap)
+{
+	if (!ppMap || !*ppMap)
+	{
+		return;
+	}
+
+	MappedFile_Close(&(*ppMap)->file);
+
+	engine_delete(*ppMap);
+	*ppMap = NULL;
+}
+
+// Records are only trusted as far as the header: a corrupted one reads as missing
+static bool MappedMap_IsRecordValid(MappedMap map, const SMappedMapRecord* record)
+{
+	// Keys are handed out as C strings, the terminator has to be inside the section too
+	return ((uint64_t)record->keyOffset + record->keyLength < map->header->keysSize
+		&& map->keys[(uint64_t)record->keyOffset + record->keyLength] == '\0'
+		&& MappedMap_IsSectionValid(record->valueOffset, record->valueSize, map->header->valuesSize));
+}
+
+const void* MappedMap_Find(MappedMap map, const char* key, uint64_t* pValueSize)
+{
+	if (map == NULL || key == NULL)
+	{
+		return (NULL);
+	}
+
+	uint64_t hash = HashMap_HashString(key);
+	uint32_t keyLength = (uint32_t)strlen(key);
+	size_t count = (size_t)map->header->elementsCount;
+	size_t k = 1;
+
+	while (k <= count)
+	{
+		// the four grandchildren sit in the next two cache lines
+		if (4 * k <= count)
+		{
+			_mm_prefetch((const char*)&map->records[4 * k - 1], _MM_HINT_T0);
+		}
+
+		const SMappedMapRecord* record = &map->records[k - 1];
+		int cmp = (record->hash != hash) ? (record->hash < hash ? -1 : 1) : 0;
+
+		if (cmp == 0)
+		{
+			if (!MappedMap_IsRecordValid(map, record))
+			{
+				return (NULL);
+			}
+
+			cmp = MappedMap_Compare(record->hash, map->keys + record->keyOffset, record->keyLength, hash, key, keyLength);
+			if (cmp == 0)
+			{
+				if (pValueSize != NULL)
+				{
+					*pValueSize = record->valueSize;
+				}
+
+				return (map->values + record->valueOffset);
+			}
+		}
+
+		k = 2 * k + (cmp < 0);
+	}
+
+	return (NULL);
+}
+
+void MappedMap_ForEach(MappedMap map, fnMapFunc function, void* context)
+{
+	if (map == NULL || function == NULL)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < (size_t)map->header->elementsCount; i++)
+	{
+		const SMappedMapRecord* record = &map->records[i];
+		if (MappedMap_IsRecordValid(map, record))
+		{
+			function(map->keys + record->keyOffset, (void*)(map->values + record->valueOffset), context);
+		}
+	}
+}
+
+size_t MappedMap_GetCount(MappedMap map)
+{
+	return (map != NULL ? (size_t)map->header->elementsCount : 0);
+}
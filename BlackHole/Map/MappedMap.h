@@ -0,0 +1,68 @@
+#ifndef __MAPPED_MAP_H__
+#define __MAPPED_MAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "Map.h"
+#include "../IO/MappedFile.h"
+
+// Flat, pointer free image of a Map that is used straight from a read only mapping.
+// Layout: header | records (Eytzinger order of (hash, key)) | sorted NUL terminated keys | values.
+// Offsets are relative to their section, integers are little endian (x64 only, like the rest of the engine).
+// The index uses HashMap_HashString: changing that hash must bump MAPPED_MAP_VERSION.
+
+#define MAPPED_MAP_MAGIC 0x4D4D4842 // "BHMM"
+#define MAPPED_MAP_VERSION 1
+#define MAPPED_MAP_VALUE_ALIGNMENT 16
+
+typedef struct SMappedMapHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t elementsCount;
+	uint64_t indexOffset;
+	uint64_t keysOffset;
+	uint64_t keysSize;
+	uint64_t valuesOffset;
+	uint64_t valuesSize;
+	uint64_t fileSize;
+} SMappedMapHeader;
+
+// Two records per cache line, the key bytes are only touched on a hash match
+typedef struct SMappedMapRecord
+{
+	uint64_t hash;
+	uint32_t keyOffset;
+	uint32_t keyLength;
+	uint64_t valueOffset;
+	uint64_t valueSize;
+} SMappedMapRecord;
+
+typedef struct SMappedMap
+{
+	MappedFile file;
+	const SMappedMapHeader* header;
+	const SMappedMapRecord* records;
+	const char* keys;
+	const uint8_t* values;
+} SMappedMap;
+
+typedef struct SMappedMap* MappedMap;
+
+// Returns the bytes to store for 'value', they are copied into the file
+typedef uint64_t(*fnMapValueBytes)(void* value, const void** ppBytes, void* context);
+
+bool MappedMap_Write(Map map, const char* szPath, fnMapValueBytes valueBytes, void* context);
+
+// Checks the header only, nothing is parsed or copied
+bool MappedMap_Open(MappedMap* ppMap, const char* szPath, EMemoryTag tag);
+void MappedMap_Close(MappedMap* ppMap);
+
+// Points into the mapping (read only, 16 bytes aligned), NULL when missing
+const void* MappedMap_Find(MappedMap map, const char* key, uint64_t* pValueSize);
+void MappedMap_ForEach(MappedMap map, fnMapFunc function, void* context);
+
+size_t MappedMap_GetCount(MappedMap map);
+
+#endif // __MAPPED_MAP_H__
@@ -0,0 +1,588 @@
+#include "RadixMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+#include <stdio.h>
+#include <string.h>
+
+#define RADIX_MAP_MIN_CHILDREN 4
+#define RADIX_MAP_MIN_KEY_BUFFER 256
+
+static RadixMapNode RadixMap_CreateNode(RadixMap map, const char* edge, uint32_t edgeLength)
+{
+	RadixMapNode node = (RadixMapNode)MemoryPool_Alloc(map->nodePool, sizeof(SRadixMapNode) + edgeLength);
+	if (node == NULL)
+	{
+		return (NULL);
+	}
+
+	memset(node, 0, sizeof(SRadixMapNode));
+	node->edgeLength = edgeLength;
+	memcpy(node->edge, edge, edgeLength);
+
+	return (node);
+}
+
+static void RadixMap_FreeNode(RadixMap map, RadixMapNode node)
+{
+	if (node->children != NULL)
+	{
+		MemoryPool_Free(map->nodePool, node->children, node->childrenCapacity * sizeof(RadixMapNode));
+	}
+
+	MemoryPool_Free(map->nodePool, node, sizeof(SRadixMapNode) + node->edgeLength);
+}
+
+// Moves value and children of 'source' into 'destination' and releases 'source'
+static void RadixMap_MoveNode(RadixMap map, RadixMapNode destination, RadixMapNode source)
+{
+	destination->children = source->children;
+	destination->childrenCount = source->childrenCount;
+	destination->childrenCapacity = source->childrenCapacity;
+	destination->pValue = source->pValue;
+
+	source->children = NULL;
+	RadixMap_FreeNode(map, source);
+}
+
+static void RadixMap_FreeSubtree(RadixMap map, RadixMapNode node, size_t* pValuesCount)
+{
+	for (uint32_t i = 0; i < node->childrenCount; i++)
+	{
+		RadixMap_FreeSubtree(map, node->children[i], pValuesCount);
+	}
+
+	if (node->pValue != NULL)
+	{
+		(*pValuesCount)++;
+	}
+
+	RadixMap_FreeNode(map, node);
+}
+
+static bool RadixMap_ReserveChildren(RadixMap map, RadixMapNode node, uint32_t capacity)
+{
+	if (capacity <= node->childrenCapacity)
+	{
+		return (true);
+	}
+
+	uint32_t newCapacity = node->childrenCapacity ? node->childrenCapacity : RADIX_MAP_MIN_CHILDREN;
+	while (newCapacity < capacity)
+	{
+		newCapacity *= 2;
+	}
+
+	RadixMapNode* newChildren = (RadixMapNode*)MemoryPool_Alloc(map->nodePool, newCapacity * sizeof(RadixMapNode));
+	if (newChildren == NULL)
+	{
+		return (false);
+	}
+
+	if (node->children != NULL)
+	{
+		memcpy(newChildren, node->children, node->childrenCount * sizeof(RadixMapNode));
+		MemoryPool_Free(map->nodePool, node->children, node->childrenCapacity * sizeof(RadixMapNode));
+	}
+
+	node->children = newChildren;
+	node->childrenCapacity = newCapacity;
+	return (true);
+}
+
+// Binary search on the first edge byte, 'pIndex' receives the match or the insertion point
+static bool RadixMap_FindChildIndex(RadixMapNode node, unsigned char firstByte, uint32_t* pIndex)
+{
+	uint32_t low = 0;
+	uint32_t high = node->childrenCount;
+
+	while (low < high)
+	{
+		uint32_t middle = low + (high - low) / 2;
+		unsigned char middleByte = (unsigned char)node->children[middle]->edge[0];
+
+		if (middleByte == firstByte)
+		{
+			*pIndex = middle;
+			return (true);
+		}
+
+		if (middleByte < firstByte)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	*pIndex = low;
+	return (false);
+}
+
+static void RadixMap_InsertChildAt(RadixMapNode node, uint32_t index, RadixMapNode child)
+{
+	memmove(&node->children[index + 1], &node->children[index], (node->childrenCount - index) * sizeof(RadixMapNode));
+	node->children[index] = child;
+	node->childrenCount++;
+}
+
+static void RadixMap_RemoveChildAt(RadixMapNode node, uint32_t index)
+{
+	memmove(&node->children[index], &node->children[index + 1], (node->childrenCount - index - 1) * sizeof(RadixMapNode));
+	node->childrenCount--;
+}
+
+static uint32_t RadixMap_CommonPrefix(const char* first, uint32_t firstLength, const char* second, size_t secondLength)
+{
+	uint32_t limit = (secondLength < firstLength) ? (uint32_t)secondLength : firstLength;
+	uint32_t length = 0;
+
+	while (length < limit && first[length] == second[length])
+	{
+		length++;
+	}
+
+	return (length);
+}
+
+// Fuses parent->children[index] with its only child, keeping the tree compressed
+static void RadixMap_MergeChild(RadixMap map, RadixMapNode parent, uint32_t index)
+{
+	RadixMapNode node = parent->children[index];
+	RadixMapNode child = node->children[0];
+
+	RadixMapNode merged = RadixMap_CreateNode(map, node->edge, node->edgeLength + child->edgeLength);
+	if (merged == NULL)
+	{
+		return; // still a valid tree, just not fully compressed
+	}
+
+	memcpy(merged->edge + node->edgeLength, child->edge, child->edgeLength);
+	RadixMap_MoveNode(map, merged, child);
+	RadixMap_FreeNode(map, node);
+
+	parent->children[index] = merged;
+}
+
+// Called once parent->children[index] lost its value or its children
+static void RadixMap_Compact(RadixMap map, RadixMapNode grandParent, uint32_t parentIndex, RadixMapNode parent, uint32_t index)
+{
+	RadixMapNode node = parent->children[index];
+	if (node->pValue != NULL)
+	{
+		return;
+	}
+
+	if (node->childrenCount == 1)
+	{
+		RadixMap_MergeChild(map, parent, index);
+		return;
+	}
+
+	if (node->childrenCount > 1)
+	{
+		return;
+	}
+
+	RadixMap_FreeNode(map, node);
+	RadixMap_RemoveChildAt(parent, index);
+
+	if (grandParent != NULL && parent->pValue == NULL && parent->childrenCount == 1)
+	{
+		RadixMap_MergeChild(map, grandParent, parentIndex);
+	}
+}
+
+static bool RadixMap_EnsureKeyBuffer(RadixMap map, size_t length)
+{
+	if (length <= map->keyBufferCapacity)
+	{
+		return (true);
+	}
+
+	size_t newCapacity = map->keyBufferCapacity ? map->keyBufferCapacity : RADIX_MAP_MIN_KEY_BUFFER;
+	while (newCapacity < length)
+	{
+		newCapacity *= 2;
+	}
+
+	char* newBuffer = (char*)engine_malloc(newCapacity, map->memoryTag);
+	if (newBuffer == NULL)
+	{
+		return (false);
+	}
+
+	if (map->keyBuffer != NULL)
+	{
+		memcpy(newBuffer, map->keyBuffer, map->keyBufferCapacity);
+		engine_free(map->keyBuffer);
+	}
+
+	map->keyBuffer = newBuffer;
+	map->keyBufferCapacity = newCapacity;
+	return (true);
+}
+
+static void RadixMap_VisitSubtree(RadixMap map, RadixMapNode node, size_t keyLength, fnRadixMapFunc function, void* context)
+{
+	size_t newLength = keyLength + node->edgeLength;
+	if (!RadixMap_EnsureKeyBuffer(map, newLength + 1))
+	{
+		syserr("Failed to allocate radix map key buffer");
+		return;
+	}
+
+	memcpy(map->keyBuffer + keyLength, node->edge, node->edgeLength);
+
+	if (node->pValue != NULL)
+	{
+		map->keyBuffer[newLength] = '\0';
+		function(map->keyBuffer, node->pValue, context);
+	}
+
+	for (uint32_t i = 0; i < node->childrenCount; i++)
+	{
+		RadixMap_VisitSubtree(map, node->children[i], newLength, function, context);
+	}
+}
+
+typedef struct SRadixMapPath
+{
+	RadixMapNode grandParent;
+	uint32_t parentIndex;
+	RadixMapNode parent;
+	uint32_t index;
+	size_t keyLength; // bytes of the key consumed before the found node's edge
+} SRadixMapPath;
+
+// Finds the top node whose subtree holds every key starting with 'prefix'.
+// With 'exact' set the key has to end exactly at that node.
+static RadixMapNode RadixMap_FindNode(RadixMap map, const char* key, bool exact, SRadixMapPath* pPath)
+{
+	memset(pPath, 0, sizeof(SRadixMapPath));
+
+	RadixMapNode node = map->rootNode;
+	size_t remaining = strlen(key);
+	size_t consumed = 0;
+
+	while (remaining > 0)
+	{
+		uint32_t index = 0;
+		if (!RadixMap_FindChildIndex(node, (unsigned char)key[consumed], &index))
+		{
+			return (NULL);
+		}
+
+		RadixMapNode child = node->children[index];
+		uint32_t common = RadixMap_CommonPrefix(child->edge, child->edgeLength, key + consumed, remaining);
+
+		pPath->grandParent = pPath->parent;
+		pPath->parentIndex = pPath->index;
+		pPath->parent = node;
+		pPath->index = index;
+		pPath->keyLength = consumed;
+
+		if (common == child->edgeLength)
+		{
+			node = child;
+			consumed += common;
+			remaining -= common;
+		}
+		else if (!exact && common == remaining)
+		{
+			return (child); // prefix ends inside this edge
+		}
+		else
+		{
+			return (NULL);
+		}
+	}
+
+	return (node);
+}
+
+bool RadixMap_Initialize(RadixMap* ppMap, EMemoryTag tag)
+{
+	if (!ppMap)
+	{
+		return (false);
+	}
+
+	*ppMap = engine_new_zero(SRadixMap, 1, tag);
+	RadixMap map = *ppMap;
+
+	if (map == NULL)
+	{
+		syserr("Failed to Allocate RadixMap Memory");
+		return (false);
+	}
+
+	map->memoryTag = tag;
+
+	if (!MemoryPool_Initialize(&map->nodePool, tag))
+	{
+		engine_delete(map);
+		*ppMap = NULL;
+		return (false);
+	}
+
+	map->rootNode = RadixMap_CreateNode(map, "", 0);
+	if (map->rootNode == NULL)
+	{
+		MemoryPool_Destroy(&map->nodePool);
+		engine_delete(map);
+		*ppMap = NULL;
+		return (false);
+	}
+
+	return (true);
+}
+
+void RadixMap_Destroy(RadixMap* ppMap)
+{
+	if (!ppMap || !*ppMap)
+	{
+		return;
+	}
+
+	RadixMap map = *ppMap;
+
+	// every node lives in the pool
+	MemoryPool_Destroy(&map->nodePool);
+
+	if (map->keyBuffer != NULL)
+	{
+		engine_free(map->keyBuffer);
+	}
+
+	engine_delete(map);
+	*ppMap = NULL;
+}
+
+bool RadixMap_Insert(RadixMap map, const char* key, void* value)
+{
+	if (map == NULL)
+	{
+		return (false);
+	}
+
+	if (key == NULL || value == NULL)
+	{
+		syserr("Trying to insert wrong data! %p - %p", key, value);
+		return (false);
+	}
+
+	RadixMapNode node = map->rootNode;
+	size_t remaining = strlen(key);
+
+	while (remaining > 0)
+	{
+		uint32_t index = 0;
+		if (!RadixMap_FindChildIndex(node, (unsigned char)*key, &index))
+		{
+			RadixMapNode leaf = RadixMap_CreateNode(map, key, (uint32_t)remaining);
+			if (leaf == NULL || !RadixMap_ReserveChildren(map, node, node->childrenCount + 1))
+			{
+				if (leaf != NULL)
+				{
+					RadixMap_FreeNode(map, leaf);
+				}
+
+				syserr("Failed to allocate radix map node");
+				return (false);
+			}
+
+			leaf->pValue = value;
+			RadixMap_InsertChildAt(node, index, leaf);
+			map->elementsCount++;
+			return (true);
+		}
+
+		RadixMapNode child = node->children[index];
+		uint32_t common = RadixMap_CommonPrefix(child->edge, child->edgeLength, key, remaining);
+
+		if (common == child->edgeLength)
+		{
+			node = child;
+			key += common;
+			remaining -= common;
+			continue;
+		}
+
+		// Split the edge: node -> middle(common part) -> tail(rest of the old edge) [+ leaf(rest of the key)]
+		RadixMapNode middle = RadixMap_CreateNode(map, key, common);
+		RadixMapNode tail = RadixMap_CreateNode(map, child->edge + common, child->edgeLength - common);
+		RadixMapNode leaf = (common < remaining) ? RadixMap_CreateNode(map, key + common, (uint32_t)(remaining - common)) : NULL;
+
+		if (middle == NULL || tail == NULL || (common < remaining && leaf == NULL) || !RadixMap_ReserveChildren(map, middle, 2))
+		{
+			if (middle != NULL)
+			{
+				RadixMap_FreeNode(map, middle);
+			}
+
+			if (tail != NULL)
+			{
+				RadixMap_FreeNode(map, tail);
+			}
+
+			if (leaf != NULL)
+			{
+				RadixMap_FreeNode(map, leaf);
+			}
+
+			syserr("Failed to allocate radix map node");
+			return (false);
+		}
+
+		RadixMap_MoveNode(map, tail, child);
+		middle->children[middle->childrenCount++] = tail;
+
+		if (leaf != NULL)
+		{
+			leaf->pValue = value;
+			uint32_t leafIndex = 0;
+			RadixMap_FindChildIndex(middle, (unsigned char)leaf->edge[0], &leafIndex);
+			RadixMap_InsertChildAt(middle, leafIndex, leaf);
+		}
+		else
+		{
+			middle->pValue = value;
+		}
+
+		node->children[index] = middle;
+		map->elementsCount++;
+		return (true);
+	}
+
+	if (node->pValue == NULL)
+	{
+		map->elementsCount++;
+	}
+
+	node->pValue = value;
+	return (true);
+}
+
+void* RadixMap_Find(RadixMap map, const char* key)
+{
+	if (map == NULL || key == NULL)
+	{
+		return (NULL);
+	}
+
+	SRadixMapPath path;
+	RadixMapNode node = RadixMap_FindNode(map, key, true, &path);
+
+	return (node != NULL ? node->pValue : NULL);
+}
+
+void RadixMap_Delete(RadixMap map, const char* key)
+{
+	if (map == NULL || key == NULL)
+	{
+		return;
+	}
+
+	SRadixMapPath path;
+	RadixMapNode node = RadixMap_FindNode(map, key, true, &path);
+	if (node == NULL || node->pValue == NULL)
+	{
+		return;
+	}
+
+	node->pValue = NULL;
+	map->elementsCount--;
+
+	if (node != map->rootNode)
+	{
+		RadixMap_Compact(map, path.grandParent, path.parentIndex, path.parent, path.index);
+	}
+}
+
+void RadixMap_Clear(RadixMap map)
+{
+	if (map == NULL)
+	{
+		return;
+	}
+
+	size_t valuesCount = 0;
+	RadixMapNode root = map->rootNode;
+
+	for (uint32_t i = 0; i < root->childrenCount; i++)
+	{
+		RadixMap_FreeSubtree(map, root->children[i], &valuesCount);
+	}
+
+	root->childrenCount = 0;
+	root->pValue = NULL;
+	map->elementsCount = 0;
+}
+
+void RadixMap_ForEachWithPrefix(RadixMap map, const char* prefix, fnRadixMapFunc function, void* context)
+{
+	if (map == NULL || prefix == NULL || function == NULL)
+	{
+		return;
+	}
+
+	SRadixMapPath path;
+	RadixMapNode node = RadixMap_FindNode(map, prefix, false, &path);
+	if (node == NULL)
+	{
+		return;
+	}
+
+	// the bytes above the found node are exactly the first bytes of the prefix
+	if (!RadixMap_EnsureKeyBuffer(map, path.keyLength + 1))
+	{
+		syserr("Failed to allocate radix map key buffer");
+		return;
+	}
+
+	memcpy(map->keyBuffer, prefix, path.keyLength);
+	RadixMap_VisitSubtree(map, node, path.keyLength, function, context);
+}
+
+size_t RadixMap_DeleteWithPrefix(RadixMap map, const char* prefix)
+{
+	if (map == NULL || prefix == NULL)
+	{
+		return (0);
+	}
+
+	SRadixMapPath path;
+	RadixMapNode node = RadixMap_FindNode(map, prefix, false, &path);
+	if (node == NULL)
+	{
+		return (0);
+	}
+
+	if (node == map->rootNode)
+	{
+		size_t removedCount = map->elementsCount;
+		RadixMap_Clear(map);
+		return (removedCount);
+	}
+
+	size_t removedCount = 0;
+	for (uint32_t i = 0; i < node->childrenCount; i++)
+	{
+		RadixMap_FreeSubtree(map, node->children[i], &removedCount);
+	}
+
+	if (node->pValue != NULL)
+	{
+		removedCount++;
+	}
+
+	// leave an empty leaf behind so Compact unlinks it and re-merges the parent
+	node->childrenCount = 0;
+	node->pValue = NULL;
+	RadixMap_Compact(map, path.grandParent, path.parentIndex, path.parent, path.index);
+
+	map->elementsCount -= removedCount;
+	return (removedCount);
+}
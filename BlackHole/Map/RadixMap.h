@@ -0,0 +1,54 @@
+#ifndef __RADIX_MAP_H__
+#define __RADIX_MAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../MemoryManager/MemoryPool.h"
+
+typedef void(*fnRadixMapFunc)(const char* key, void* value, void* context);
+
+// Compressed trie node: the edge leading here is stored inline, children are sorted by their first byte
+typedef struct SRadixMapNode
+{
+	struct SRadixMapNode** children;
+	uint32_t childrenCount;
+	uint32_t childrenCapacity;
+
+	void* pValue; // NULL when no key ends here
+	uint32_t edgeLength;
+	char edge[]; // not null terminated
+} SRadixMapNode;
+
+typedef struct SRadixMapNode* RadixMapNode;
+
+// String keyed map for hierarchical paths ("textures/terrain/grass_01"):
+// shared prefixes are stored once and a whole subtree can be listed or dropped at once
+typedef struct SRadixMap
+{
+	RadixMapNode rootNode; // Empty edge, never merged or removed
+	size_t elementsCount;
+	MemoryPool nodePool;
+	EMemoryTag memoryTag;
+
+	char* keyBuffer; // Rebuilds full keys for the ForEach callbacks
+	size_t keyBufferCapacity;
+} SRadixMap;
+
+typedef struct SRadixMap* RadixMap;
+
+bool RadixMap_Initialize(RadixMap* ppMap, EMemoryTag tag);
+void RadixMap_Destroy(RadixMap* ppMap);
+
+bool RadixMap_Insert(RadixMap map, const char* key, void* value);
+void* RadixMap_Find(RadixMap map, const char* key);
+void RadixMap_Delete(RadixMap map, const char* key);
+void RadixMap_Clear(RadixMap map);
+
+// Visits every key starting with 'prefix' in lexicographic order, cost is proportional to the result.
+// The callback must not modify the map.
+void RadixMap_ForEachWithPrefix(RadixMap map, const char* prefix, fnRadixMapFunc function, void* context);
+// Removes every key starting with 'prefix', returns how many were removed
+size_t RadixMap_DeleteWithPrefix(RadixMap map, const char* prefix);
+
+#endif // __RADIX_MAP_H__
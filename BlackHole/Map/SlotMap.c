@@ -0,0 +1,214 @@
+#include "SlotMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#include <string.h>
+
+#define SLOT_MAP_INITIAL_CAPACITY 16
+
+static bool SlotMap_Resize(SlotMap map, uint32_t capacity)
+{
+	uint8_t* values = engine_realloc(map->values, map->elementSize * capacity);
+	if (values == NULL)
+	{
+		return (false);
+	}
+
+	map->values = values;
+
+	uint32_t* denseToSlot = engine_realloc_array(map->denseToSlot, uint32_t, capacity);
+	if (denseToSlot == NULL)
+	{
+		// The values grew anyway, harmless, capacity stays at the smaller size
+		return (false);
+	}
+
+	map->denseToSlot = denseToSlot;
+	map->capacity = capacity;
+	return (true);
+}
+
+bool SlotMap_Initialize(SlotMap* ppMap, size_t elementSize, EMemoryTag tag)
+{
+	if (ppMap == NULL || elementSize == 0)
+	{
+		return (false);
+	}
+
+	*ppMap = engine_new_zero(SSlotMap, 1, tag);
+	SlotMap map = *ppMap;
+
+	if (map == NULL)
+	{
+		syserr("Failed to Allocate Memory for SlotMap");
+		return (false);
+	}
+
+	map->elementSize = elementSize;
+
+	// realloc keeps the tag of the first block
+	map->values = engine_malloc(elementSize * SLOT_MAP_INITIAL_CAPACITY, tag);
+	map->denseToSlot = engine_new_count_zero(uint32_t, SLOT_MAP_INITIAL_CAPACITY, tag);
+	if (map->values == NULL || map->denseToSlot == NULL || !HandleTable_Initialize(&map->handles, tag))
+	{
+		syserr("Failed to Allocate Memory for SlotMap values");
+		SlotMap_Destroy(ppMap);
+		return (false);
+	}
+
+	map->capacity = SLOT_MAP_INITIAL_CAPACITY;
+	return (true);
+}
+
+void SlotMap_Destroy(SlotMap* ppMap)
+{
+	if (ppMap == NULL || *ppMap == NULL)
+	{
+		return;
+	}
+
+	SlotMap map = *ppMap;
+
+	HandleTable_Destroy(&map->handles);
+	engine_free(map->denseToSlot);
+	engine_free(map->values);
+	engine_delete(map);
+	*ppMap = NULL;
+}
+
+void SlotMap_Clear(SlotMap map)
+{
+	if (map == NULL)
+	{
+		return;
+	}
+
+	HandleTable_Clear(&map->handles);
+	map->count = 0;
+}
+
+bool SlotMap_Reserve(SlotMap map, uint32_t count)
+{
+	if (map == NULL || count > HANDLE_TABLE_MAX_SLOTS)
+	{
+		return (false);
+	}
+
+	if (count > map->capacity && !SlotMap_Resize(map, count))
+	{
+		return (false);
+	}
+
+	return HandleTable_Reserve(&map->handles, count);
+}
+
+SlotHandle SlotMap_Insert(SlotMap map, const void* value)
+{
+	if (map == NULL)
+	{
+		return (SLOT_HANDLE_INVALID);
+	}
+
+	if (map->count == map->capacity)
+	{
+		if (map->capacity >= HANDLE_TABLE_MAX_SLOTS || !SlotMap_Resize(map, map->capacity * 2))
+		{
+			syserr("SlotMap: out of memory at %u values", map->count);
+			return (SLOT_HANDLE_INVALID);
+		}
+	}
+
+	uint32_t slot = HandleTable_Acquire(&map->handles, map->count);
+	if (slot == HANDLE_TABLE_NO_SLOT)
+	{
+		return (SLOT_HANDLE_INVALID);
+	}
+
+	map->denseToSlot[map->count] = slot;
+
+	uint8_t* pValue = map->values + map->elementSize * map->count;
+	if (value != NULL)
+	{
+		memcpy(pValue, value, map->elementSize);
+	}
+	else
+	{
+		memset(pValue, 0, map->elementSize);
+	}
+
+	map->count++;
+	return (HandleTable_GetHandle(&map->handles, slot));
+}
+
+bool SlotMap_Remove(SlotMap map, SlotHandle handle)
+{
+	uint32_t slot = (map != NULL) ? HandleTable_Find(&map->handles, handle) : HANDLE_TABLE_NO_SLOT;
+	if (slot == HANDLE_TABLE_NO_SLOT)
+	{
+		return (false);
+	}
+
+	uint32_t denseIndex = map->handles.slots[slot].value;
+	uint32_t lastIndex = map->count - 1;
+
+	// Fill the hole with the last value so the dense array stays packed
+	if (denseIndex != lastIndex)
+	{
+		memcpy(map->values + map->elementSize * denseIndex, map->values + map->elementSize * lastIndex, map->elementSize);
+		map->denseToSlot[denseIndex] = map->denseToSlot[lastIndex];
+		map->handles.slots[map->denseToSlot[denseIndex]].value = denseIndex;
+	}
+
+	map->count--;
+	HandleTable_Release(&map->handles, slot);
+	return (true);
+}
+
+void* SlotMap_Get(SlotMap map, SlotHandle handle)
+{
+	uint32_t slot = (map != NULL) ? HandleTable_Find(&map->handles, handle) : HANDLE_TABLE_NO_SLOT;
+	if (slot == HANDLE_TABLE_NO_SLOT)
+	{
+		return (NULL);
+	}
+
+	return (map->values + map->elementSize * map->handles.slots[slot].value);
+}
+
+bool SlotMap_Contains(SlotMap map, SlotHandle handle)
+{
+	return (map != NULL && HandleTable_Find(&map->handles, handle) != HANDLE_TABLE_NO_SLOT);
+}
+
+void* SlotMap_GetData(SlotMap map)
+{
+	return ((map != NULL) ? map->values : NULL);
+}
+
+uint32_t SlotMap_GetCount(SlotMap map)
+{
+	return ((map != NULL) ? map->count : 0);
+}
+
+SlotHandle SlotMap_GetHandleAt(SlotMap map, uint32_t denseIndex)
+{
+	if (map == NULL || denseIndex >= map->count)
+	{
+		return (SLOT_HANDLE_INVALID);
+	}
+
+	return (HandleTable_GetHandle(&map->handles, map->denseToSlot[denseIndex]));
+}
+
+void SlotMap_ForEach(SlotMap map, fnFunc function, void* context)
+{
+	if (map == NULL || function == NULL)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < map->count; i++)
+	{
+		function(map->values + map->elementSize * i, context);
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef __SLOT_MAP_H__
+#define __SLOT_MAP_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../List/List.h"
+#include "../MemoryManager/MemoryTags.h"
+#include "HandleTable.h"
+
+typedef GenerationalHandle SlotHandle;
+
+#define SLOT_HANDLE_INVALID GENERATIONAL_HANDLE_INVALID
+
+// Values live packed in a dense array, handles go through the sparse slots to find them.
+// Removing moves the last value into the hole, so iteration never skips dead entries.
+typedef struct SSlotMap
+{
+	uint8_t* values; // elementSize * capacity bytes, the first 'count' are live
+	uint32_t* denseToSlot; // Slot of each dense value, to fix its slot up when it moves
+	SHandleTable handles; // Slot value: position in the dense array
+	size_t elementSize;
+	uint32_t count;
+	uint32_t capacity; // Of the dense arrays
+} SSlotMap;
+
+typedef struct SSlotMap* SlotMap;
+
+bool SlotMap_Initialize(SlotMap* ppMap, size_t elementSize, EMemoryTag tag);
+void SlotMap_Destroy(SlotMap* ppMap);
+// Every handle handed out so far becomes stale
+void SlotMap_Clear(SlotMap map);
+bool SlotMap_Reserve(SlotMap map, uint32_t count);
+
+// Copies elementSize bytes from 'value' (zero filled when NULL), returns SLOT_HANDLE_INVALID on failure
+SlotHandle SlotMap_Insert(SlotMap map, const void* value);
+bool SlotMap_Remove(SlotMap map, SlotHandle handle);
+
+// NULL for a stale handle. The pointer is valid until the next insert or remove.
+void* SlotMap_Get(SlotMap map, SlotHandle handle);
+bool SlotMap_Contains(SlotMap map, SlotHandle handle);
+
+// Live values are the first GetCount elements of GetData, in no particular order
+void* SlotMap_GetData(SlotMap map);
+uint32_t SlotMap_GetCount(SlotMap map);
+SlotHandle SlotMap_GetHandleAt(SlotMap map, uint32_t denseIndex);
+
+// Walks the dense array, the callback gets a pointer to each value and must not insert or remove
+void SlotMap_ForEach(SlotMap map, fnFunc function, void* context);
+
+#endif // __SLOT_MAP_H__
@@ -0,0 +1,7 @@
+#include "TypedMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+TYPED_MAP_DEFINE(Uint32Map, uint32_t, uint32_t, TypedMap_HashUint32)
+TYPED_MAP_DEFINE(Uint64Map, uint64_t, uint64_t, TypedMap_HashUint64)
+TYPED_MAP_DEFINE(PointerMap, void*, void*, TypedMap_HashPointer)
@@ -0,0 +1,268 @@
+#ifndef __TYPED_MAP_H__
+#define __TYPED_MAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "../MemoryManager/MemoryTags.h"
+
+// Template style hash maps for scalar keys (integers, pointers, handles) with values stored inline.
+// TYPED_MAP_DECLARE goes in a header, TYPED_MAP_DEFINE in exactly one .c file:
+//
+//   TYPED_MAP_DECLARE(EntityMap, uint32_t, SEntityRecord)
+//   TYPED_MAP_DEFINE(EntityMap, uint32_t, SEntityRecord, TypedMap_HashUint32)
+//
+// Keys are compared with ==, entries are {key, value} pairs in one open addressed array
+// (linear probing, backward shift deletion so there are no tombstones).
+// Pointers returned by Find are valid until the next Insert, Delete or Clear.
+
+#define TYPED_MAP_MIN_CAPACITY 16 // Power of two
+#define TYPED_MAP_MAX_LOAD_NUM 3 // Grow past 3/4 full, linear probing degrades quickly above that
+#define TYPED_MAP_MAX_LOAD_DEN 4
+
+// Finalizers from MurmurHash3, consecutive ids end up far apart
+static inline uint64_t TypedMap_HashUint64(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return (key);
+}
+
+static inline uint64_t TypedMap_HashUint32(uint32_t key)
+{
+	return TypedMap_HashUint64(key);
+}
+
+static inline uint64_t TypedMap_HashPointer(const void* key)
+{
+	return TypedMap_HashUint64((uint64_t)(uintptr_t)key);
+}
+
+#define TYPED_MAP_DECLARE(Name, KeyType, ValueType) \
+	typedef struct S##Name##Entry \
+	{ \
+		KeyType key; \
+		ValueType value; \
+	} S##Name##Entry; \
+	\
+	typedef struct S##Name \
+	{ \
+		S##Name##Entry* entries; \
+		uint8_t* occupied; /* one byte per entry, stored after the entries */ \
+		size_t capacity; \
+		size_t elementsCount; \
+		EMemoryTag memoryTag; \
+	} S##Name; \
+	\
+	typedef struct S##Name* Name; \
+	typedef void(*fn##Name##Func)(KeyType key, ValueType* value, void* context); \
+	\
+	bool Name##_Initialize(Name* ppMap, EMemoryTag tag); \
+	void Name##_Destroy(Name* ppMap); \
+	bool Name##_Reserve(Name map, size_t elementsCount); \
+	bool Name##_Insert(Name map, KeyType key, ValueType value); \
+	ValueType* Name##_Find(Name map, KeyType key); \
+	bool Name##_Delete(Name map, KeyType key); \
+	void Name##_Clear(Name map); \
+	void Name##_ForEach(Name map, fn##Name##Func function, void* context);
+
+#define TYPED_MAP_DEFINE(Name, KeyType, ValueType, fnHash) \
+	static bool Name##_Rehash(Name map, size_t newCapacity) \
+	{ \
+		S##Name##Entry* newEntries = (S##Name##Entry*)engine_malloc(newCapacity * (sizeof(S##Name##Entry) + 1), map->memoryTag); \
+		if (newEntries == NULL) \
+		{ \
+			return (false); \
+		} \
+		\
+		uint8_t* newOccupied = (uint8_t*)(newEntries + newCapacity); \
+		memset(newOccupied, 0, newCapacity); \
+		\
+		size_t mask = newCapacity - 1; \
+		for (size_t i = 0; i < map->capacity; i++) \
+		{ \
+			if (map->occupied[i]) \
+			{ \
+				size_t slot = (size_t)fnHash(map->entries[i].key) & mask; \
+				while (newOccupied[slot]) \
+				{ \
+					slot = (slot + 1) & mask; \
+				} \
+				\
+				newEntries[slot] = map->entries[i]; \
+				newOccupied[slot] = 1; \
+			} \
+		} \
+		\
+		engine_free(map->entries); \
+		map->entries = newEntries; \
+		map->occupied = newOccupied; \
+		map->capacity = newCapacity; \
+		return (true); \
+	} \
+	\
+	/* Slot holding 'key', or the empty slot ending its probe run */ \
+	static size_t Name##_Probe(Name map, KeyType key) \
+	{ \
+		size_t mask = map->capacity - 1; \
+		size_t slot = (size_t)fnHash(key) & mask; \
+		\
+		while (map->occupied[slot] && !(map->entries[slot].key == key)) \
+		{ \
+			slot = (slot + 1) & mask; \
+		} \
+		\
+		return (slot); \
+	} \
+	\
+	bool Name##_Initialize(Name* ppMap, EMemoryTag tag) \
+	{ \
+		if (!ppMap) \
+		{ \
+			return (false); \
+		} \
+		\
+		*ppMap = engine_new_zero(S##Name, 1, tag); \
+		Name map = *ppMap; \
+		if (map == NULL) \
+		{ \
+			syserr("Failed to Allocate " #Name " Memory"); \
+			return (false); \
+		} \
+		\
+		map->memoryTag = tag; \
+		if (!Name##_Rehash(map, TYPED_MAP_MIN_CAPACITY)) \
+		{ \
+			engine_delete(map); \
+			*ppMap = NULL; \
+			return (false); \
+		} \
+		\
+		return (true); \
+	} \
+	\
+	void Name##_Destroy(Name* ppMap) \
+	{ \
+		if (!ppMap || !*ppMap) \
+		{ \
+			return; \
+		} \
+		\
+		engine_free((*ppMap)->entries); \
+		engine_delete(*ppMap); \
+		*ppMap = NULL; \
+	} \
+	\
+	bool Name##_Reserve(Name map, size_t elementsCount) \
+	{ \
+		if (map == NULL) \
+		{ \
+			return (false); \
+		} \
+		\
+		size_t capacity = map->capacity; \
+		while (elementsCount * TYPED_MAP_MAX_LOAD_DEN > capacity * TYPED_MAP_MAX_LOAD_NUM) \
+		{ \
+			capacity *= 2; \
+		} \
+		\
+		return (capacity == map->capacity || Name##_Rehash(map, capacity)); \
+	} \
+	\
+	bool Name##_Insert(Name map, KeyType key, ValueType value) \
+	{ \
+		if (map == NULL || !Name##_Reserve(map, map->elementsCount + 1)) \
+		{ \
+			return (false); \
+		} \
+		\
+		size_t slot = Name##_Probe(map, key); \
+		if (!map->occupied[slot]) \
+		{ \
+			map->entries[slot].key = key; \
+			map->occupied[slot] = 1; \
+			map->elementsCount++; \
+		} \
+		\
+		map->entries[slot].value = value; \
+		return (true); \
+	} \
+	\
+	ValueType* Name##_Find(Name map, KeyType key) \
+	{ \
+		if (map == NULL) \
+		{ \
+			return (NULL); \
+		} \
+		\
+		size_t slot = Name##_Probe(map, key); \
+		return (map->occupied[slot] ? &map->entries[slot].value : NULL); \
+	} \
+	\
+	bool Name##_Delete(Name map, KeyType key) \
+	{ \
+		if (map == NULL) \
+		{ \
+			return (false); \
+		} \
+		\
+		size_t mask = map->capacity - 1; \
+		size_t hole = Name##_Probe(map, key); \
+		if (!map->occupied[hole]) \
+		{ \
+			return (false); \
+		} \
+		\
+		/* Shift back every later entry of the run that may live in the hole */ \
+		for (size_t slot = (hole + 1) & mask; map->occupied[slot]; slot = (slot + 1) & mask) \
+		{ \
+			size_t home = (size_t)fnHash(map->entries[slot].key) & mask; \
+			if (((slot - home) & mask) >= ((slot - hole) & mask)) \
+			{ \
+				map->entries[hole] = map->entries[slot]; \
+				hole = slot; \
+			} \
+		} \
+		\
+		map->occupied[hole] = 0; \
+		map->elementsCount--; \
+		return (true); \
+	} \
+	\
+	void Name##_Clear(Name map) \
+	{ \
+		if (map == NULL) \
+		{ \
+			return; \
+		} \
+		\
+		memset(map->occupied, 0, map->capacity); \
+		map->elementsCount = 0; \
+	} \
+	\
+	void Name##_ForEach(Name map, fn##Name##Func function, void* context) \
+	{ \
+		if (map == NULL || function == NULL) \
+		{ \
+			return; \
+		} \
+		\
+		for (size_t i = 0; i < map->capacity; i++) \
+		{ \
+			if (map->occupied[i]) \
+			{ \
+				function(map->entries[i].key, &map->entries[i].value, context); \
+			} \
+		} \
+	}
+
+// Ready made instances, bigger values get their own TYPED_MAP_DECLARE
+TYPED_MAP_DECLARE(Uint32Map, uint32_t, uint32_t)
+TYPED_MAP_DECLARE(Uint64Map, uint64_t, uint64_t)
+TYPED_MAP_DECLARE(PointerMap, void*, void*)
+
+#endif // __TYPED_MAP_H__
@@ -3,6 +3,10 @@
 #include <windows.h>
 #endif
 #include "../Stdafx.h"
+#include "../Threading/Atomic.h"
+#include "../Threading/Thread.h"
+#include "../Profiler/Profiler.h"
+#include "../Clock/Clock.h"
 
 #ifdef _MSC_VER
 __declspec(align(16))
@@ -21,10 +25,9 @@ typedef struct SMemoryBlockHeader
 	struct SMemoryBlockHeader* prev;
 
 	EMemoryTag tag;
-	// Current size (x64): 8+4+4+8+8+8+8 = 48 bytes.
-	// 48 is a multiple of 16, so no extra padding is strictly needed,
-	// but we can keep a small buffer for future safety.
-	char padding[12];
+	uint32_t padding;
+	struct SMemoryThreadCache* cache; // Owning thread cache, NULL while the block is in the global list
+	// Current size (x64): 8+4+4+8+8+8+8+4+4+8 = 64 bytes.
 } SMemoryBlockHeader;
 
 #ifdef __cplusplus
@@ -40,6 +43,53 @@ typedef CRITICAL_SECTION MutexHandle;
 typedef pthread_mutex_t MutexHandle;
 #endif
 
+#define MEMORY_CACHE_SIZE_CLASS 16
+#define MEMORY_CACHE_MAX_SIZE 1024 // Bigger blocks are not recycled by the thread caches
+#define MEMORY_CACHE_CLASSES (MEMORY_CACHE_MAX_SIZE / MEMORY_CACHE_SIZE_CLASS)
+#define MEMORY_CACHE_MAX_FREE_BLOCKS 64 // Per class, the rest goes back to the OS
+#define MEMORY_CACHE_FLUSH_OPS 128 // Operations between two merges into the global stats
+
+#define MEMORY_LOCK_MAX_SITES 32 // Further calling sites are counted under the first one
+#define MEMORY_LOCK_SPIN_MIN 16
+#define MEMORY_LOCK_SPIN_MAX 4096
+
+// Lock accounting of one LockManagerAt caller
+typedef struct SMemoryLockSite
+{
+	const char* function;
+	int line;
+	SMemoryLockStats stats;
+} SMemoryLockSite;
+
+// Stats a thread cache collected but did not merge yet
+typedef struct SMemoryStatsDelta
+{
+	int64_t usage;
+	uint64_t allocated;
+	uint64_t freed;
+	int64_t count;
+	int64_t usageByTag[MEM_TAG_COUNT];
+} SMemoryStatsDelta;
+
+// Per thread allocation state: its own live list, lock and recycled blocks, so worker threads
+// only meet on the global lock once every MEMORY_CACHE_FLUSH_OPS operations.
+// Caches are recycled, never freed before the manager, so a stale owner pointer is always safe to lock.
+typedef struct SMemoryThreadCache
+{
+	Mutex lock; // Taken by the owner and by the rare free from another thread
+	SMemoryBlockHeader* head;
+	SMemoryBlockHeader* freeBlocks[MEMORY_CACHE_CLASSES];
+	uint32_t freeCounts[MEMORY_CACHE_CLASSES];
+
+	SMemoryStatsDelta stats;
+	uint32_t pendingOps;
+
+	bool isActive;
+	struct SMemoryThreadCache* nextCache;
+} SMemoryThreadCache;
+
+static THREAD_LOCAL SMemoryThreadCache* s_threadCache = NULL;
+
 typedef struct SMemoryManager
 {
 	uint64_t totalAllocated; // total allocated memory in bytes
@@ -49,16 +99,255 @@ typedef struct SMemoryManager
 	uint64_t allocationCount; // number of allocations
 
 	size_t usageByTag[MEM_TAG_COUNT];
+	size_t mappedByTag[MEM_TAG_COUNT]; // Part of usageByTag that is file mappings, not heap
+	uint64_t mappedUsage;
 
 	SMemoryBlockHeader* head; // Head of the "live" allocations list
+	SMemoryThreadCache* caches; // Every thread cache, active or waiting to be reused
 
 	// Crucial for multi-threaded operations
 	MutexHandle lock;
+	volatile int32_t lockMode; // EMemoryLockMode
+	volatile int32_t spinLimit; // Grows when spinning got the lock, shrinks when we had to block anyway
+
+	// Only touched with the lock held
+	volatile int32_t isLockStatsEnabled;
+	SMemoryLockStats lockStats;
+	SMemoryLockSite lockSites[MEMORY_LOCK_MAX_SITES];
+	uint32_t lockSitesCount;
+	uint32_t lockOwnerSite; // Site holding the lock right now
+	uint64_t lockedAtNs; // 0 when the current hold is not timed
 
 	bool isInitialized;
 	char padding[7]; // to match 16 bytes align
 } SMemoryManager;
 
+static void MemoryManager_LinkBlock(SMemoryBlockHeader** ppHead, SMemoryBlockHeader* header)
+{
+	header->next = *ppHead;
+	header->prev = NULL;
+	if (*ppHead)
+	{
+		(*ppHead)->prev = header;
+	}
+	*ppHead = header;
+}
+
+static void MemoryManager_UnlinkBlock(SMemoryBlockHeader** ppHead, SMemoryBlockHeader* header)
+{
+	if (header->prev)
+	{
+		// Not the head: point the previous node to our next node
+		header->prev->next = header->next;
+	}
+	else
+	{
+		// This IS the head: move the head pointer to our next node
+		*ppHead = header->next;
+	}
+
+	if (header->next)
+	{
+		// Not the tail: point the next node back to our previous node
+		header->next->prev = header->prev;
+	}
+}
+
+static size_t MemoryManager_GetClassIndex(size_t size)
+{
+	return (size == 0) ? 0 : (size - 1) / MEMORY_CACHE_SIZE_CLASS;
+}
+
+// Small blocks are allocated at their class size so any thread cache can recycle them
+static size_t MemoryManager_GetCapacity(size_t size)
+{
+	return (size <= MEMORY_CACHE_MAX_SIZE) ? (MemoryManager_GetClassIndex(size) + 1) * MEMORY_CACHE_SIZE_CLASS : size;
+}
+
+// Global lock held
+static void MemoryManager_ApplyStats(SMemoryStatsDelta* stats)
+{
+	psMemoryManager->currentUsage += (uint64_t)stats->usage;
+	psMemoryManager->totalAllocated += stats->allocated;
+	psMemoryManager->totalFreed += stats->freed;
+	psMemoryManager->allocationCount += (uint64_t)stats->count;
+	if (psMemoryManager->currentUsage > psMemoryManager->peakUsage)
+	{
+		psMemoryManager->peakUsage = psMemoryManager->currentUsage;
+	}
+
+	for (int i = 0; i < MEM_TAG_COUNT; i++)
+	{
+		psMemoryManager->usageByTag[i] += (size_t)stats->usageByTag[i];
+	}
+
+	memset(stats, 0, sizeof(SMemoryStatsDelta));
+}
+
+// Unlocks a cache after one operation. The merge into the global stats happens
+// outside the cache lock, so locks are only ever nested global -> cache.
+static void MemoryManager_UnlockCache(SMemoryThreadCache* cache)
+{
+	if (++cache->pendingOps < MEMORY_CACHE_FLUSH_OPS)
+	{
+		Mutex_Unlock(&cache->lock);
+		return;
+	}
+
+	SMemoryStatsDelta stats = cache->stats;
+	memset(&cache->stats, 0, sizeof(SMemoryStatsDelta));
+	cache->pendingOps = 0;
+	Mutex_Unlock(&cache->lock);
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+	MemoryManager_ApplyStats(&stats);
+	UnlockManager(psMemoryManager);
+}
+
+// Global lock held: brings the global stats up to date before a report
+static void MemoryManager_FlushCaches()
+{
+	for (SMemoryThreadCache* cache = psMemoryManager->caches; cache != NULL; cache = cache->nextCache)
+	{
+		Mutex_Lock(&cache->lock);
+		MemoryManager_ApplyStats(&cache->stats);
+		cache->pendingOps = 0;
+		Mutex_Unlock(&cache->lock);
+	}
+}
+
+static void MemoryManager_ReleaseFreeBlocks(SMemoryThreadCache* cache)
+{
+	for (int i = 0; i < MEMORY_CACHE_CLASSES; i++)
+	{
+		while (cache->freeBlocks[i] != NULL)
+		{
+			SMemoryBlockHeader* next = cache->freeBlocks[i]->next;
+			_mm_free(cache->freeBlocks[i]);
+			cache->freeBlocks[i] = next;
+		}
+
+		cache->freeCounts[i] = 0;
+	}
+}
+
+static void* MemoryManager_CacheAlloc(SMemoryThreadCache* cache, size_t size, const char* file, int line, const char* typeName, EMemoryTag tag)
+{
+	size_t classIndex = MemoryManager_GetClassIndex(size);
+
+	Mutex_Lock(&cache->lock);
+
+	SMemoryBlockHeader* header = cache->freeBlocks[classIndex];
+	if (header != NULL)
+	{
+		cache->freeBlocks[classIndex] = header->next;
+		cache->freeCounts[classIndex]--;
+	}
+	else
+	{
+		// Nothing to recycle, don't hold the lock over the OS call
+		Mutex_Unlock(&cache->lock);
+
+		header = (SMemoryBlockHeader*)_mm_malloc(sizeof(SMemoryBlockHeader) + MemoryManager_GetCapacity(size), 16);
+		if (!header)
+		{
+			return (NULL);
+		}
+
+		Mutex_Lock(&cache->lock);
+	}
+
+	header->size = size;
+	header->magic = 0xDEADBEEF;
+	header->file = file;
+	header->line = line;
+	header->typeName = typeName;
+	header->tag = tag;
+	Atomic_StorePtr((void* volatile*)&header->cache, cache);
+
+	MemoryManager_LinkBlock(&cache->head, header);
+
+	size_t total_size = size + sizeof(SMemoryBlockHeader);
+	cache->stats.usage += total_size;
+	cache->stats.allocated += total_size;
+	cache->stats.count++;
+	cache->stats.usageByTag[tag] += size;
+
+	MemoryManager_UnlockCache(cache);
+
+	return (void*)((char*)header + sizeof(SMemoryBlockHeader));
+}
+
+// Removes a live block from whichever list owns it (global or a thread cache) and updates the stats
+static void MemoryManager_UnlinkOwned(SMemoryBlockHeader* header)
+{
+	size_t total_size = header->size + sizeof(SMemoryBlockHeader);
+
+	for (;;)
+	{
+		SMemoryThreadCache* owner = (SMemoryThreadCache*)Atomic_LoadPtr((void* volatile*)&header->cache);
+		if (owner == NULL)
+		{
+			LockManagerAt(psMemoryManager, __func__, __LINE__);
+
+			MemoryManager_UnlinkBlock(&psMemoryManager->head, header);
+
+			psMemoryManager->currentUsage -= total_size;
+			psMemoryManager->totalFreed += total_size;
+			psMemoryManager->allocationCount--;
+			psMemoryManager->usageByTag[header->tag] -= header->size;
+
+			UnlockManager(psMemoryManager);
+			return;
+		}
+
+		Mutex_Lock(&owner->lock);
+
+		// The owner may have exited and handed its blocks to the global list meanwhile
+		if (header->cache == owner)
+		{
+			MemoryManager_UnlinkBlock(&owner->head, header);
+
+			owner->stats.usage -= total_size;
+			owner->stats.freed += total_size;
+			owner->stats.count--;
+			owner->stats.usageByTag[header->tag] -= header->size;
+
+			MemoryManager_UnlockCache(owner);
+			return;
+		}
+
+		Mutex_Unlock(&owner->lock);
+	}
+}
+
+// Keeps a freed small block for the next allocation of this thread
+static bool MemoryManager_CacheRecycle(SMemoryBlockHeader* header)
+{
+	SMemoryThreadCache* cache = s_threadCache;
+	if (cache == NULL || header->size > MEMORY_CACHE_MAX_SIZE)
+	{
+		return (false);
+	}
+
+	size_t classIndex = MemoryManager_GetClassIndex(header->size);
+
+	Mutex_Lock(&cache->lock);
+
+	if (cache->freeCounts[classIndex] >= MEMORY_CACHE_MAX_FREE_BLOCKS)
+	{
+		Mutex_Unlock(&cache->lock);
+		return (false);
+	}
+
+	header->next = cache->freeBlocks[classIndex];
+	cache->freeBlocks[classIndex] = header;
+	cache->freeCounts[classIndex]++;
+
+	Mutex_Unlock(&cache->lock);
+	return (true);
+}
+
 bool MemoryManager_Initialize(MemoryManager* ppMemoryManager)
 {
     if (ppMemoryManager == NULL)
@@ -71,18 +360,13 @@ bool MemoryManager_Initialize(MemoryManager* ppMemoryManager)
 	void* raw_mem = _mm_malloc(sizeof(SMemoryManager), 16);
 	if (!raw_mem)
 	{
-		return false;
+		syserr("Failed to Allocate Memory for MemoryManager");
+		return (false);
 	}
 
 	// This is the most important line to fix your 0xCDCDCD issue!
 	memset(raw_mem, 0, sizeof(SMemoryManager));
 
-	if (!(*ppMemoryManager))
-    {
-		syserr("Failed to Allocate Memory for MemoryManager");
-		return (false);
-    }
-
 	psMemoryManager = (MemoryManager)raw_mem;
 	*ppMemoryManager = psMemoryManager;
 
@@ -91,6 +375,8 @@ bool MemoryManager_Initialize(MemoryManager* ppMemoryManager)
 #else
 	pthread_mutex_init(&psMemoryManager->lock, NULL);
 #endif
+	psMemoryManager->lockMode = MEMORY_LOCK_MODE_BLOCK;
+	psMemoryManager->spinLimit = MEMORY_LOCK_SPIN_MIN;
 
 	psMemoryManager->head = NULL; // Explicitly NULL the head
 	(*ppMemoryManager)->isInitialized = true;
@@ -104,6 +390,17 @@ void MemoryManager_Destroy(MemoryManager* ppMemoryManager)
         return;
     }
 
+	// Threads are expected to have destroyed their caches already
+	SMemoryThreadCache* cache = psMemoryManager->caches;
+	while (cache != NULL)
+	{
+		SMemoryThreadCache* next = cache->nextCache;
+		MemoryManager_ReleaseFreeBlocks(cache);
+		Mutex_Destroy(&cache->lock);
+		_mm_free(cache);
+		cache = next;
+	}
+
 #ifdef _WIN32
 	DeleteCriticalSection(&psMemoryManager->lock);
 #else
@@ -114,22 +411,14 @@ void MemoryManager_Destroy(MemoryManager* ppMemoryManager)
 	*ppMemoryManager = NULL;
 }
 
-bool MemoryManager_Validate()
+static bool MemoryManager_ValidateList(SMemoryBlockHeader* curr, int* pIndex)
 {
-	if (!psMemoryManager || !psMemoryManager->isInitialized) return true;
-
-	LockManager(psMemoryManager);
-
-	SMemoryBlockHeader* curr = psMemoryManager->head;
-	int index = 0;
-	bool is_corrupt = false;
-
 	while (curr)
 	{
 		// 1. Check Magic Number
 		if (curr->magic != 0xDEADBEEF)
 		{
-			syserr("CRITICAL: Memory Corruption detected at block %d!", index);
+			syserr("CRITICAL: Memory Corruption detected at block %d!", *pIndex);
 			syserr("Block allocated at %s:%d (Type: %s)",
 				curr->file, curr->line, curr->typeName ? curr->typeName : "Unknown");
 
@@ -137,10 +426,8 @@ bool MemoryManager_Validate()
 			if (curr->magic == 0xBAADF00D) {
 				syserr("Error: Node is marked as FREED but still exists in the live list!");
 			}
-
-			is_corrupt = true;
 			// We stop here because if the header is corrupt, the 'next' pointer might be garbage
-			break;
+			return (false);
 		}
 
 		// 2. Cross-link validation (The "Perfect" Check)
@@ -148,12 +435,30 @@ bool MemoryManager_Validate()
 		if (curr->next && curr->next->prev != curr)
 		{
 			syserr("CRITICAL: Linked List pointer corruption at %s:%d (Type: %s)", curr->file, curr->line, curr->typeName ? curr->typeName : "UnKnown");
-			is_corrupt = true;
-			break;
+			return (false);
 		}
 
 		curr = curr->next;
-		index++;
+		(*pIndex)++;
+	}
+
+	return (true);
+}
+
+bool MemoryManager_Validate()
+{
+	if (!psMemoryManager || !psMemoryManager->isInitialized) return true;
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+
+	int index = 0;
+	bool is_corrupt = !MemoryManager_ValidateList(psMemoryManager->head, &index);
+
+	for (SMemoryThreadCache* cache = psMemoryManager->caches; cache != NULL && !is_corrupt; cache = cache->nextCache)
+	{
+		Mutex_Lock(&cache->lock);
+		is_corrupt = !MemoryManager_ValidateList(cache->head, &index);
+		Mutex_Unlock(&cache->lock);
 	}
 
 	UnlockManager(psMemoryManager);
@@ -171,40 +476,72 @@ bool MemoryManager_Validate()
 	return !is_corrupt;
 }
 
+static bool MemoryManager_DumpList(SMemoryBlockHeader* curr, bool hasLeaks)
+{
+	while (curr)
+	{
+		if (!hasLeaks)
+		{
+			syslog("--- MEMORY LEAK REPORT ---");
+			hasLeaks = true;
+		}
+
+		syslog("Leak: %zu bytes allocated at %s:%d", curr->size, curr->file, curr->line);
+		curr = curr->next;
+	}
+
+	return (hasLeaks);
+}
+
 void MemoryManager_DumpLeaks()
 {
-	LockManager(psMemoryManager);
-	SMemoryBlockHeader* curr = psMemoryManager->head;
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+
+	bool hasLeaks = MemoryManager_DumpList(psMemoryManager->head, false);
+	for (SMemoryThreadCache* cache = psMemoryManager->caches; cache != NULL; cache = cache->nextCache)
+	{
+		Mutex_Lock(&cache->lock);
+		hasLeaks = MemoryManager_DumpList(cache->head, hasLeaks);
+		Mutex_Unlock(&cache->lock);
+	}
 
-	if (!curr)
+	if (!hasLeaks)
 	{
 		syslog("No leaks detected! Great job.");
 	}
-	else
+
+	UnlockManager(psMemoryManager);
+}
+
+static void MemoryManager_PrintList(SMemoryBlockHeader* curr)
+{
+	while (curr)
 	{
-		syslog("--- MEMORY LEAK REPORT ---");
-		while (curr)
+		if (curr->typeName != NULL)
+		{
+			syslog("Object Allocated At %s:%d with size: %s, Type: %s", curr->file, curr->line, FormatMemorySize(curr->size), curr->typeName);
+		}
+		else 
 		{
-			syslog("Leak: %zu bytes allocated at %s:%d", curr->size, curr->file, curr->line);
-			curr = curr->next;
+			syslog("Object Allocated At %s:%d with size: %s", curr->file, curr->line, FormatMemorySize(curr->size));
 		}
+		curr = curr->next;
 	}
-	UnlockManager(psMemoryManager);
 }
 
 void MemoryManager_PrintData()
 {
-	LockManager(psMemoryManager);
-	SMemoryBlockHeader* curr = psMemoryManager->head;
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+	MemoryManager_FlushCaches();
 
-	if (!curr)
+	if (psMemoryManager->allocationCount == 0)
 	{
 		syslog("No Current Active Elements.");
 	}
 	else
 	{
 		syslog("--- MEMORY MANAGER REPORT ---");
-		syslog("Allocation Count: %llu", psMemoryManager->allocationCount);
+		syslog("Allocation Count: %llu", (unsigned long long)psMemoryManager->allocationCount);
 
 		char totalAllocated[16], currentAllocated[16], totalFreed[16], peak[16];
 		FormatMemorySizeThreadSafe(psMemoryManager->totalAllocated, totalAllocated, sizeof(totalAllocated));
@@ -216,49 +553,209 @@ void MemoryManager_PrintData()
 		syslog("Current Usage: %s", currentAllocated);
 		syslog("Current Total Freed: %s", totalFreed);
 		syslog("Peak Usage: %s", peak);
+
+		if (psMemoryManager->mappedUsage > 0)
+		{
+			char mapped[16];
+			FormatMemorySizeThreadSafe(psMemoryManager->mappedUsage, mapped, sizeof(mapped));
+			syslog("Mapped Files: %s", mapped);
+		}
 		
-		while (curr)
+		MemoryManager_PrintList(psMemoryManager->head);
+		for (SMemoryThreadCache* cache = psMemoryManager->caches; cache != NULL; cache = cache->nextCache)
 		{
-			if (curr->typeName != NULL)
-			{
-				syslog("Object Allocated At %s:%d with size: %s, Type: %s", curr->file, curr->line, FormatMemorySize(curr->size), curr->typeName);
-			}
-			else 
-			{
-				syslog("Object Allocated At %s:%d with size: %s", curr->file, curr->line, FormatMemorySize(curr->size));
-			}
-			curr = curr->next;
+			Mutex_Lock(&cache->lock);
+			MemoryManager_PrintList(cache->head);
+			Mutex_Unlock(&cache->lock);
 		}
 	}
 
+	bool isLockStatsEnabled = (psMemoryManager->isLockStatsEnabled != 0);
 	UnlockManager(psMemoryManager);
+
+	if (isLockStatsEnabled)
+	{
+		MemoryManager_PrintLockReport();
+	}
 }
 
 void MemoryManager_PrintTagReport()
 {
-	LockManager(psMemoryManager);
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+	MemoryManager_FlushCaches();
 	syslog("--- MEMORY TAG REPORT ---");
 	for (int i = 0; i < MEM_TAG_COUNT; i++)
 	{
-		syslog("%-12s: %s", MemoryTagNames[i], FormatMemorySize(psMemoryManager->usageByTag[i]));
+		if (psMemoryManager->mappedByTag[i] == 0)
+		{
+			syslog("%-12s: %s", MemoryTagNames[i], FormatMemorySize(psMemoryManager->usageByTag[i]));
+			continue;
+		}
+
+		char usage[16], mapped[16];
+		FormatMemorySizeThreadSafe(psMemoryManager->usageByTag[i], usage, sizeof(usage));
+		FormatMemorySizeThreadSafe(psMemoryManager->mappedByTag[i], mapped, sizeof(mapped));
+		syslog("%-12s: %s (%s mapped)", MemoryTagNames[i], usage, mapped);
 	}
 	UnlockManager(psMemoryManager);
 }
-void LockManager(MemoryManager mgr)
+
+void MemoryManager_TrackMapping(EMemoryTag tag, size_t size)
+{
+	if (!psMemoryManager || tag >= MEM_TAG_COUNT) return;
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+	psMemoryManager->usageByTag[tag] += size;
+	psMemoryManager->mappedByTag[tag] += size;
+	psMemoryManager->mappedUsage += size;
+	UnlockManager(psMemoryManager);
+}
+
+void MemoryManager_UntrackMapping(EMemoryTag tag, size_t size)
+{
+	if (!psMemoryManager || tag >= MEM_TAG_COUNT) return;
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+	psMemoryManager->usageByTag[tag] -= size;
+	psMemoryManager->mappedByTag[tag] -= size;
+	psMemoryManager->mappedUsage -= size;
+	UnlockManager(psMemoryManager);
+}
+
+static bool MemoryManager_TryLockMutex(MutexHandle* mutex)
+{
+#ifdef _WIN32
+	return (TryEnterCriticalSection(mutex) != 0);
+#else
+	return (pthread_mutex_trylock(mutex) == 0);
+#endif
+}
+
+// Lock held
+static void MemoryManager_AddLockTime(uint64_t* pTotal, uint64_t* pMax, uint64_t timeNs)
+{
+	*pTotal += timeNs;
+	if (timeNs > *pMax)
+	{
+		*pMax = timeNs;
+	}
+}
+
+// Lock held
+static uint32_t MemoryManager_GetLockSite(MemoryManager mgr, const char* function, int line)
+{
+	for (uint32_t i = 0; i < mgr->lockSitesCount; i++)
+	{
+		if (mgr->lockSites[i].line == line && mgr->lockSites[i].function == function)
+		{
+			return (i);
+		}
+	}
+
+	if (mgr->lockSitesCount == MEMORY_LOCK_MAX_SITES)
+	{
+		return (0);
+	}
+
+	SMemoryLockSite* site = &mgr->lockSites[mgr->lockSitesCount];
+	site->function = function;
+	site->line = line;
+	return (mgr->lockSitesCount++);
+}
+
+// Returns true if spinning got the lock
+static bool MemoryManager_SpinLock(MemoryManager mgr)
+{
+	int32_t spinLimit = Atomic_Load32(&mgr->spinLimit);
+	for (int32_t i = 0; i < spinLimit; i++)
+	{
+		Atomic_CpuPause();
+		if (MemoryManager_TryLockMutex(&mgr->lock))
+		{
+			// Lock held, nobody else writes the limit now
+			int32_t grown = spinLimit + spinLimit / 8 + 1;
+			Atomic_Store32(&mgr->spinLimit, (grown < MEMORY_LOCK_SPIN_MAX) ? grown : MEMORY_LOCK_SPIN_MAX);
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+void LockManagerAt(MemoryManager mgr, const char* function, int line)
 {
 	if (!mgr) return;
 
+	// Uncontended: one try and no clock read
+	if (MemoryManager_TryLockMutex(&mgr->lock))
+	{
+		if (mgr->isLockStatsEnabled)
+		{
+			SMemoryLockSite* site = &mgr->lockSites[MemoryManager_GetLockSite(mgr, function, line)];
+			site->stats.acquisitions++;
+			mgr->lockStats.acquisitions++;
+			mgr->lockOwnerSite = (uint32_t)(site - mgr->lockSites);
+			mgr->lockedAtNs = Clock_GetTimeNs();
+		}
+		return;
+	}
+
+	// Reading the flag without the lock only decides whether we time this wait
+	bool isTimed = (Atomic_Load32(&mgr->isLockStatsEnabled) != 0);
+	uint64_t waitStart = isTimed ? Clock_GetTimeNs() : 0;
+
+	if (Atomic_Load32(&mgr->lockMode) != MEMORY_LOCK_MODE_SPIN_THEN_BLOCK || !MemoryManager_SpinLock(mgr))
+	{
 #ifdef _WIN32
-	EnterCriticalSection(&mgr->lock);
+		EnterCriticalSection(&mgr->lock);
 #else
-	pthread_mutex_lock(&mgr->lock);
+		pthread_mutex_lock(&mgr->lock);
 #endif
+
+		if (Atomic_Load32(&mgr->lockMode) == MEMORY_LOCK_MODE_SPIN_THEN_BLOCK)
+		{
+			int32_t shrunk = mgr->spinLimit / 2;
+			Atomic_Store32(&mgr->spinLimit, (shrunk > MEMORY_LOCK_SPIN_MIN) ? shrunk : MEMORY_LOCK_SPIN_MIN);
+		}
+	}
+
+	if (mgr->isLockStatsEnabled)
+	{
+		uint64_t now = Clock_GetTimeNs();
+		uint64_t waitNs = isTimed ? now - waitStart : 0;
+
+		SMemoryLockSite* site = &mgr->lockSites[MemoryManager_GetLockSite(mgr, function, line)];
+		site->stats.acquisitions++;
+		site->stats.contendedAcquisitions++;
+		MemoryManager_AddLockTime(&site->stats.totalWaitNs, &site->stats.maxWaitNs, waitNs);
+
+		mgr->lockStats.acquisitions++;
+		mgr->lockStats.contendedAcquisitions++;
+		MemoryManager_AddLockTime(&mgr->lockStats.totalWaitNs, &mgr->lockStats.maxWaitNs, waitNs);
+
+		mgr->lockOwnerSite = (uint32_t)(site - mgr->lockSites);
+		mgr->lockedAtNs = now;
+	}
+}
+
+void LockManager(MemoryManager mgr)
+{
+	LockManagerAt(mgr, "LockManager", 0);
 }
 
 void UnlockManager(MemoryManager mgr)
 {
 	if (!mgr) return;
 
+	if (mgr->lockedAtNs != 0)
+	{
+		uint64_t holdNs = Clock_GetTimeNs() - mgr->lockedAtNs;
+		SMemoryLockSite* site = &mgr->lockSites[mgr->lockOwnerSite];
+		MemoryManager_AddLockTime(&site->stats.totalHoldNs, &site->stats.maxHoldNs, holdNs);
+		MemoryManager_AddLockTime(&mgr->lockStats.totalHoldNs, &mgr->lockStats.maxHoldNs, holdNs);
+		mgr->lockedAtNs = 0;
+	}
+
 #ifdef _WIN32
 	LeaveCriticalSection(&mgr->lock);
 #else
@@ -266,14 +763,185 @@ void UnlockManager(MemoryManager mgr)
 #endif
 }
 
+void MemoryManager_SetLockMode(EMemoryLockMode mode)
+{
+	if (!psMemoryManager) return;
+
+	// Spinning only burns the time slice the holder needs when there is a single core
+	if (mode == MEMORY_LOCK_MODE_SPIN_THEN_BLOCK && Thread_GetHardwareConcurrency() < 2)
+	{
+		mode = MEMORY_LOCK_MODE_BLOCK;
+	}
+
+	Atomic_Store32(&psMemoryManager->lockMode, (int32_t)mode);
+}
+
+void MemoryManager_EnableLockStats(bool isEnabled)
+{
+	if (!psMemoryManager) return;
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+
+	// Drop the timing of this very hold, the counters restart from here
+	psMemoryManager->lockedAtNs = 0;
+	memset(&psMemoryManager->lockStats, 0, sizeof(SMemoryLockStats));
+	memset(psMemoryManager->lockSites, 0, sizeof(psMemoryManager->lockSites));
+	psMemoryManager->lockSitesCount = 0;
+	psMemoryManager->lockOwnerSite = 0;
+	Atomic_Store32(&psMemoryManager->isLockStatsEnabled, isEnabled ? 1 : 0);
+
+	UnlockManager(psMemoryManager);
+}
+
+bool MemoryManager_GetLockStats(SMemoryLockStats* pStats)
+{
+	if (!psMemoryManager || !pStats) return (false);
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+	*pStats = psMemoryManager->lockStats;
+	UnlockManager(psMemoryManager);
+
+	return (true);
+}
+
+static void MemoryManager_PrintLockStats(const char* label, int line, SMemoryLockStats* stats)
+{
+	uint64_t acquisitions = (stats->acquisitions > 0) ? stats->acquisitions : 1;
+	uint64_t contended = (stats->contendedAcquisitions > 0) ? stats->contendedAcquisitions : 1;
+
+	syslog("%-32s %5d %10llu %10llu (%5.1f%%) | wait avg %8.1f max %8llu ns | hold avg %8.1f max %8llu ns",
+		label, line,
+		(unsigned long long)stats->acquisitions,
+		(unsigned long long)stats->contendedAcquisitions,
+		100.0 * (double)stats->contendedAcquisitions / (double)acquisitions,
+		(double)stats->totalWaitNs / (double)contended, (unsigned long long)stats->maxWaitNs,
+		(double)stats->totalHoldNs / (double)acquisitions, (unsigned long long)stats->maxHoldNs);
+}
+
+void MemoryManager_PrintLockReport()
+{
+	if (!psMemoryManager) return;
+
+	// Copy first, printing under the lock would show up as hold time
+	SMemoryLockStats totals;
+	SMemoryLockSite sites[MEMORY_LOCK_MAX_SITES];
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+	bool isEnabled = (psMemoryManager->isLockStatsEnabled != 0);
+	EMemoryLockMode mode = (EMemoryLockMode)psMemoryManager->lockMode;
+	int32_t spinLimit = psMemoryManager->spinLimit;
+	uint32_t sitesCount = psMemoryManager->lockSitesCount;
+	totals = psMemoryManager->lockStats;
+	memcpy(sites, psMemoryManager->lockSites, sizeof(SMemoryLockSite) * sitesCount);
+	UnlockManager(psMemoryManager);
+
+	syslog("--- MEMORY LOCK REPORT (%s, spin limit %d) ---", (mode == MEMORY_LOCK_MODE_SPIN_THEN_BLOCK) ? "spin then block" : "block", spinLimit);
+	if (!isEnabled)
+	{
+		syslog("Lock stats are disabled, see MemoryManager_EnableLockStats");
+		return;
+	}
+
+	syslog("%-32s %5s %10s %10s", "site", "line", "acquired", "contended");
+	for (uint32_t i = 0; i < sitesCount; i++)
+	{
+		MemoryManager_PrintLockStats(sites[i].function, sites[i].line, &sites[i].stats);
+	}
+
+	MemoryManager_PrintLockStats("total", 0, &totals);
+}
+
 MemoryManager GetMemoryManager()
 {
     assert(psMemoryManager);
     return (psMemoryManager);
 }
 
-void* tracked_malloc_internal(size_t size, const char* file, int line, const char* typeName, EMemoryTag tag)
+bool MemoryManager_InitializeThreadCache()
+{
+	if (s_threadCache != NULL)
+	{
+		return (true);
+	}
+
+	if (!psMemoryManager)
+	{
+		return (false);
+	}
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+
+	// Reuse the cache of a thread that already exited
+	SMemoryThreadCache* cache = psMemoryManager->caches;
+	while (cache != NULL && cache->isActive)
+	{
+		cache = cache->nextCache;
+	}
+
+	if (cache == NULL)
+	{
+		cache = (SMemoryThreadCache*)_mm_malloc(sizeof(SMemoryThreadCache), 16);
+		if (!cache)
+		{
+			UnlockManager(psMemoryManager);
+			return (false);
+		}
+
+		memset(cache, 0, sizeof(SMemoryThreadCache));
+		Mutex_Initialize(&cache->lock);
+
+		cache->nextCache = psMemoryManager->caches;
+		psMemoryManager->caches = cache;
+	}
+
+	cache->isActive = true;
+	UnlockManager(psMemoryManager);
+
+	s_threadCache = cache;
+	return (true);
+}
+
+void MemoryManager_DestroyThreadCache()
+{
+	SMemoryThreadCache* cache = s_threadCache;
+	if (cache == NULL)
+	{
+		return;
+	}
+
+	s_threadCache = NULL;
+
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
+	Mutex_Lock(&cache->lock);
+
+	// Blocks still alive outlive the thread: hand them to the global list
+	while (cache->head != NULL)
+	{
+		SMemoryBlockHeader* header = cache->head;
+		cache->head = header->next;
+
+		Atomic_StorePtr((void* volatile*)&header->cache, NULL);
+		MemoryManager_LinkBlock(&psMemoryManager->head, header);
+	}
+
+	MemoryManager_ApplyStats(&cache->stats);
+	cache->pendingOps = 0;
+
+	MemoryManager_ReleaseFreeBlocks(cache);
+	cache->isActive = false;
+
+	Mutex_Unlock(&cache->lock);
+	UnlockManager(psMemoryManager);
+}
+
+static void* MemoryManager_Allocate(size_t size, const char* file, int line, const char* typeName, EMemoryTag tag)
 {
+	SMemoryThreadCache* cache = s_threadCache;
+	if (cache != NULL && size <= MEMORY_CACHE_MAX_SIZE)
+	{
+		return MemoryManager_CacheAlloc(cache, size, file, line, typeName, tag);
+	}
+
 	// 1. Align the header size to 16 bytes. 
 	// Even if size_t is 8, we reserve 16 to keep the user pointer aligned.
 	size_t total_size = size + sizeof(SMemoryBlockHeader); // actual size + header_size(for size_t)
@@ -281,7 +949,7 @@ void* tracked_malloc_internal(size_t size, const char* file, int line, const cha
 	// 2. Use _aligned_malloc or ensure malloc gives us 16-byte alignment
 	// On most 64-bit systems, malloc is 16-byte aligned by default.
 	// size_t* raw_ptr = (size_t*)malloc(total_size); // allocate with total size
-	void* raw_ptr = _mm_malloc(total_size, 16); // Ensure we get a 16-byte aligned block from the OS
+	void* raw_ptr = _mm_malloc(sizeof(SMemoryBlockHeader) + MemoryManager_GetCapacity(size), 16); // Ensure we get a 16-byte aligned block from the OS
 
 	if (!raw_ptr)
 	{
@@ -296,17 +964,12 @@ void* tracked_malloc_internal(size_t size, const char* file, int line, const cha
 	header->line = line;
 	header->typeName = typeName;
 	header->tag = tag;
+	header->cache = NULL;
 
 	// 4. Thread-Safe Linked List Insertion
-	LockManager(psMemoryManager);
+	LockManagerAt(psMemoryManager, __func__, __LINE__);
 
-	header->next = psMemoryManager->head;
-	header->prev = NULL;
-	if (psMemoryManager->head)
-	{
-		psMemoryManager->head->prev = header;
-	}
-	psMemoryManager->head = header;
+	MemoryManager_LinkBlock(&psMemoryManager->head, header);
 
 	psMemoryManager->currentUsage += total_size;
 	psMemoryManager->totalAllocated += total_size;
@@ -334,15 +997,26 @@ void* tracked_malloc_internal(size_t size, const char* file, int line, const cha
 
 #if defined(ENABLE_MEMORY_LOGS)
 	// Use the manager's current usage for the log
-	syslog("allocated: %zu bytes. Total system usage: %llu (%s:%d)", size, psMemoryManager->currentUsage, file, line);
-#endif#endif
+	syslog("allocated: %zu bytes. Total system usage: %llu (%s:%d)", size, (unsigned long long)psMemoryManager->currentUsage, file, line);
+#endif
 
 	// Return pointer after the header
 	return user_ptr;
 }
 
+void* tracked_malloc_internal(size_t size, const char* file, int line, const char* typeName, EMemoryTag tag)
+{
+	PROFILE_ZONE_BEGIN(MemoryManager_Malloc);
+	void* user_ptr = MemoryManager_Allocate(size, file, line, typeName, tag);
+	PROFILE_ZONE_END(MemoryManager_Malloc);
+
+	return user_ptr;
+}
+
 void* tracked_calloc_internal(size_t count, size_t size, const char* file, int line, const char* typeName, EMemoryTag tag)
 {
+	PROFILE_ZONE_BEGIN(MemoryManager_Calloc);
+
 	size_t total_size = count * size; // actual size
 
 	// We still need our header for the tracker!
@@ -352,10 +1026,11 @@ void* tracked_calloc_internal(size_t count, size_t size, const char* file, int l
 		memset(ptr, 0, total_size);
 	}
 
+	PROFILE_ZONE_END(MemoryManager_Calloc);
 	return (ptr);
 }
 
-void* tracked_realloc_internal(void* ptr, size_t new_size, const char* file, int line, const char* typeName)
+static void* MemoryManager_Reallocate(void* ptr, size_t new_size, const char* file, int line, const char* typeName)
 {
 	// If ptr is NULL, it's just a malloc
 	if (ptr == NULL)
@@ -407,6 +1082,15 @@ void* tracked_realloc_internal(void* ptr, size_t new_size, const char* file, int
 	return new_ptr;
 }
 
+void* tracked_realloc_internal(void* ptr, size_t new_size, const char* file, int line, const char* typeName)
+{
+	PROFILE_ZONE_BEGIN(MemoryManager_Realloc);
+	void* new_ptr = MemoryManager_Reallocate(ptr, new_size, file, line, typeName);
+	PROFILE_ZONE_END(MemoryManager_Realloc);
+
+	return new_ptr;
+}
+
 char* tracked_strdup_internal(const char* szSource, const char* file, int line, const char* typeName, EMemoryTag tag)
 {
 	if (!szSource)
@@ -437,6 +1121,8 @@ void tracked_free_internal(void* pObject, const char* file, int line)
 		return;
 	}
 
+	PROFILE_ZONE_BEGIN(MemoryManager_Free);
+
 	// 1. Move the pointer back to find the header
 	// Shift back by 16 bytes to find the real start
 	SMemoryBlockHeader* header = (SMemoryBlockHeader*)((char*)pObject - sizeof(SMemoryBlockHeader));
@@ -457,36 +1143,8 @@ void tracked_free_internal(void* pObject, const char* file, int line)
 		}
 	}
 
-	// 3. Thread-Safe Unlinking
-	LockManager(psMemoryManager);
-
-	if (header->prev)
-	{
-		// Not the head: point the previous node to our next node
-		header->prev->next = header->next;
-	}
-	else
-	{
-		// This IS the head: move the head pointer to our next node
-		psMemoryManager->head = header->next;
-	}
-
-	if (header->next)
-	{
-		// Not the tail: point the next node back to our previous node
-		header->next->prev = header->prev;
-	}
-
-	// 4. Update Stats
-	size_t total_size = header->size + sizeof(SMemoryBlockHeader);
-	psMemoryManager->currentUsage -= total_size;
-	psMemoryManager->totalFreed += total_size;
-	psMemoryManager->allocationCount--;
-
-	// Update tags
-	psMemoryManager->usageByTag[header->tag] -= header->size;
-
-	UnlockManager(psMemoryManager);
+	// 3. Thread-Safe Unlinking and stats, under the lock of whoever owns the block
+	MemoryManager_UnlinkOwned(header);
 
 #if defined(ENABLE_MEMORY_LOGS)
 	syslog("Automatically detected and will free: %zu bytes (%s:%d)", header->size, get_filename(file), line);
@@ -498,7 +1156,12 @@ void tracked_free_internal(void* pObject, const char* file, int line)
 	// Fill user memory with a garbage pattern to catch "use-after-free"
 	memset(pObject, 0xFE, header->size); // Easy to track use-after-free bugs
 
-	_mm_free(header);
+	if (!MemoryManager_CacheRecycle(header))
+	{
+		_mm_free(header);
+	}
+
+	PROFILE_ZONE_END(MemoryManager_Free);
 }
 
 const char* FormatMemorySize(uint64_t bytes)
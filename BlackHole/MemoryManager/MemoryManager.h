@@ -13,16 +13,52 @@ typedef struct SMemoryManager* MemoryManager;
 bool MemoryManager_Initialize(MemoryManager* ppMemoryManager);
 void MemoryManager_Destroy(MemoryManager* ppMemoryManager);
 
+typedef enum EMemoryLockMode
+{
+	MEMORY_LOCK_MODE_BLOCK = 0, // Sleep in the OS mutex as soon as the lock is taken
+	MEMORY_LOCK_MODE_SPIN_THEN_BLOCK, // Spin an adaptive number of rounds first, holders are usually out within a few hundred ns
+} EMemoryLockMode;
+
+// Global lock accounting, all times in nanoseconds
+typedef struct SMemoryLockStats
+{
+	uint64_t acquisitions;
+	uint64_t contendedAcquisitions; // The first try failed
+	uint64_t totalWaitNs;
+	uint64_t maxWaitNs;
+	uint64_t totalHoldNs;
+	uint64_t maxHoldNs;
+} SMemoryLockStats;
+
 bool MemoryManager_Validate();
 void MemoryManager_DumpLeaks();
 void MemoryManager_PrintData();
 void MemoryManager_PrintTagReport();
 void LockManager(MemoryManager mgr);
 void UnlockManager(MemoryManager mgr);
+// Same as LockManager, the site shows up in the lock report
+void LockManagerAt(MemoryManager mgr, const char* function, int line);
+
+void MemoryManager_SetLockMode(EMemoryLockMode mode);
+// Off by default, costs two clock reads per lock. Enabling resets the counters.
+void MemoryManager_EnableLockStats(bool isEnabled);
+bool MemoryManager_GetLockStats(SMemoryLockStats* pStats);
+// Totals plus a line per calling site
+void MemoryManager_PrintLockReport();
+
+// File mappings (MappedFile) count in the tag report, but not as heap usage or leaks
+void MemoryManager_TrackMapping(EMemoryTag tag, size_t size);
+void MemoryManager_UntrackMapping(EMemoryTag tag, size_t size);
 
 MemoryManager GetMemoryManager();
 static MemoryManager psMemoryManager;
 
+// Gives the calling thread its own live list, lock and recycled small blocks,
+// so threads only meet on the global lock when their stats are merged.
+// Call Destroy before the thread exits, its live blocks then move to the global list.
+bool MemoryManager_InitializeThreadCache();
+void MemoryManager_DestroyThreadCache();
+
 void* tracked_malloc_internal(size_t size, const char* file, int line, const char* typeName, EMemoryTag tag);
 void* tracked_calloc_internal(size_t count, size_t size, const char* file, int line, const char* typeName, EMemoryTag tag);
 void* tracked_realloc_internal(void* ptr, size_t new_size, const char* file, int line, const char* typeName);
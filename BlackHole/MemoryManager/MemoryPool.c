@@ -0,0 +1,250 @@
+#include "MemoryPool.h"
+#include "MemoryManager.h"
+#include "../Stdafx.h"
+
+#define MEMORY_POOL_CLASS_COUNT (MEMORY_POOL_MAX_SMALL_SIZE / MEMORY_POOL_ALIGNMENT)
+#define MEMORY_POOL_MIN_CHUNK_SIZE (4 * 1024)
+#define MEMORY_POOL_MAX_CHUNK_SIZE (256 * 1024)
+
+typedef struct SMemoryPoolFreeBlock
+{
+	struct SMemoryPoolFreeBlock* next;
+} SMemoryPoolFreeBlock;
+
+typedef struct SMemoryPoolChunk
+{
+	struct SMemoryPoolChunk* next;
+	size_t size; // usable bytes after the header
+	size_t used;
+	char padding[8]; // keep data 16 bytes aligned
+} SMemoryPoolChunk;
+
+// Large blocks keep a link so Reset/Destroy can still release them
+typedef struct SMemoryPoolLargeBlock
+{
+	struct SMemoryPoolLargeBlock* next;
+	struct SMemoryPoolLargeBlock* prev;
+} SMemoryPoolLargeBlock;
+
+typedef struct SMemoryPool
+{
+	SMemoryPoolFreeBlock* freeLists[MEMORY_POOL_CLASS_COUNT];
+	SMemoryPoolChunk* chunks; // Newest first, only the newest one is bump allocated
+	SMemoryPoolLargeBlock* largeBlocks;
+	size_t nextChunkSize;
+	size_t usedBytes;
+	EMemoryTag tag;
+} SMemoryPool;
+
+#ifdef __cplusplus
+static_assert(sizeof(SMemoryPoolChunk) % MEMORY_POOL_ALIGNMENT == 0, "Chunk header must keep blocks aligned!");
+static_assert(sizeof(SMemoryPoolLargeBlock) % MEMORY_POOL_ALIGNMENT == 0, "Large block header must keep blocks aligned!");
+#else
+_Static_assert(sizeof(SMemoryPoolChunk) % MEMORY_POOL_ALIGNMENT == 0, "Chunk header must keep blocks aligned!");
+_Static_assert(sizeof(SMemoryPoolLargeBlock) % MEMORY_POOL_ALIGNMENT == 0, "Large block header must keep blocks aligned!");
+#endif
+
+static size_t MemoryPool_RoundSize(size_t size)
+{
+	if (size == 0)
+	{
+		size = 1;
+	}
+
+	return ((size + MEMORY_POOL_ALIGNMENT - 1) & ~(size_t)(MEMORY_POOL_ALIGNMENT - 1));
+}
+
+static void* MemoryPool_AllocLarge(MemoryPool pool, size_t size)
+{
+	SMemoryPoolLargeBlock* block = engine_malloc(sizeof(SMemoryPoolLargeBlock) + size, pool->tag);
+	if (block == NULL)
+	{
+		return (NULL);
+	}
+
+	block->prev = NULL;
+	block->next = pool->largeBlocks;
+	if (pool->largeBlocks != NULL)
+	{
+		pool->largeBlocks->prev = block;
+	}
+	pool->largeBlocks = block;
+
+	return (block + 1);
+}
+
+static void MemoryPool_FreeLarge(MemoryPool pool, void* pObject)
+{
+	SMemoryPoolLargeBlock* block = (SMemoryPoolLargeBlock*)pObject - 1;
+
+	if (block->prev != NULL)
+	{
+		block->prev->next = block->next;
+	}
+	else
+	{
+		pool->largeBlocks = block->next;
+	}
+
+	if (block->next != NULL)
+	{
+		block->next->prev = block->prev;
+	}
+
+	engine_free(block);
+}
+
+static void MemoryPool_ReleaseAll(MemoryPool pool)
+{
+	SMemoryPoolChunk* chunk = pool->chunks;
+	while (chunk != NULL)
+	{
+		SMemoryPoolChunk* next = chunk->next;
+		engine_free(chunk);
+		chunk = next;
+	}
+
+	SMemoryPoolLargeBlock* block = pool->largeBlocks;
+	while (block != NULL)
+	{
+		SMemoryPoolLargeBlock* next = block->next;
+		engine_free(block);
+		block = next;
+	}
+
+	memset(pool->freeLists, 0, sizeof(pool->freeLists));
+	pool->chunks = NULL;
+	pool->largeBlocks = NULL;
+	pool->nextChunkSize = MEMORY_POOL_MIN_CHUNK_SIZE;
+	pool->usedBytes = 0;
+}
+
+bool MemoryPool_Initialize(MemoryPool* ppPool, EMemoryTag tag)
+{
+	if (ppPool == NULL)
+	{
+		return (false);
+	}
+
+	*ppPool = engine_new_zero(SMemoryPool, 1, tag);
+	MemoryPool pool = *ppPool;
+
+	if (pool == NULL)
+	{
+		syserr("Failed to Allocate Memory for MemoryPool");
+		return (false);
+	}
+
+	pool->tag = tag;
+	pool->nextChunkSize = MEMORY_POOL_MIN_CHUNK_SIZE;
+	return (true);
+}
+
+void MemoryPool_Destroy(MemoryPool* ppPool)
+{
+	if (ppPool == NULL || *ppPool == NULL)
+	{
+		return;
+	}
+
+	MemoryPool_ReleaseAll(*ppPool);
+
+	engine_delete(*ppPool);
+	*ppPool = NULL;
+}
+
+void* MemoryPool_Alloc(MemoryPool pool, size_t size)
+{
+	if (pool == NULL)
+	{
+		return (NULL);
+	}
+
+	size = MemoryPool_RoundSize(size);
+	if (size > MEMORY_POOL_MAX_SMALL_SIZE)
+	{
+		void* large = MemoryPool_AllocLarge(pool, size);
+		pool->usedBytes += (large != NULL) ? size : 0;
+		return (large);
+	}
+
+	// Recycled block of the same class first
+	size_t sizeClass = size / MEMORY_POOL_ALIGNMENT - 1;
+	SMemoryPoolFreeBlock* block = pool->freeLists[sizeClass];
+	if (block != NULL)
+	{
+		pool->freeLists[sizeClass] = block->next;
+		pool->usedBytes += size;
+		return (block);
+	}
+
+	SMemoryPoolChunk* chunk = pool->chunks;
+	if (chunk == NULL || chunk->size - chunk->used < size)
+	{
+		// The tail of the old chunk is wasted, at most one small block
+		size_t chunkSize = pool->nextChunkSize;
+		chunk = engine_malloc(sizeof(SMemoryPoolChunk) + chunkSize, pool->tag);
+		if (chunk == NULL)
+		{
+			return (NULL);
+		}
+
+		chunk->size = chunkSize;
+		chunk->used = 0;
+		chunk->next = pool->chunks;
+		pool->chunks = chunk;
+
+		// Small pools stay small, big ones quickly reach few large chunks
+		if (pool->nextChunkSize < MEMORY_POOL_MAX_CHUNK_SIZE)
+		{
+			pool->nextChunkSize *= 2;
+		}
+	}
+
+	void* pObject = (char*)(chunk + 1) + chunk->used;
+	chunk->used += size;
+	pool->usedBytes += size;
+	return (pObject);
+}
+
+void MemoryPool_Free(MemoryPool pool, void* pObject, size_t size)
+{
+	if (pool == NULL || pObject == NULL)
+	{
+		return;
+	}
+
+	size = MemoryPool_RoundSize(size);
+	pool->usedBytes -= size;
+
+	if (size > MEMORY_POOL_MAX_SMALL_SIZE)
+	{
+		MemoryPool_FreeLarge(pool, pObject);
+		return;
+	}
+
+	size_t sizeClass = size / MEMORY_POOL_ALIGNMENT - 1;
+	SMemoryPoolFreeBlock* block = (SMemoryPoolFreeBlock*)pObject;
+	block->next = pool->freeLists[sizeClass];
+	pool->freeLists[sizeClass] = block;
+}
+
+void MemoryPool_Reset(MemoryPool pool)
+{
+	if (pool == NULL)
+	{
+		return;
+	}
+
+	MemoryPool_ReleaseAll(pool);
+}
+
+size_t MemoryPool_GetUsedBytes(MemoryPool pool)
+{
+	if (pool == NULL)
+	{
+		return (0);
+	}
+
+	return (pool->usedBytes);
+}
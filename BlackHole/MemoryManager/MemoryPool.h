@@ -0,0 +1,28 @@
+#ifndef __MEMORY_POOL_H__
+#define __MEMORY_POOL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "MemoryTags.h"
+
+#define MEMORY_POOL_ALIGNMENT 16
+#define MEMORY_POOL_MAX_SMALL_SIZE 512 // Bigger requests go straight to the MemoryManager
+
+typedef struct SMemoryPool* MemoryPool;
+
+// Small blocks are carved out of tagged chunks and recycled through per-size freelists,
+// so a container pays one MemoryManager allocation per chunk instead of one per element.
+bool MemoryPool_Initialize(MemoryPool* ppPool, EMemoryTag tag);
+void MemoryPool_Destroy(MemoryPool* ppPool);
+
+// 16 bytes aligned, 'size' must be passed back unchanged to MemoryPool_Free
+void* MemoryPool_Alloc(MemoryPool pool, size_t size);
+void MemoryPool_Free(MemoryPool pool, void* pObject, size_t size);
+
+// Releases every block at once, outstanding pointers become invalid
+void MemoryPool_Reset(MemoryPool pool);
+
+size_t MemoryPool_GetUsedBytes(MemoryPool pool);
+
+#endif // __MEMORY_POOL_H__
@@ -0,0 +1,284 @@
+#include "Profiler.h"
+#include "../Threading/Atomic.h"
+#include "../Threading/Thread.h"
+#include "../Stdafx.h"
+
+typedef struct SProfilerEvent
+{
+	const char* name;
+	uint64_t startTicks;
+	uint64_t endTicks;
+} SProfilerEvent;
+
+// Single producer ring: only the owning thread writes, the exporter reads up to writeIndex
+typedef struct SProfilerThread
+{
+	volatile int64_t writeIndex; // Zones ever written, the ring keeps the last PROFILER_THREAD_EVENTS
+	int64_t exportStart; // Exporter side, moved by Profiler_Reset
+	volatile int32_t isOwned; // 0 once the thread called Profiler_ReleaseThread, the next new thread takes the ring
+	uint32_t threadIndex;
+	char name[PROFILER_THREAD_NAME_LENGTH];
+	SProfilerEvent events[PROFILER_THREAD_EVENTS];
+} SProfilerThread;
+
+typedef struct SProfiler
+{
+	SProfilerThread* volatile threads[PROFILER_MAX_THREADS];
+	volatile int32_t threadsCount;
+	volatile int32_t isRunning;
+	volatile int32_t generation; // Bumped by Initialize/Destroy so threads drop their stale ring
+
+	// Calibration point for the tick -> time conversion
+	uint64_t startTicks;
+	uint64_t startNs;
+} SProfiler;
+
+static SProfiler s_profiler = { 0 };
+static THREAD_LOCAL SProfilerThread* s_profilerThread = NULL;
+static THREAD_LOCAL int32_t s_profilerGeneration = 0;
+
+// Hands a ring released by an exited thread over, its zones stay for the export
+static SProfilerThread* Profiler_ReuseThread()
+{
+	int32_t threadsCount = Atomic_Load32(&s_profiler.threadsCount);
+	if (threadsCount > PROFILER_MAX_THREADS)
+	{
+		threadsCount = PROFILER_MAX_THREADS;
+	}
+
+	for (int32_t i = 0; i < threadsCount; i++)
+	{
+		SProfilerThread* thread = (SProfilerThread*)Atomic_LoadPtr((void* volatile*)&s_profiler.threads[i]);
+		if (thread != NULL && Atomic_Load32(&thread->isOwned) == 0 && Atomic_CompareExchange32(&thread->isOwned, 0, 1))
+		{
+			snprintf(thread->name, sizeof(thread->name), "Thread %u", thread->threadIndex);
+			return (thread);
+		}
+	}
+
+	return (NULL);
+}
+
+// Returns NULL once every slot is owned, the thread then records nothing
+static SProfilerThread* Profiler_GetThread()
+{
+	int32_t generation = Atomic_Load32(&s_profiler.generation);
+	if (s_profilerGeneration == generation)
+	{
+		return (s_profilerThread);
+	}
+
+	s_profilerGeneration = generation;
+	s_profilerThread = Profiler_ReuseThread();
+	if (s_profilerThread != NULL)
+	{
+		return (s_profilerThread);
+	}
+
+	int32_t slot = Atomic_FetchAdd32(&s_profiler.threadsCount, 1);
+	if (slot >= PROFILER_MAX_THREADS)
+	{
+		return (NULL);
+	}
+
+	// Not through the MemoryManager: it is instrumented itself
+	SProfilerThread* thread = (SProfilerThread*)calloc(1, sizeof(SProfilerThread));
+	if (thread == NULL)
+	{
+		syserr("Failed to Allocate Memory for a profiler thread ring");
+		return (NULL);
+	}
+
+	thread->threadIndex = (uint32_t)slot;
+	thread->isOwned = 1;
+	snprintf(thread->name, sizeof(thread->name), "Thread %d", slot);
+
+	Atomic_StorePtr((void* volatile*)&s_profiler.threads[slot], thread);
+	s_profilerThread = thread;
+	return (thread);
+}
+
+bool Profiler_Initialize()
+{
+	if (Atomic_Load32(&s_profiler.isRunning) != 0)
+	{
+		return (true);
+	}
+
+	s_profiler.startNs = Clock_GetTimeNs();
+	s_profiler.startTicks = Profiler_GetTicks();
+
+	Atomic_Increment32(&s_profiler.generation);
+	Atomic_Store32(&s_profiler.isRunning, 1);
+	return (true);
+}
+
+void Profiler_Destroy()
+{
+	Atomic_Store32(&s_profiler.isRunning, 0);
+	Atomic_Increment32(&s_profiler.generation);
+
+	for (int i = 0; i < PROFILER_MAX_THREADS; i++)
+	{
+		free(s_profiler.threads[i]);
+		s_profiler.threads[i] = NULL;
+	}
+
+	Atomic_Store32(&s_profiler.threadsCount, 0);
+}
+
+void Profiler_ReleaseThread()
+{
+	if (s_profilerThread != NULL && s_profilerGeneration == Atomic_Load32(&s_profiler.generation))
+	{
+		Atomic_Store32(&s_profilerThread->isOwned, 0);
+	}
+
+	// A later zone on this thread picks a ring again
+	s_profilerThread = NULL;
+	s_profilerGeneration = 0;
+}
+
+void Profiler_Reset()
+{
+	for (int i = 0; i < PROFILER_MAX_THREADS; i++)
+	{
+		SProfilerThread* thread = (SProfilerThread*)Atomic_LoadPtr((void* volatile*)&s_profiler.threads[i]);
+		if (thread != NULL)
+		{
+			thread->exportStart = Atomic_Load64(&thread->writeIndex);
+		}
+	}
+}
+
+void Profiler_SetThreadName(const char* name)
+{
+	if (name == NULL || Atomic_Load32(&s_profiler.isRunning) == 0)
+	{
+		return;
+	}
+
+	SProfilerThread* thread = Profiler_GetThread();
+	if (thread != NULL)
+	{
+		snprintf(thread->name, sizeof(thread->name), "%s", name);
+	}
+}
+
+void Profiler_RecordZone(const char* name, uint64_t startTicks, uint64_t endTicks)
+{
+	if (Atomic_Load32(&s_profiler.isRunning) == 0)
+	{
+		return;
+	}
+
+	SProfilerThread* thread = Profiler_GetThread();
+	if (thread == NULL)
+	{
+		return;
+	}
+
+	int64_t index = thread->writeIndex;
+	SProfilerEvent* event = &thread->events[index & (PROFILER_THREAD_EVENTS - 1)];
+	event->name = name;
+	event->startTicks = startTicks;
+	event->endTicks = endTicks;
+
+	// release: the event is complete before the exporter can see it
+	Atomic_Store64(&thread->writeIndex, index + 1);
+}
+
+// Writes 'text' as a quoted JSON string, a name with a quote or a backslash would break the trace
+static void Profiler_WriteJsonString(FILE* file, const char* text)
+{
+	fputc('"', file);
+
+	for (const unsigned char* c = (const unsigned char*)text; *c != '\0'; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			fputc('\\', file);
+			fputc(*c, file);
+		}
+		else if (*c < 0x20)
+		{
+			fprintf(file, "\\u%04x", *c);
+		}
+		else
+		{
+			fputc(*c, file);
+		}
+	}
+
+	fputc('"', file);
+}
+
+bool Profiler_ExportChromeTrace(const char* path)
+{
+	if (path == NULL)
+	{
+		return (false);
+	}
+
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+	{
+		syserr("Profiler: failed to open %s", path);
+		return (false);
+	}
+
+	// Calibrate ticks against the clock over the whole recording
+	uint64_t elapsedNs = Clock_GetTimeNs() - s_profiler.startNs;
+	uint64_t elapsedTicks = Profiler_GetTicks() - s_profiler.startTicks;
+	double microsecondsPerTick = (elapsedTicks > 0) ? (double)elapsedNs / (double)elapsedTicks / 1000.0 : 0.001;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+	bool isFirst = true;
+	int64_t droppedCount = 0;
+	int32_t threadsCount = Atomic_Load32(&s_profiler.threadsCount);
+	for (int32_t i = 0; i < threadsCount && i < PROFILER_MAX_THREADS; i++)
+	{
+		SProfilerThread* thread = (SProfilerThread*)Atomic_LoadPtr((void* volatile*)&s_profiler.threads[i]);
+		if (thread == NULL)
+		{
+			continue;
+		}
+
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+			isFirst ? "" : ",\n", thread->threadIndex);
+		Profiler_WriteJsonString(file, thread->name);
+		fprintf(file, "}}");
+		isFirst = false;
+
+		int64_t writeIndex = Atomic_Load64(&thread->writeIndex);
+		int64_t first = thread->exportStart;
+		if (writeIndex - first > PROFILER_THREAD_EVENTS)
+		{
+			droppedCount += writeIndex - first - PROFILER_THREAD_EVENTS;
+			first = writeIndex - PROFILER_THREAD_EVENTS;
+		}
+
+		for (int64_t index = first; index < writeIndex; index++)
+		{
+			SProfilerEvent* event = &thread->events[index & (PROFILER_THREAD_EVENTS - 1)];
+			double start = (double)(int64_t)(event->startTicks - s_profiler.startTicks) * microsecondsPerTick;
+			double duration = (double)(event->endTicks - event->startTicks) * microsecondsPerTick;
+
+			fprintf(file, ",\n{\"name\":");
+			Profiler_WriteJsonString(file, event->name);
+			fprintf(file, ",\"cat\":\"BlackHole\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				thread->threadIndex, start, duration);
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	if (droppedCount > 0)
+	{
+		syslog("Profiler: %lld zones were overwritten, raise PROFILER_THREAD_EVENTS", (long long)droppedCount);
+	}
+
+	return (true);
+}
@@ -0,0 +1,61 @@
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../Clock/Clock.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// #define ENABLE_PROFILER
+
+#define PROFILER_MAX_THREADS 64
+#define PROFILER_THREAD_EVENTS 65536 // Per thread ring, must be a power of two. Oldest zones are overwritten.
+#define PROFILER_THREAD_NAME_LENGTH 32
+
+// Raw timestamp (TSC on x64), converted to time only when exporting
+static inline uint64_t Profiler_GetTicks()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return __rdtsc();
+#else
+	return Clock_GetTimeNs();
+#endif
+}
+
+// Starts recording, zones hit before this are ignored
+bool Profiler_Initialize();
+// Call once no thread records anymore
+void Profiler_Destroy();
+// Drops every recorded zone
+void Profiler_Reset();
+
+void Profiler_SetThreadName(const char* name);
+// Hands the ring of the calling thread to the next new thread, call it before a thread that recorded exits
+void Profiler_ReleaseThread();
+// Lock free: each thread writes its own ring
+void Profiler_RecordZone(const char* name, uint64_t startTicks, uint64_t endTicks);
+
+// Writes the zones in Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// Threads still recording may tear their oldest entries, export between frames or after the work.
+bool Profiler_ExportChromeTrace(const char* path);
+
+// Zones are free when ENABLE_PROFILER is off. Call END on every path leaving the zone.
+#if defined(ENABLE_PROFILER)
+#define PROFILE_ZONE_BEGIN(zone) const uint64_t zone##_zoneStart = Profiler_GetTicks()
+#define PROFILE_ZONE_END(zone) Profiler_RecordZone(#zone, zone##_zoneStart, Profiler_GetTicks())
+#define PROFILE_THREAD_NAME(name) Profiler_SetThreadName(name)
+#else
+#define PROFILE_ZONE_BEGIN(zone) ((void)0)
+#define PROFILE_ZONE_END(zone) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // __PROFILER_H__
@@ -15,6 +15,8 @@
 #include <sys/stat.h>
 #include <assert.h>
 #include <xmmintrin.h> // SSE
+#include "Log/Log.h"
 
-#define syserr(...) fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); fflush(stderr);
-#define syslog(...) fprintf(stdout, __VA_ARGS__); fprintf(stdout, "\n"); fflush(stdout);
+// Queued to the log writer thread once Log_Initialize ran, written synchronously before that
+#define syserr(...) log_error(__VA_ARGS__)
+#define syslog(...) log_info(__VA_ARGS__)
@@ -0,0 +1,221 @@
+#include "StringTable.h"
+#include "../Map/HashMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#define STRING_TABLE_INITIAL_CAPACITY 64 // Must be a power of two
+#define STRING_TABLE_BLOCK_SIZE (64 * 1024)
+
+// Strings are packed back to back in big blocks, a handle never moves
+typedef struct SStringTableBlock
+{
+	struct SStringTableBlock* next;
+	size_t used;
+	size_t capacity;
+	uint8_t data[];
+} SStringTableBlock;
+
+typedef struct SStringTable
+{
+	InternedString* entries; // Open addressing, NULL = empty
+	size_t capacity;
+	size_t elementsCount;
+	SStringTableBlock* blocks; // Newest first
+} SStringTable;
+
+static void* StringTable_AllocateBytes(StringTable table, size_t size)
+{
+	// Keep every handle aligned for its uint64_t hash
+	size = (size + 7) & ~(size_t)7;
+
+	SStringTableBlock* block = table->blocks;
+	if (block == NULL || block->capacity - block->used < size)
+	{
+		size_t capacity = size > STRING_TABLE_BLOCK_SIZE ? size : STRING_TABLE_BLOCK_SIZE;
+
+		block = engine_malloc(sizeof(SStringTableBlock) + capacity, MEM_TAG_STRINGS);
+		if (block == NULL)
+		{
+			return (NULL);
+		}
+
+		block->used = 0;
+		block->capacity = capacity;
+		block->next = table->blocks;
+		table->blocks = block;
+	}
+
+	void* memory = block->data + block->used;
+	block->used += size;
+	return (memory);
+}
+
+static size_t StringTable_FindSlot(StringTable table, const char* szString, uint64_t hash, size_t length)
+{
+	size_t mask = table->capacity - 1;
+	size_t slot = (size_t)hash & mask;
+
+	// Hash and length reject almost every mismatch before memcmp
+	while (table->entries[slot] != NULL)
+	{
+		InternedString entry = table->entries[slot];
+		if (entry->hash == hash && entry->length == length && memcmp(entry->szString, szString, length) == 0)
+		{
+			break;
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	return (slot);
+}
+
+static bool StringTable_Grow(StringTable table)
+{
+	size_t newCapacity = table->capacity * 2;
+	InternedString* newEntries = engine_new_count_zero(InternedString, newCapacity, MEM_TAG_STRINGS);
+	if (newEntries == NULL)
+	{
+		return (false);
+	}
+
+	size_t mask = newCapacity - 1;
+	for (size_t i = 0; i < table->capacity; i++)
+	{
+		InternedString entry = table->entries[i];
+		if (entry == NULL)
+		{
+			continue;
+		}
+
+		size_t slot = (size_t)entry->hash & mask;
+		while (newEntries[slot] != NULL)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		newEntries[slot] = entry;
+	}
+
+	engine_free((void*)table->entries);
+	table->entries = newEntries;
+	table->capacity = newCapacity;
+	return (true);
+}
+
+bool StringTable_Initialize(StringTable* ppTable)
+{
+	if (ppTable == NULL)
+	{
+		return (false);
+	}
+
+	*ppTable = engine_new_zero(SStringTable, 1, MEM_TAG_STRINGS);
+	StringTable table = *ppTable;
+
+	if (table == NULL)
+	{
+		syserr("Failed to Allocate StringTable Memory");
+		return (false);
+	}
+
+	table->entries = engine_new_count_zero(InternedString, STRING_TABLE_INITIAL_CAPACITY, MEM_TAG_STRINGS);
+	if (table->entries == NULL)
+	{
+		engine_delete(table);
+		*ppTable = NULL;
+		return (false);
+	}
+
+	table->capacity = STRING_TABLE_INITIAL_CAPACITY;
+	return (true);
+}
+
+void StringTable_Destroy(StringTable* ppTable)
+{
+	if (ppTable == NULL || *ppTable == NULL)
+	{
+		return;
+	}
+
+	StringTable table = *ppTable;
+
+	SStringTableBlock* block = table->blocks;
+	while (block != NULL)
+	{
+		SStringTableBlock* next = block->next;
+		engine_free(block);
+		block = next;
+	}
+
+	engine_free((void*)table->entries);
+	engine_delete(table);
+
+	*ppTable = NULL;
+}
+
+InternedString StringTable_Intern(StringTable table, const char* szString)
+{
+	if (table == NULL || szString == NULL)
+	{
+		return (NULL);
+	}
+
+	size_t length = strlen(szString);
+	uint64_t hash = HashMap_HashString(szString);
+
+	size_t slot = StringTable_FindSlot(table, szString, hash, length);
+	if (table->entries[slot] != NULL)
+	{
+		return (table->entries[slot]);
+	}
+
+	// Grow at 50% load, linear probing degrades quickly past that
+	if ((table->elementsCount + 1) * 2 > table->capacity)
+	{
+		if (!StringTable_Grow(table))
+		{
+			syserr("Failed to grow StringTable");
+			return (NULL);
+		}
+
+		slot = StringTable_FindSlot(table, szString, hash, length);
+	}
+
+	SInternedString* entry = StringTable_AllocateBytes(table, sizeof(SInternedString) + length + 1);
+	if (entry == NULL)
+	{
+		syserr("Failed to allocate interned string memory");
+		return (NULL);
+	}
+
+	entry->hash = hash;
+	entry->length = (uint32_t)length;
+	memcpy(entry->szString, szString, length + 1);
+
+	table->entries[slot] = entry;
+	table->elementsCount++;
+	return (entry);
+}
+
+InternedString StringTable_Find(StringTable table, const char* szString)
+{
+	if (table == NULL || szString == NULL)
+	{
+		return (NULL);
+	}
+
+	size_t length = strlen(szString);
+	size_t slot = StringTable_FindSlot(table, szString, HashMap_HashString(szString), length);
+	return (table->entries[slot]);
+}
+
+size_t StringTable_GetCount(StringTable table)
+{
+	if (table == NULL)
+	{
+		return (0);
+	}
+
+	return (table->elementsCount);
+}
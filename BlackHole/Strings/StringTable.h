@@ -0,0 +1,32 @@
+#ifndef __STRING_TABLE_H__
+#define __STRING_TABLE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// One stored copy per distinct string, the address is the identity:
+// two handles are the same string if and only if the pointers are equal
+typedef struct SInternedString
+{
+	uint64_t hash; // HashMap_HashString of szString
+	uint32_t length;
+	char szString[]; // null terminated
+} SInternedString;
+
+typedef const SInternedString* InternedString;
+
+typedef struct SStringTable* StringTable;
+
+bool StringTable_Initialize(StringTable* ppTable);
+// Releases every handle handed out by this table
+void StringTable_Destroy(StringTable* ppTable);
+
+// Returns the existing handle or stores a new one, handles stay valid until StringTable_Destroy
+InternedString StringTable_Intern(StringTable table, const char* szString);
+// Lookup only, NULL when the string was never interned
+InternedString StringTable_Find(StringTable table, const char* szString);
+
+size_t StringTable_GetCount(StringTable table);
+
+#endif // __STRING_TABLE_H__
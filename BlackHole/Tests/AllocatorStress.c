@@ -0,0 +1,197 @@
+#include "StressTest.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Threading/Atomic.h"
+#include "../Threading/RingBuffer.h"
+#include "../Threading/Thread.h"
+#include "../Log/Log.h"
+#include "../Stdafx.h"
+
+#define ALLOCATOR_STRESS_MAX_THREADS 32
+#define ALLOCATOR_STRESS_RING_CAPACITY 256
+
+typedef struct SAllocatorStressBlock
+{
+	uint32_t size; // Whole block, header included
+	uint8_t pattern;
+	uint8_t bytes[];
+} SAllocatorStressBlock;
+
+typedef struct SAllocatorStressShared
+{
+	MpmcRing ring; // Blocks in flight from an allocating thread to a freeing one
+	uint32_t blocksPerThread;
+	uint32_t producersCount;
+	volatile int32_t startFlag;
+	volatile int32_t isAborted;
+	volatile int64_t freedCount;
+	volatile int32_t errorsCount;
+} SAllocatorStressShared;
+
+typedef struct SAllocatorStressThread
+{
+	ThreadHandle thread;
+	SAllocatorStressShared* shared;
+	uint32_t index;
+} SAllocatorStressThread;
+
+static void AllocatorStress_WaitStart(volatile int32_t* startFlag)
+{
+	while (Atomic_Load32(startFlag) == 0)
+	{
+		Thread_Yield();
+	}
+}
+
+static void AllocatorStress_ProducerMain(void* arg)
+{
+	SAllocatorStressThread* context = (SAllocatorStressThread*)arg;
+	SAllocatorStressShared* shared = context->shared;
+
+	MemoryManager_InitializeThreadCache();
+	AllocatorStress_WaitStart(&shared->startFlag);
+
+	for (uint32_t i = 0; i < shared->blocksPerThread; i++)
+	{
+		// Mostly small blocks from the thread cache, every 16th one above it
+		uint32_t size = (uint32_t)sizeof(SAllocatorStressBlock) + ((i & 15) == 0 ? 2048 + i % 1024 : 8 + (i * 37) % 200);
+		SAllocatorStressBlock* block = engine_malloc(size, MEM_TAG_ENGINE);
+		if (block == NULL)
+		{
+			syserr("AllocatorStress: failed to allocate %u bytes", size);
+			Atomic_Increment32(&shared->errorsCount);
+			Atomic_Store32(&shared->isAborted, 1);
+			break;
+		}
+
+		block->size = size;
+		block->pattern = (uint8_t)(context->index * 31 + i);
+		memset(block->bytes, block->pattern, size - sizeof(SAllocatorStressBlock));
+
+		bool isPushed = false;
+		while (!(isPushed = MpmcRing_Push(shared->ring, &block)) && Atomic_Load32(&shared->isAborted) == 0)
+		{
+			Thread_Yield();
+		}
+
+		if (!isPushed)
+		{
+			engine_free(block);
+			break;
+		}
+	}
+
+	// Blocks still queued now belong to the global list, the consumers free them from there
+	MemoryManager_DestroyThreadCache();
+	Log_ReleaseThread();
+}
+
+static void AllocatorStress_ConsumerMain(void* arg)
+{
+	SAllocatorStressThread* context = (SAllocatorStressThread*)arg;
+	SAllocatorStressShared* shared = context->shared;
+	int64_t expectedCount = (int64_t)shared->producersCount * shared->blocksPerThread;
+
+	MemoryManager_InitializeThreadCache();
+	AllocatorStress_WaitStart(&shared->startFlag);
+
+	while (Atomic_Load64(&shared->freedCount) < expectedCount && Atomic_Load32(&shared->isAborted) == 0)
+	{
+		SAllocatorStressBlock* block;
+		if (!MpmcRing_Pop(shared->ring, &block))
+		{
+			Thread_Yield();
+			continue;
+		}
+
+		// Someone else writing into a live block shows up as a wrong byte
+		for (uint32_t i = 0; i < block->size - sizeof(SAllocatorStressBlock); i++)
+		{
+			if (block->bytes[i] != block->pattern)
+			{
+				syserr("AllocatorStress: block %p of %u bytes corrupted at %u", (void*)block, block->size, i);
+				Atomic_Increment32(&shared->errorsCount);
+				break;
+			}
+		}
+
+		engine_free(block);
+		Atomic_FetchAdd64(&shared->freedCount, 1);
+	}
+
+	MemoryManager_DestroyThreadCache();
+	Log_ReleaseThread();
+}
+
+bool AllocatorStress_CrossThreadFree(uint32_t threadsCount, uint32_t blocksPerThread)
+{
+	if (threadsCount == 0 || threadsCount > ALLOCATOR_STRESS_MAX_THREADS)
+	{
+		return (false);
+	}
+
+	SAllocatorStressShared shared = { 0 };
+	shared.blocksPerThread = blocksPerThread;
+	shared.producersCount = threadsCount;
+
+	if (!MpmcRing_Initialize(&shared.ring, sizeof(SAllocatorStressBlock*), ALLOCATOR_STRESS_RING_CAPACITY, MEM_TAG_ENGINE))
+	{
+		syserr("AllocatorStress: failed to create the ring");
+		return (false);
+	}
+
+	SAllocatorStressThread producers[ALLOCATOR_STRESS_MAX_THREADS];
+	SAllocatorStressThread consumers[ALLOCATOR_STRESS_MAX_THREADS];
+	uint32_t producersStarted = 0;
+	uint32_t consumersStarted = 0;
+
+	for (; producersStarted < threadsCount; producersStarted++)
+	{
+		SAllocatorStressThread* context = &producers[producersStarted];
+		context->shared = &shared;
+		context->index = producersStarted;
+		if (!Thread_Create(&context->thread, AllocatorStress_ProducerMain, context))
+		{
+			break;
+		}
+	}
+
+	for (; consumersStarted < threadsCount; consumersStarted++)
+	{
+		SAllocatorStressThread* context = &consumers[consumersStarted];
+		context->shared = &shared;
+		context->index = consumersStarted;
+		if (!Thread_Create(&context->thread, AllocatorStress_ConsumerMain, context))
+		{
+			break;
+		}
+	}
+
+	bool isStarted = (producersStarted == threadsCount && consumersStarted == threadsCount);
+	if (!isStarted)
+	{
+		syserr("AllocatorStress: failed to start the threads");
+		Atomic_Store32(&shared.isAborted, 1);
+	}
+
+	Atomic_Store32(&shared.startFlag, 1);
+
+	for (uint32_t i = 0; i < producersStarted; i++)
+	{
+		Thread_Join(producers[i].thread);
+	}
+
+	for (uint32_t i = 0; i < consumersStarted; i++)
+	{
+		Thread_Join(consumers[i].thread);
+	}
+
+	// Whatever an aborted run left behind
+	SAllocatorStressBlock* block;
+	while (MpmcRing_Pop(shared.ring, &block))
+	{
+		engine_free(block);
+	}
+
+	MpmcRing_Destroy(&shared.ring);
+	return (isStarted && shared.errorsCount == 0);
+}
@@ -0,0 +1,194 @@
+#include "StressTest.h"
+#include "../Map/ConcurrentMap.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Threading/Atomic.h"
+#include "../Threading/Epoch.h"
+#include "../Threading/Thread.h"
+#include "../Log/Log.h"
+#include "../Stdafx.h"
+
+#define MAP_STRESS_MAX_THREADS 32
+#define MAP_STRESS_SHARED_KEYS 512 // Few enough that threads keep colliding on the same entries
+#define MAP_STRESS_PRIVATE_KEYS 256
+#define MAP_STRESS_KEY_LENGTH 32
+
+typedef struct SMapStressThread
+{
+	ThreadHandle thread;
+	ConcurrentMap map;
+	uint32_t index;
+	uint32_t operationsCount;
+	volatile int32_t* startFlag;
+	uint32_t errorsCount;
+	uint32_t privateLiveCount;
+} SMapStressThread;
+
+// The value names its key, a Find returning anything else read a torn or recycled entry
+static void* ConcurrentMapStress_MakeValue(uint32_t owner, uint32_t key)
+{
+	return ((void*)(uintptr_t)(((uintptr_t)(owner + 1) << 16) | key));
+}
+
+static bool ConcurrentMapStress_IsValueOf(void* value, uint32_t owner, uint32_t key)
+{
+	return (value == ConcurrentMapStress_MakeValue(owner, key));
+}
+
+static uint32_t ConcurrentMapStress_NextRandom(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return (*state);
+}
+
+static void ConcurrentMapStress_ThreadMain(void* arg)
+{
+	SMapStressThread* context = (SMapStressThread*)arg;
+	uint32_t state = 0x9E3779B9u * (context->index + 1);
+	bool isPrivateLive[MAP_STRESS_PRIVATE_KEYS] = { false };
+	char key[MAP_STRESS_KEY_LENGTH];
+
+	while (Atomic_Load32(context->startFlag) == 0)
+	{
+		Thread_Yield();
+	}
+
+	for (uint32_t i = 0; i < context->operationsCount; i++)
+	{
+		uint32_t random = ConcurrentMapStress_NextRandom(&state);
+		uint32_t operation = random % 4;
+
+		// Shared keys: any thread may have stored it, the value must still match the key.
+		// Every shared value is written with owner 0 so the check does not depend on who won.
+		if ((random >> 8) & 1)
+		{
+			uint32_t keyIndex = (random >> 9) % MAP_STRESS_SHARED_KEYS;
+			snprintf(key, sizeof(key), "shared/%u", keyIndex);
+
+			if (operation == 0)
+			{
+				ConcurrentMap_Insert(context->map, key, ConcurrentMapStress_MakeValue(0, keyIndex));
+			}
+			else if (operation == 1)
+			{
+				ConcurrentMap_Delete(context->map, key);
+			}
+			else
+			{
+				void* value = ConcurrentMap_Find(context->map, key);
+				if (value != NULL && !ConcurrentMapStress_IsValueOf(value, 0, keyIndex) && context->errorsCount++ == 0)
+				{
+					syserr("ConcurrentMapStress: %s holds %p", key, value);
+				}
+			}
+
+			continue;
+		}
+
+		// Private keys: only this thread touches them, so every Find has one right answer
+		uint32_t keyIndex = (random >> 9) % MAP_STRESS_PRIVATE_KEYS;
+		snprintf(key, sizeof(key), "thread%u/%u", context->index, keyIndex);
+
+		if (operation == 0)
+		{
+			ConcurrentMap_Insert(context->map, key, ConcurrentMapStress_MakeValue(context->index + 1, keyIndex));
+			isPrivateLive[keyIndex] = true;
+		}
+		else if (operation == 1)
+		{
+			ConcurrentMap_Delete(context->map, key);
+			isPrivateLive[keyIndex] = false;
+		}
+		else
+		{
+			void* value = ConcurrentMap_Find(context->map, key);
+			bool isMatch = isPrivateLive[keyIndex]
+				? ConcurrentMapStress_IsValueOf(value, context->index + 1, keyIndex)
+				: (value == NULL);
+
+			if (!isMatch && context->errorsCount++ == 0)
+			{
+				syserr("ConcurrentMapStress: %s holds %p, expected it %s", key, value, isPrivateLive[keyIndex] ? "live" : "deleted");
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < MAP_STRESS_PRIVATE_KEYS; i++)
+	{
+		context->privateLiveCount += isPrivateLive[i] ? 1 : 0;
+	}
+
+	Epoch_ReleaseThread();
+	Log_ReleaseThread();
+}
+
+bool ConcurrentMapStress_InsertDeleteFind(uint32_t threadsCount, uint32_t operationsCount)
+{
+	if (threadsCount == 0 || threadsCount > MAP_STRESS_MAX_THREADS)
+	{
+		return (false);
+	}
+
+	ConcurrentMap map = NULL;
+	if (!ConcurrentMap_Initialize(&map, MEM_TAG_ENGINE))
+	{
+		syserr("ConcurrentMapStress: failed to create the map");
+		return (false);
+	}
+
+	SMapStressThread threads[MAP_STRESS_MAX_THREADS];
+	volatile int32_t startFlag = 0;
+	uint32_t startedCount = 0;
+
+	for (; startedCount < threadsCount; startedCount++)
+	{
+		SMapStressThread* context = &threads[startedCount];
+		memset(context, 0, sizeof(SMapStressThread));
+		context->map = map;
+		context->index = startedCount;
+		context->operationsCount = operationsCount;
+		context->startFlag = &startFlag;
+
+		if (!Thread_Create(&context->thread, ConcurrentMapStress_ThreadMain, context))
+		{
+			syserr("ConcurrentMapStress: failed to start thread %u", startedCount);
+			break;
+		}
+	}
+
+	Atomic_Store32(&startFlag, 1);
+
+	uint32_t errorsCount = 0;
+	size_t expectedCount = 0;
+	for (uint32_t i = 0; i < startedCount; i++)
+	{
+		Thread_Join(threads[i].thread);
+		errorsCount += threads[i].errorsCount;
+		expectedCount += threads[i].privateLiveCount;
+	}
+
+	// Quiescent now: the shared keys still there must hold their value, and the count must add up
+	char key[MAP_STRESS_KEY_LENGTH];
+	for (uint32_t keyIndex = 0; keyIndex < MAP_STRESS_SHARED_KEYS; keyIndex++)
+	{
+		snprintf(key, sizeof(key), "shared/%u", keyIndex);
+		void* value = ConcurrentMap_Find(map, key);
+		if (value != NULL)
+		{
+			expectedCount++;
+			errorsCount += ConcurrentMapStress_IsValueOf(value, 0, keyIndex) ? 0 : 1;
+		}
+	}
+
+	size_t count = ConcurrentMap_GetCount(map);
+	if (count != expectedCount)
+	{
+		syserr("ConcurrentMapStress: %zu entries, expected %zu", count, expectedCount);
+		errorsCount++;
+	}
+
+	ConcurrentMap_Destroy(&map);
+	Epoch_ReleaseThread();
+	return (startedCount == threadsCount && errorsCount == 0);
+}
@@ -0,0 +1,259 @@
+#include "StressTest.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Threading/Atomic.h"
+#include "../Threading/RingBuffer.h"
+#include "../Threading/Thread.h"
+#include "../Log/Log.h"
+#include "../Stdafx.h"
+
+#define RING_STRESS_MAX_THREADS 32
+#define RING_STRESS_CAPACITY 64 // Small on purpose, the indices wrap thousands of times
+
+typedef struct SRingStressShared
+{
+	MpmcRing ring;
+	uint32_t producersCount;
+	uint32_t valuesPerProducer;
+	volatile int32_t startFlag;
+	volatile int32_t isAborted; // A thread failed to start, everybody leaves
+	volatile int64_t poppedCount; // Values taken out so far
+	volatile int64_t poppedSum;
+	volatile int32_t errorsCount;
+} SRingStressShared;
+
+typedef struct SRingStressThread
+{
+	ThreadHandle thread;
+	SRingStressShared* shared;
+	uint32_t index;
+} SRingStressThread;
+
+// Value = producer in the high half, sequence in the low half
+static uint64_t RingBufferStress_Encode(uint32_t producer, uint32_t sequence)
+{
+	return (((uint64_t)producer << 32) | sequence);
+}
+
+static void RingBufferStress_WaitStart(volatile int32_t* startFlag)
+{
+	while (Atomic_Load32(startFlag) == 0)
+	{
+		Thread_Yield();
+	}
+}
+
+static void RingBufferStress_ProducerMain(void* arg)
+{
+	SRingStressThread* context = (SRingStressThread*)arg;
+	SRingStressShared* shared = context->shared;
+	RingBufferStress_WaitStart(&shared->startFlag);
+
+	for (uint32_t i = 0; i < shared->valuesPerProducer; i++)
+	{
+		uint64_t value = RingBufferStress_Encode(context->index, i);
+		while (!MpmcRing_Push(shared->ring, &value))
+		{
+			if (Atomic_Load32(&shared->isAborted) != 0)
+			{
+				Log_ReleaseThread();
+				return;
+			}
+
+			Thread_Yield();
+		}
+	}
+
+	Log_ReleaseThread();
+}
+
+static void RingBufferStress_ConsumerMain(void* arg)
+{
+	SRingStressThread* context = (SRingStressThread*)arg;
+	SRingStressShared* shared = context->shared;
+	int64_t expectedCount = (int64_t)shared->producersCount * shared->valuesPerProducer;
+
+	// A FIFO hands the values of one producer to any single consumer in push order
+	int64_t lastSequence[RING_STRESS_MAX_THREADS];
+	for (uint32_t i = 0; i < RING_STRESS_MAX_THREADS; i++)
+	{
+		lastSequence[i] = -1;
+	}
+
+	RingBufferStress_WaitStart(&shared->startFlag);
+
+	while (Atomic_Load64(&shared->poppedCount) < expectedCount && Atomic_Load32(&shared->isAborted) == 0)
+	{
+		uint64_t value;
+		if (!MpmcRing_Pop(shared->ring, &value))
+		{
+			Thread_Yield();
+			continue;
+		}
+
+		uint32_t producer = (uint32_t)(value >> 32);
+		uint32_t sequence = (uint32_t)value;
+		if (producer >= shared->producersCount || (int64_t)sequence <= lastSequence[producer])
+		{
+			syserr("RingBufferStress: consumer %u got %u:%u out of order", context->index, producer, sequence);
+			Atomic_Increment32(&shared->errorsCount);
+		}
+		else
+		{
+			lastSequence[producer] = sequence;
+		}
+
+		Atomic_FetchAdd64(&shared->poppedSum, (int64_t)value);
+		Atomic_FetchAdd64(&shared->poppedCount, 1);
+	}
+
+	Log_ReleaseThread();
+}
+
+bool RingBufferStress_MpmcSum(uint32_t producersCount, uint32_t consumersCount, uint32_t valuesPerProducer)
+{
+	if (producersCount == 0 || consumersCount == 0
+		|| producersCount > RING_STRESS_MAX_THREADS || consumersCount > RING_STRESS_MAX_THREADS)
+	{
+		return (false);
+	}
+
+	SRingStressShared shared = { 0 };
+	shared.producersCount = producersCount;
+	shared.valuesPerProducer = valuesPerProducer;
+
+	if (!MpmcRing_Initialize(&shared.ring, sizeof(uint64_t), RING_STRESS_CAPACITY, MEM_TAG_ENGINE))
+	{
+		syserr("RingBufferStress: failed to create the MPMC ring");
+		return (false);
+	}
+
+	SRingStressThread producers[RING_STRESS_MAX_THREADS];
+	SRingStressThread consumers[RING_STRESS_MAX_THREADS];
+	uint32_t producersStarted = 0;
+	uint32_t consumersStarted = 0;
+
+	for (; consumersStarted < consumersCount; consumersStarted++)
+	{
+		SRingStressThread* context = &consumers[consumersStarted];
+		context->shared = &shared;
+		context->index = consumersStarted;
+		if (!Thread_Create(&context->thread, RingBufferStress_ConsumerMain, context))
+		{
+			break;
+		}
+	}
+
+	for (; producersStarted < producersCount; producersStarted++)
+	{
+		SRingStressThread* context = &producers[producersStarted];
+		context->shared = &shared;
+		context->index = producersStarted;
+		if (!Thread_Create(&context->thread, RingBufferStress_ProducerMain, context))
+		{
+			break;
+		}
+	}
+
+	bool isStarted = (producersStarted == producersCount && consumersStarted == consumersCount);
+	if (!isStarted)
+	{
+		syserr("RingBufferStress: failed to start the threads");
+		Atomic_Store32(&shared.isAborted, 1);
+	}
+
+	Atomic_Store32(&shared.startFlag, 1);
+
+	for (uint32_t i = 0; i < producersStarted; i++)
+	{
+		Thread_Join(producers[i].thread);
+	}
+
+	for (uint32_t i = 0; i < consumersStarted; i++)
+	{
+		Thread_Join(consumers[i].thread);
+	}
+
+	// Sum of every sequence plus every producer index shifted into the high half
+	int64_t expectedSum = 0;
+	for (uint32_t producer = 0; producer < producersCount; producer++)
+	{
+		expectedSum += (int64_t)RingBufferStress_Encode(producer, 0) * valuesPerProducer;
+		expectedSum += (int64_t)valuesPerProducer * (valuesPerProducer - 1) / 2;
+	}
+
+	bool isPassed = isStarted && shared.errorsCount == 0 && shared.poppedSum == expectedSum && MpmcRing_GetCount(shared.ring) == 0;
+	if (isStarted && shared.poppedSum != expectedSum)
+	{
+		syserr("RingBufferStress: MPMC sum %lld, expected %lld", (long long)shared.poppedSum, (long long)expectedSum);
+	}
+
+	MpmcRing_Destroy(&shared.ring);
+	return (isPassed);
+}
+
+typedef struct SSpscStressShared
+{
+	SpscRing ring;
+	uint32_t valuesCount;
+	volatile int32_t startFlag;
+	uint32_t errorsCount; // Consumer only
+} SSpscStressShared;
+
+static void RingBufferStress_SpscProducerMain(void* arg)
+{
+	SSpscStressShared* shared = (SSpscStressShared*)arg;
+	RingBufferStress_WaitStart(&shared->startFlag);
+
+	for (uint32_t i = 0; i < shared->valuesCount; i++)
+	{
+		while (!SpscRing_Push(shared->ring, &i))
+		{
+			Thread_Yield();
+		}
+	}
+
+	Log_ReleaseThread();
+}
+
+bool RingBufferStress_SpscOrder(uint32_t valuesCount)
+{
+	SSpscStressShared shared = { 0 };
+	shared.valuesCount = valuesCount;
+
+	if (!SpscRing_Initialize(&shared.ring, sizeof(uint32_t), RING_STRESS_CAPACITY, MEM_TAG_ENGINE))
+	{
+		syserr("RingBufferStress: failed to create the SPSC ring");
+		return (false);
+	}
+
+	ThreadHandle producer;
+	if (!Thread_Create(&producer, RingBufferStress_SpscProducerMain, &shared))
+	{
+		syserr("RingBufferStress: failed to start the SPSC producer");
+		SpscRing_Destroy(&shared.ring);
+		return (false);
+	}
+
+	// The calling thread is the consumer
+	Atomic_Store32(&shared.startFlag, 1);
+
+	for (uint32_t expected = 0; expected < valuesCount; expected++)
+	{
+		uint32_t value;
+		while (!SpscRing_Pop(shared.ring, &value))
+		{
+			Thread_Yield();
+		}
+
+		if (value != expected && shared.errorsCount++ == 0)
+		{
+			syserr("RingBufferStress: SPSC popped %u, expected %u", value, expected);
+		}
+	}
+
+	Thread_Join(producer);
+
+	bool isPassed = (shared.errorsCount == 0 && SpscRing_GetCount(shared.ring) == 0);
+	SpscRing_Destroy(&shared.ring);
+	return (isPassed);
+}
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "MemoryManager/MemoryManager.h"
+#include "Threading/Thread.h"
+#include "Tests/StressTest.h"
+#include "Log/Log.h"
+#include "Stdafx.h"
+
+#define STRESS_MAX_THREADS 8 // Per side, enough to contend without making TSan runs crawl
+
+// Usage: BlackHoleStress [operations per thread] [threads]
+int main(int argc, char** argv)
+{
+	uint32_t operationsCount = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200000;
+	uint32_t threadsCount = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : Thread_GetHardwareConcurrency();
+
+	if (threadsCount < 2)
+	{
+		threadsCount = 2; // Still interleaves on a single core
+	}
+	else if (threadsCount > STRESS_MAX_THREADS)
+	{
+		threadsCount = STRESS_MAX_THREADS;
+	}
+
+	MemoryManager memManager;
+	if (MemoryManager_Initialize(&memManager) == false)
+	{
+		return (EXIT_FAILURE);
+	}
+
+	Log_Initialize();
+
+	printf("BlackHole stress tests: %u operations per thread, %u threads\n", operationsCount, threadsCount);
+
+	uint32_t failedCount = 0;
+	bool isPassed;
+
+	isPassed = RingBufferStress_MpmcSum(threadsCount, threadsCount, operationsCount);
+	syslog("%-40s %s", "RingBuffer MPMC sum and order", isPassed ? "passed" : "FAILED");
+	failedCount += isPassed ? 0 : 1;
+
+	isPassed = RingBufferStress_SpscOrder(operationsCount * 4);
+	syslog("%-40s %s", "RingBuffer SPSC order", isPassed ? "passed" : "FAILED");
+	failedCount += isPassed ? 0 : 1;
+
+	isPassed = ConcurrentMapStress_InsertDeleteFind(threadsCount, operationsCount);
+	syslog("%-40s %s", "ConcurrentMap insert/delete/find", isPassed ? "passed" : "FAILED");
+	failedCount += isPassed ? 0 : 1;
+
+	isPassed = AllocatorStress_CrossThreadFree(threadsCount, operationsCount / 4);
+	syslog("%-40s %s", "MemoryManager cross thread free", isPassed ? "passed" : "FAILED");
+	failedCount += isPassed ? 0 : 1;
+
+	Log_Destroy(); // Joins the writer thread, its start block would otherwise show as a leak
+	MemoryManager_DumpLeaks();
+	MemoryManager_Destroy(&memManager);
+
+	printf("%u stress test(s) failed\n", failedCount);
+	return ((failedCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,22 @@
+#ifndef __STRESS_TEST_H__
+#define __STRESS_TEST_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Multi-threaded checks of the lock-free and epoch code, run them under TSan too.
+// Each returns false once a check failed, the failure is reported through syserr.
+
+// Producers push (producer, sequence) pairs, consumers check the sum, the count and the per producer order
+bool RingBufferStress_MpmcSum(uint32_t producersCount, uint32_t consumersCount, uint32_t valuesPerProducer);
+// One producer, one consumer, every value must come out in order through a small ring that wraps a lot
+bool RingBufferStress_SpscOrder(uint32_t valuesCount);
+
+// Threads insert, delete and find shared keys (values must match their key) and private keys (exact state)
+bool ConcurrentMapStress_InsertDeleteFind(uint32_t threadsCount, uint32_t operationsCount);
+
+// Blocks allocated on thread cached threads are checked and freed on others, some after their owner exited
+bool AllocatorStress_CrossThreadFree(uint32_t threadsCount, uint32_t blocksPerThread);
+
+#endif // __STRESS_TEST_H__
@@ -0,0 +1,65 @@
+#ifndef __ATOMIC_H__
+#define __ATOMIC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Thin wrappers over the compiler intrinsics.
+// Load = acquire, Store = release, every read-modify-write is a full barrier.
+// The MSVC path assumes x86/x64 (the only platforms in BlackHole.vcxproj).
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <emmintrin.h>
+
+static __forceinline int32_t Atomic_Load32(volatile int32_t* ptr) { int32_t value = *ptr; _ReadWriteBarrier(); return value; }
+static __forceinline void Atomic_Store32(volatile int32_t* ptr, int32_t value) { _ReadWriteBarrier(); *ptr = value; }
+static __forceinline int32_t Atomic_Increment32(volatile int32_t* ptr) { return _InterlockedIncrement((volatile long*)ptr); }
+static __forceinline int32_t Atomic_Decrement32(volatile int32_t* ptr) { return _InterlockedDecrement((volatile long*)ptr); }
+static __forceinline int32_t Atomic_FetchAdd32(volatile int32_t* ptr, int32_t value) { return _InterlockedExchangeAdd((volatile long*)ptr, value); }
+static __forceinline int32_t Atomic_Exchange32(volatile int32_t* ptr, int32_t value) { return _InterlockedExchange((volatile long*)ptr, value); }
+static __forceinline bool Atomic_CompareExchange32(volatile int32_t* ptr, int32_t expected, int32_t desired) { return _InterlockedCompareExchange((volatile long*)ptr, desired, expected) == expected; }
+
+static __forceinline int64_t Atomic_Load64(volatile int64_t* ptr) { int64_t value = *ptr; _ReadWriteBarrier(); return value; }
+static __forceinline void Atomic_Store64(volatile int64_t* ptr, int64_t value) { _ReadWriteBarrier(); *ptr = value; }
+static __forceinline int64_t Atomic_FetchAdd64(volatile int64_t* ptr, int64_t value) { return _InterlockedExchangeAdd64(ptr, value); }
+static __forceinline bool Atomic_CompareExchange64(volatile int64_t* ptr, int64_t expected, int64_t desired) { return _InterlockedCompareExchange64(ptr, desired, expected) == expected; }
+
+static __forceinline void* Atomic_LoadPtr(void* volatile* ptr) { void* value = *ptr; _ReadWriteBarrier(); return value; }
+static __forceinline void Atomic_StorePtr(void* volatile* ptr, void* value) { _ReadWriteBarrier(); *ptr = value; }
+static __forceinline void* Atomic_ExchangePtr(void* volatile* ptr, void* value) { return _InterlockedExchangePointer(ptr, value); }
+static __forceinline bool Atomic_CompareExchangePtr(void* volatile* ptr, void* expected, void* desired) { return _InterlockedCompareExchangePointer(ptr, desired, expected) == expected; }
+
+static __forceinline void Atomic_ThreadFence() { _mm_mfence(); }
+static __forceinline void Atomic_CpuPause() { _mm_pause(); }
+
+#else
+
+static inline int32_t Atomic_Load32(volatile int32_t* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void Atomic_Store32(volatile int32_t* ptr, int32_t value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+static inline int32_t Atomic_Increment32(volatile int32_t* ptr) { return __atomic_add_fetch(ptr, 1, __ATOMIC_SEQ_CST); }
+static inline int32_t Atomic_Decrement32(volatile int32_t* ptr) { return __atomic_sub_fetch(ptr, 1, __ATOMIC_SEQ_CST); }
+static inline int32_t Atomic_FetchAdd32(volatile int32_t* ptr, int32_t value) { return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST); }
+static inline int32_t Atomic_Exchange32(volatile int32_t* ptr, int32_t value) { return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST); }
+static inline bool Atomic_CompareExchange32(volatile int32_t* ptr, int32_t expected, int32_t desired) { return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+static inline int64_t Atomic_Load64(volatile int64_t* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void Atomic_Store64(volatile int64_t* ptr, int64_t value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+static inline int64_t Atomic_FetchAdd64(volatile int64_t* ptr, int64_t value) { return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST); }
+static inline bool Atomic_CompareExchange64(volatile int64_t* ptr, int64_t expected, int64_t desired) { return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+static inline void* Atomic_LoadPtr(void* volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void Atomic_StorePtr(void* volatile* ptr, void* value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+static inline void* Atomic_ExchangePtr(void* volatile* ptr, void* value) { return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST); }
+static inline bool Atomic_CompareExchangePtr(void* volatile* ptr, void* expected, void* desired) { return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+static inline void Atomic_ThreadFence() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#if defined(__x86_64__) || defined(__i386__)
+static inline void Atomic_CpuPause() { __builtin_ia32_pause(); }
+#else
+static inline void Atomic_CpuPause() { }
+#endif
+
+#endif
+
+#endif // __ATOMIC_H__
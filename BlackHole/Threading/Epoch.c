@@ -0,0 +1,116 @@
+#include "Epoch.h"
+#include "Atomic.h"
+#include "Thread.h"
+#include "../Stdafx.h"
+
+typedef struct SEpochSlot
+{
+	volatile int64_t epoch;
+	volatile int32_t isOwned; // 1 while a thread holds the slot
+	char padding[64 - sizeof(int64_t) - sizeof(int32_t)]; // one cache line per reader
+} SEpochSlot;
+
+static SEpochSlot epochSlots[EPOCH_MAX_THREADS];
+static volatile int64_t globalEpoch = 1;
+static volatile int32_t usedSlots = 0; // High-water mark, released slots below it are reused
+
+static THREAD_LOCAL int32_t threadSlot = 0; // index + 1, 0 = not assigned, -1 = none left
+static THREAD_LOCAL uint32_t threadDepth = 0;
+
+static void Epoch_AcquireSlot()
+{
+	for (;;)
+	{
+		int32_t slotsCount = Atomic_Load32(&usedSlots);
+
+		// Reuse a slot released by a thread that exited
+		for (int32_t i = 0; i < slotsCount; i++)
+		{
+			if (Atomic_Load32(&epochSlots[i].isOwned) == 0 && Atomic_CompareExchange32(&epochSlots[i].isOwned, 0, 1))
+			{
+				threadSlot = i + 1;
+				return;
+			}
+		}
+
+		if (slotsCount >= EPOCH_MAX_THREADS)
+		{
+			syserr("Epoch: out of reader slots, thread falls back to locking");
+			threadSlot = -1;
+			return;
+		}
+
+		// Open one more slot, the next scan races for it like for any free one
+		Atomic_CompareExchange32(&usedSlots, slotsCount, slotsCount + 1);
+	}
+}
+
+void Epoch_ReleaseThread()
+{
+	if (threadSlot > 0)
+	{
+		SEpochSlot* slot = &epochSlots[threadSlot - 1];
+		Atomic_Store64(&slot->epoch, EPOCH_INACTIVE);
+		Atomic_Store32(&slot->isOwned, 0);
+	}
+
+	threadSlot = 0;
+	threadDepth = 0;
+}
+
+bool Epoch_Enter()
+{
+	if (threadSlot == 0)
+	{
+		Epoch_AcquireSlot();
+	}
+
+	if (threadSlot < 0)
+	{
+		return (false);
+	}
+
+	// nested sections keep the outer epoch
+	if (threadDepth++ == 0)
+	{
+		SEpochSlot* slot = &epochSlots[threadSlot - 1];
+		Atomic_Store64(&slot->epoch, Atomic_Load64(&globalEpoch));
+
+		// the slot must be visible before we read any shared pointer
+		Atomic_ThreadFence();
+	}
+
+	return (true);
+}
+
+void Epoch_Exit()
+{
+	if (threadSlot > 0 && --threadDepth == 0)
+	{
+		Atomic_Store64(&epochSlots[threadSlot - 1].epoch, EPOCH_INACTIVE);
+	}
+}
+
+int64_t Epoch_Advance()
+{
+	return Atomic_FetchAdd64(&globalEpoch, 1);
+}
+
+int64_t Epoch_GetMinActive()
+{
+	int32_t slotsCount = Atomic_Load32(&usedSlots);
+
+	Atomic_ThreadFence(); // pairs with the fence in Epoch_Enter
+
+	int64_t minEpoch = INT64_MAX;
+	for (int32_t i = 0; i < slotsCount; i++)
+	{
+		int64_t epoch = Atomic_Load64(&epochSlots[i].epoch);
+		if (epoch != EPOCH_INACTIVE && epoch < minEpoch)
+		{
+			minEpoch = epoch;
+		}
+	}
+
+	return (minEpoch);
+}
@@ -0,0 +1,27 @@
+#ifndef __EPOCH_H__
+#define __EPOCH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Epoch based reclamation for lock-free readers.
+// A reader publishes the global epoch while it holds pointers into a shared structure;
+// a writer unlinks an object, tags it with Epoch_Advance() and frees it once
+// Epoch_GetMinActive() is greater than that tag.
+
+#define EPOCH_MAX_THREADS 128 // Slots are taken on first use and held until Epoch_ReleaseThread
+#define EPOCH_INACTIVE 0
+
+// Returns false when every slot is taken, the caller has to fall back to a lock
+bool Epoch_Enter();
+void Epoch_Exit();
+// Hands the slot of the calling thread back for reuse, call it before a thread that read exits
+void Epoch_ReleaseThread();
+
+// Call after unlinking, the returned epoch is the object's retire tag
+int64_t Epoch_Advance();
+
+// Oldest epoch a reader is still inside of, INT64_MAX when nobody reads
+int64_t Epoch_GetMinActive();
+
+#endif // __EPOCH_H__
@@ -0,0 +1,296 @@
+#include "RingBuffer.h"
+#include "Atomic.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#include <string.h>
+
+#define RING_BUFFER_CACHE_LINE 64
+#define RING_BUFFER_MAX_CAPACITY 0x80000000u
+
+typedef struct SSpscRing
+{
+	// Read only after Initialize, shared by both sides
+	uint8_t* buffer;
+	size_t elementSize;
+	int64_t mask;
+
+	char sharedPadding[RING_BUFFER_CACHE_LINE];
+
+	// Consumer line: its index plus the last producer index it saw, so it only
+	// reads the producer's line when the ring looks empty
+	volatile int64_t head;
+	int64_t cachedTail;
+	char headPadding[RING_BUFFER_CACHE_LINE - 2 * sizeof(int64_t)];
+
+	// Producer line, mirror of the above
+	volatile int64_t tail;
+	int64_t cachedHead;
+	char tailPadding[RING_BUFFER_CACHE_LINE - 2 * sizeof(int64_t)];
+} SSpscRing;
+
+// 'sequence' == position: free for the producer of that position,
+// position + 1: filled for its consumer, position + capacity: free for the next lap
+typedef struct SMpmcCell
+{
+	volatile int64_t sequence;
+	uint8_t data[]; // elementSize bytes, cells are cellSize apart
+} SMpmcCell;
+
+typedef struct SMpmcRing
+{
+	uint8_t* cells;
+	size_t elementSize;
+	size_t cellSize;
+	int64_t mask;
+
+	char sharedPadding[RING_BUFFER_CACHE_LINE];
+
+	volatile int64_t enqueuePos;
+	char enqueuePadding[RING_BUFFER_CACHE_LINE - sizeof(int64_t)];
+
+	volatile int64_t dequeuePos;
+	char dequeuePadding[RING_BUFFER_CACHE_LINE - sizeof(int64_t)];
+} SMpmcRing;
+
+static uint32_t RingBuffer_RoundCapacity(uint32_t capacity)
+{
+	uint32_t rounded = 2;
+	while (rounded < capacity)
+	{
+		rounded <<= 1;
+	}
+
+	return (rounded);
+}
+
+bool SpscRing_Initialize(SpscRing* ppRing, size_t elementSize, uint32_t capacity, EMemoryTag tag)
+{
+	if (ppRing == NULL || elementSize == 0 || capacity > RING_BUFFER_MAX_CAPACITY)
+	{
+		return (false);
+	}
+
+	capacity = RingBuffer_RoundCapacity(capacity);
+
+	*ppRing = engine_new_zero(SSpscRing, 1, tag);
+	SpscRing ring = *ppRing;
+
+	if (ring == NULL)
+	{
+		syserr("Failed to Allocate Memory for SpscRing");
+		return (false);
+	}
+
+	ring->buffer = engine_malloc(elementSize * capacity, tag);
+	if (ring->buffer == NULL)
+	{
+		syserr("Failed to Allocate Memory for SpscRing buffer");
+		engine_delete(ring);
+		*ppRing = NULL;
+		return (false);
+	}
+
+	ring->elementSize = elementSize;
+	ring->mask = (int64_t)capacity - 1;
+	return (true);
+}
+
+void SpscRing_Destroy(SpscRing* ppRing)
+{
+	if (ppRing == NULL || *ppRing == NULL)
+	{
+		return;
+	}
+
+	engine_free((*ppRing)->buffer);
+	engine_delete(*ppRing);
+	*ppRing = NULL;
+}
+
+bool SpscRing_Push(SpscRing ring, const void* value)
+{
+	int64_t tail = ring->tail; // Only this thread writes it
+
+	if (tail - ring->cachedHead > ring->mask)
+	{
+		ring->cachedHead = Atomic_Load64(&ring->head);
+		if (tail - ring->cachedHead > ring->mask)
+		{
+			return (false);
+		}
+	}
+
+	memcpy(ring->buffer + (size_t)(tail & ring->mask) * ring->elementSize, value, ring->elementSize);
+
+	// Release: the copy is visible before the consumer sees the new tail
+	Atomic_Store64(&ring->tail, tail + 1);
+	return (true);
+}
+
+bool SpscRing_Pop(SpscRing ring, void* outValue)
+{
+	int64_t head = ring->head; // Only this thread writes it
+
+	if (head == ring->cachedTail)
+	{
+		ring->cachedTail = Atomic_Load64(&ring->tail);
+		if (head == ring->cachedTail)
+		{
+			return (false);
+		}
+	}
+
+	memcpy(outValue, ring->buffer + (size_t)(head & ring->mask) * ring->elementSize, ring->elementSize);
+
+	// The slot may be overwritten once the producer sees the new head
+	Atomic_Store64(&ring->head, head + 1);
+	return (true);
+}
+
+uint32_t SpscRing_GetCount(SpscRing ring)
+{
+	int64_t head = Atomic_Load64(&ring->head);
+	int64_t tail = Atomic_Load64(&ring->tail);
+	return ((tail > head) ? (uint32_t)(tail - head) : 0);
+}
+
+uint32_t SpscRing_GetCapacity(SpscRing ring)
+{
+	return ((uint32_t)(ring->mask + 1));
+}
+
+static SMpmcCell* MpmcRing_GetCell(MpmcRing ring, int64_t position)
+{
+	return ((SMpmcCell*)(ring->cells + (size_t)(position & ring->mask) * ring->cellSize));
+}
+
+bool MpmcRing_Initialize(MpmcRing* ppRing, size_t elementSize, uint32_t capacity, EMemoryTag tag)
+{
+	if (ppRing == NULL || elementSize == 0 || capacity > RING_BUFFER_MAX_CAPACITY)
+	{
+		return (false);
+	}
+
+	capacity = RingBuffer_RoundCapacity(capacity);
+
+	*ppRing = engine_new_zero(SMpmcRing, 1, tag);
+	MpmcRing ring = *ppRing;
+
+	if (ring == NULL)
+	{
+		syserr("Failed to Allocate Memory for MpmcRing");
+		return (false);
+	}
+
+	// Keeps every sequence 8 byte aligned
+	ring->cellSize = (sizeof(SMpmcCell) + elementSize + 7) & ~(size_t)7;
+	ring->cells = engine_malloc(ring->cellSize * capacity, tag);
+	if (ring->cells == NULL)
+	{
+		syserr("Failed to Allocate Memory for MpmcRing cells");
+		engine_delete(ring);
+		*ppRing = NULL;
+		return (false);
+	}
+
+	ring->elementSize = elementSize;
+	ring->mask = (int64_t)capacity - 1;
+
+	for (uint32_t i = 0; i < capacity; i++)
+	{
+		MpmcRing_GetCell(ring, i)->sequence = i;
+	}
+
+	return (true);
+}
+
+void MpmcRing_Destroy(MpmcRing* ppRing)
+{
+	if (ppRing == NULL || *ppRing == NULL)
+	{
+		return;
+	}
+
+	engine_free((*ppRing)->cells);
+	engine_delete(*ppRing);
+	*ppRing = NULL;
+}
+
+bool MpmcRing_Push(MpmcRing ring, const void* value)
+{
+	int64_t position = Atomic_Load64(&ring->enqueuePos);
+	SMpmcCell* cell;
+
+	for (;;)
+	{
+		cell = MpmcRing_GetCell(ring, position);
+		int64_t difference = Atomic_Load64(&cell->sequence) - position;
+
+		if (difference == 0)
+		{
+			// The cell is free for this position, claim it
+			if (Atomic_CompareExchange64(&ring->enqueuePos, position, position + 1))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Still holds the value from the previous lap
+			return (false);
+		}
+
+		// Another producer got there first
+		position = Atomic_Load64(&ring->enqueuePos);
+	}
+
+	memcpy(cell->data, value, ring->elementSize);
+	Atomic_Store64(&cell->sequence, position + 1);
+	return (true);
+}
+
+bool MpmcRing_Pop(MpmcRing ring, void* outValue)
+{
+	int64_t position = Atomic_Load64(&ring->dequeuePos);
+	SMpmcCell* cell;
+
+	for (;;)
+	{
+		cell = MpmcRing_GetCell(ring, position);
+		int64_t difference = Atomic_Load64(&cell->sequence) - (position + 1);
+
+		if (difference == 0)
+		{
+			if (Atomic_CompareExchange64(&ring->dequeuePos, position, position + 1))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Not written yet
+			return (false);
+		}
+
+		position = Atomic_Load64(&ring->dequeuePos);
+	}
+
+	memcpy(outValue, cell->data, ring->elementSize);
+
+	// Hand the cell to the producer one lap ahead
+	Atomic_Store64(&cell->sequence, position + ring->mask + 1);
+	return (true);
+}
+
+uint32_t MpmcRing_GetCount(MpmcRing ring)
+{
+	int64_t dequeuePos = Atomic_Load64(&ring->dequeuePos);
+	int64_t enqueuePos = Atomic_Load64(&ring->enqueuePos);
+	return ((enqueuePos > dequeuePos) ? (uint32_t)(enqueuePos - dequeuePos) : 0);
+}
+
+uint32_t MpmcRing_GetCapacity(MpmcRing ring)
+{
+	return ((uint32_t)(ring->mask + 1));
+}
@@ -0,0 +1,36 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../MemoryManager/MemoryTags.h"
+
+// Bounded lock-free queues of fixed size elements, copied in and out by value.
+// The capacity is rounded up to a power of two. Push fails when full and Pop when empty, neither blocks.
+
+// One producer thread and one consumer thread, each side writes only its own index
+typedef struct SSpscRing* SpscRing;
+
+bool SpscRing_Initialize(SpscRing* ppRing, size_t elementSize, uint32_t capacity, EMemoryTag tag);
+void SpscRing_Destroy(SpscRing* ppRing);
+
+bool SpscRing_Push(SpscRing ring, const void* value); // Producer only
+bool SpscRing_Pop(SpscRing ring, void* outValue); // Consumer only
+// Exact on either side while the other one is idle, a snapshot otherwise
+uint32_t SpscRing_GetCount(SpscRing ring);
+uint32_t SpscRing_GetCapacity(SpscRing ring);
+
+// Any number of producers and consumers. Each cell carries a sequence number telling whose turn it is,
+// so threads only contend on the compare-exchange of the index they move.
+typedef struct SMpmcRing* MpmcRing;
+
+bool MpmcRing_Initialize(MpmcRing* ppRing, size_t elementSize, uint32_t capacity, EMemoryTag tag);
+void MpmcRing_Destroy(MpmcRing* ppRing);
+
+bool MpmcRing_Push(MpmcRing ring, const void* value);
+bool MpmcRing_Pop(MpmcRing ring, void* outValue);
+uint32_t MpmcRing_GetCount(MpmcRing ring); // Snapshot
+uint32_t MpmcRing_GetCapacity(MpmcRing ring);
+
+#endif // __RING_BUFFER_H__
@@ -0,0 +1,190 @@
+#include "Thread.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Stdafx.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// The OS entry points have different signatures, so we box the user's function and argument
+typedef struct SThreadStart
+{
+	fnThreadFunc function;
+	void* arg;
+} SThreadStart;
+
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI Thread_Trampoline(LPVOID param)
+#else
+static void* Thread_Trampoline(void* param)
+#endif
+{
+	SThreadStart start = *(SThreadStart*)param;
+	engine_delete((SThreadStart*)param);
+
+	start.function(start.arg);
+	return (0);
+}
+
+bool Thread_Create(ThreadHandle* pThread, fnThreadFunc function, void* arg)
+{
+	if (pThread == NULL || function == NULL)
+	{
+		return (false);
+	}
+
+	SThreadStart* start = engine_new(SThreadStart, MEM_TAG_ENGINE);
+	if (start == NULL)
+	{
+		return (false);
+	}
+
+	start->function = function;
+	start->arg = arg;
+
+#if defined(_WIN32) || defined(_WIN64)
+	*pThread = CreateThread(NULL, 0, Thread_Trampoline, start, 0, NULL);
+	if (*pThread == NULL)
+	{
+		syserr("Failed to create thread (error %lu)", GetLastError());
+		engine_delete(start);
+		return (false);
+	}
+#else
+	int result = pthread_create(pThread, NULL, Thread_Trampoline, start);
+	if (result != 0)
+	{
+		syserr("Failed to create thread (error %d)", result);
+		engine_delete(start);
+		return (false);
+	}
+#endif
+
+	return (true);
+}
+
+void Thread_Join(ThreadHandle thread)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+}
+
+void Thread_Yield()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+void Thread_Sleep(uint32_t milliseconds)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	Sleep(milliseconds);
+#else
+	struct timespec duration;
+	duration.tv_sec = milliseconds / 1000;
+	duration.tv_nsec = (long)(milliseconds % 1000) * 1000000L;
+	nanosleep(&duration, NULL);
+#endif
+}
+
+uint32_t Thread_GetHardwareConcurrency()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (uint32_t)info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (uint32_t)count : 1;
+#endif
+}
+
+void Mutex_Initialize(Mutex* mutex)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	InitializeCriticalSection(mutex);
+#else
+	pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void Mutex_Destroy(Mutex* mutex)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	DeleteCriticalSection(mutex);
+#else
+	pthread_mutex_destroy(mutex);
+#endif
+}
+
+void Mutex_Lock(Mutex* mutex)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	EnterCriticalSection(mutex);
+#else
+	pthread_mutex_lock(mutex);
+#endif
+}
+
+void Mutex_Unlock(Mutex* mutex)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	LeaveCriticalSection(mutex);
+#else
+	pthread_mutex_unlock(mutex);
+#endif
+}
+
+void ConditionVariable_Initialize(ConditionVariable* condition)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	InitializeConditionVariable(condition);
+#else
+	pthread_cond_init(condition, NULL);
+#endif
+}
+
+void ConditionVariable_Destroy(ConditionVariable* condition)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	(void)condition; // Windows condition variables hold no resources
+#else
+	pthread_cond_destroy(condition);
+#endif
+}
+
+void ConditionVariable_Wait(ConditionVariable* condition, Mutex* mutex)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	SleepConditionVariableCS(condition, mutex, INFINITE);
+#else
+	pthread_cond_wait(condition, mutex);
+#endif
+}
+
+void ConditionVariable_Signal(ConditionVariable* condition)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	WakeConditionVariable(condition);
+#else
+	pthread_cond_signal(condition);
+#endif
+}
+
+void ConditionVariable_Broadcast(ConditionVariable* condition)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	WakeAllConditionVariable(condition);
+#else
+	pthread_cond_broadcast(condition);
+#endif
+}
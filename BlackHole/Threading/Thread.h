@@ -0,0 +1,43 @@
+#ifndef __THREAD_H__
+#define __THREAD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+typedef HANDLE ThreadHandle;
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE ConditionVariable;
+#define THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+typedef pthread_t ThreadHandle;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t ConditionVariable;
+#define THREAD_LOCAL _Thread_local
+#endif
+
+typedef void(*fnThreadFunc)(void* arg);
+
+bool Thread_Create(ThreadHandle* pThread, fnThreadFunc function, void* arg);
+void Thread_Join(ThreadHandle thread);
+void Thread_Yield();
+void Thread_Sleep(uint32_t milliseconds);
+uint32_t Thread_GetHardwareConcurrency();
+
+void Mutex_Initialize(Mutex* mutex);
+void Mutex_Destroy(Mutex* mutex);
+void Mutex_Lock(Mutex* mutex);
+void Mutex_Unlock(Mutex* mutex);
+
+void ConditionVariable_Initialize(ConditionVariable* condition);
+void ConditionVariable_Destroy(ConditionVariable* condition);
+void ConditionVariable_Wait(ConditionVariable* condition, Mutex* mutex);
+void ConditionVariable_Signal(ConditionVariable* condition);
+void ConditionVariable_Broadcast(ConditionVariable* condition);
+
+#endif // __THREAD_H__
@@ -0,0 +1,557 @@
+#include "ThreadPool.h"
+#include "Atomic.h"
+#include "Thread.h"
+#include "Epoch.h"
+#include "../MemoryManager/MemoryManager.h"
+#include "../Profiler/Profiler.h"
+#include "../Log/Log.h"
+#include "../Stdafx.h"
+
+#define THREAD_POOL_QUEUE_CAPACITY 4096 // Must be a power of two
+#define THREAD_POOL_MAX_WORKERS 64
+
+typedef struct STask
+{
+	fnTask function;
+	void* data;
+	TaskCounter counter;
+} STask;
+
+// A thief may copy a slot while the owner refills it, so slots are read and written field by field
+// with atomics; such a copy is always thrown away because the thief then loses the race on 'top'
+typedef struct STaskSlot
+{
+	void* volatile function;
+	void* volatile data;
+	void* volatile counter;
+} STaskSlot;
+
+// Chase-Lev deque: the owner pushes/pops at the bottom without locking (LIFO, cache warm),
+// thieves take from the top (FIFO, oldest and usually biggest work) with a compare-exchange
+typedef struct SWorkDeque
+{
+	volatile int64_t top;
+	char topPadding[64 - sizeof(int64_t)]; // thieves and owner write different cache lines
+	volatile int64_t bottom;
+	char bottomPadding[64 - sizeof(int64_t)];
+	STaskSlot slots[THREAD_POOL_QUEUE_CAPACITY];
+} SWorkDeque;
+
+// Tasks submitted from threads outside the pool, which cannot push to a worker's deque
+typedef struct STaskQueue
+{
+	STask tasks[THREAD_POOL_QUEUE_CAPACITY];
+	uint32_t top;
+	uint32_t bottom;
+	Mutex lock;
+} STaskQueue;
+
+// A task held back until its dependency counter drains
+typedef struct STaskDependent
+{
+	STask task;
+	struct STaskDependent* next;
+} STaskDependent;
+
+typedef struct SThreadPoolWorker
+{
+	struct SThreadPool* pool;
+	uint32_t index;
+	ThreadHandle thread;
+	SWorkDeque deque;
+} SThreadPoolWorker;
+
+typedef struct SThreadPool
+{
+	SThreadPoolWorker* workers;
+	uint32_t workersCount;
+	STaskQueue injectionQueue;
+
+	volatile int32_t queuedTasks; // Tasks sitting in any queue
+	volatile int32_t sleepingCount;
+	volatile int32_t isShuttingDown;
+
+	Mutex sleepLock;
+	ConditionVariable sleepCondition;
+} SThreadPool;
+
+static THREAD_LOCAL SThreadPoolWorker* s_currentWorker = NULL;
+
+static void TaskSlot_Write(STaskSlot* slot, const STask* task)
+{
+	Atomic_StorePtr(&slot->function, (void*)task->function);
+	Atomic_StorePtr(&slot->data, task->data);
+	Atomic_StorePtr(&slot->counter, task->counter);
+}
+
+static void TaskSlot_Read(STaskSlot* slot, STask* outTask)
+{
+	outTask->function = (fnTask)Atomic_LoadPtr(&slot->function);
+	outTask->data = Atomic_LoadPtr(&slot->data);
+	outTask->counter = (TaskCounter)Atomic_LoadPtr(&slot->counter);
+}
+
+// Owner only
+static bool WorkDeque_Push(SWorkDeque* deque, const STask* task)
+{
+	int64_t bottom = Atomic_Load64(&deque->bottom);
+	int64_t top = Atomic_Load64(&deque->top);
+
+	if (bottom - top >= THREAD_POOL_QUEUE_CAPACITY)
+	{
+		return (false);
+	}
+
+	TaskSlot_Write(&deque->slots[bottom & (THREAD_POOL_QUEUE_CAPACITY - 1)], task);
+
+	// release: the slot is complete before a thief can see the new bottom
+	Atomic_Store64(&deque->bottom, bottom + 1);
+	return (true);
+}
+
+// Owner only
+static bool WorkDeque_Pop(SWorkDeque* deque, STask* outTask)
+{
+	int64_t bottom = Atomic_Load64(&deque->bottom) - 1;
+	Atomic_Store64(&deque->bottom, bottom);
+
+	// thieves must see the reservation before we look at top
+	Atomic_ThreadFence();
+
+	int64_t top = Atomic_Load64(&deque->top);
+	if (top > bottom)
+	{
+		Atomic_Store64(&deque->bottom, bottom + 1);
+		return (false);
+	}
+
+	TaskSlot_Read(&deque->slots[bottom & (THREAD_POOL_QUEUE_CAPACITY - 1)], outTask);
+	if (top != bottom)
+	{
+		return (true);
+	}
+
+	// Last task: whoever moves top first gets it
+	bool won = Atomic_CompareExchange64(&deque->top, top, top + 1);
+	Atomic_Store64(&deque->bottom, bottom + 1);
+	return (won);
+}
+
+static bool WorkDeque_Steal(SWorkDeque* deque, STask* outTask)
+{
+	int64_t top = Atomic_Load64(&deque->top);
+	Atomic_ThreadFence();
+	int64_t bottom = Atomic_Load64(&deque->bottom);
+
+	if (top >= bottom)
+	{
+		return (false);
+	}
+
+	TaskSlot_Read(&deque->slots[top & (THREAD_POOL_QUEUE_CAPACITY - 1)], outTask);
+	return Atomic_CompareExchange64(&deque->top, top, top + 1);
+}
+
+static bool TaskQueue_Push(STaskQueue* queue, STask* task)
+{
+	Mutex_Lock(&queue->lock);
+
+	if (queue->bottom - queue->top >= THREAD_POOL_QUEUE_CAPACITY)
+	{
+		Mutex_Unlock(&queue->lock);
+		return (false);
+	}
+
+	queue->tasks[queue->bottom & (THREAD_POOL_QUEUE_CAPACITY - 1)] = *task;
+	queue->bottom++;
+
+	Mutex_Unlock(&queue->lock);
+	return (true);
+}
+
+static bool TaskQueue_Take(STaskQueue* queue, STask* outTask)
+{
+	Mutex_Lock(&queue->lock);
+
+	if (queue->bottom == queue->top)
+	{
+		Mutex_Unlock(&queue->lock);
+		return (false);
+	}
+
+	*outTask = queue->tasks[queue->top & (THREAD_POOL_QUEUE_CAPACITY - 1)];
+	queue->top++;
+
+	Mutex_Unlock(&queue->lock);
+	return (true);
+}
+
+static void TaskCounter_Lock(TaskCounter counter)
+{
+	while (!Atomic_CompareExchange32(&counter->lock, 0, 1))
+	{
+		Atomic_CpuPause();
+	}
+}
+
+static void TaskCounter_Unlock(TaskCounter counter)
+{
+	Atomic_Store32(&counter->lock, 0);
+}
+
+// Own deque first, then outside submissions, then steal starting from the next worker so thieves spread out
+static bool ThreadPool_FindTask(ThreadPool pool, SThreadPoolWorker* self, STask* outTask)
+{
+	uint32_t start = 0;
+	if (self != NULL && self->pool == pool)
+	{
+		if (WorkDeque_Pop(&self->deque, outTask))
+		{
+			return (true);
+		}
+
+		start = self->index + 1;
+	}
+	else
+	{
+		self = NULL;
+	}
+
+	if (TaskQueue_Take(&pool->injectionQueue, outTask))
+	{
+		return (true);
+	}
+
+	for (uint32_t i = 0; i < pool->workersCount; i++)
+	{
+		SThreadPoolWorker* victim = &pool->workers[(start + i) % pool->workersCount];
+		if (victim == self)
+		{
+			continue;
+		}
+
+		if (WorkDeque_Steal(&victim->deque, outTask))
+		{
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+static void ThreadPool_RunTask(ThreadPool pool, STask* task);
+
+// The task's counter was already incremented
+static void ThreadPool_Enqueue(ThreadPool pool, STask* task)
+{
+	// Count it before it becomes visible so a fast thief never drives the count negative
+	Atomic_Increment32(&pool->queuedTasks);
+
+	SThreadPoolWorker* self = s_currentWorker;
+	bool queued = (self != NULL && self->pool == pool) ? WorkDeque_Push(&self->deque, task) : TaskQueue_Push(&pool->injectionQueue, task);
+
+	if (!queued)
+	{
+		// Queue full, running it here is the natural back-pressure
+		ThreadPool_RunTask(pool, task);
+		return;
+	}
+
+	// Pairs with the sleeping worker re-checking queuedTasks under the lock
+	if (Atomic_FetchAdd32(&pool->sleepingCount, 0) > 0)
+	{
+		Mutex_Lock(&pool->sleepLock);
+		ConditionVariable_Signal(&pool->sleepCondition);
+		Mutex_Unlock(&pool->sleepLock);
+	}
+}
+
+static void ThreadPool_RunTask(ThreadPool pool, STask* task)
+{
+	Atomic_Decrement32(&pool->queuedTasks);
+
+	task->function(task->data);
+
+	TaskCounter counter = task->counter;
+	if (counter == NULL)
+	{
+		return;
+	}
+
+	// The lock is held across the decrement: ThreadPool_Wait only returns once it is released,
+	// so a counter living on the waiter's stack is never touched after it is gone
+	TaskCounter_Lock(counter);
+
+	STaskDependent* dependents = NULL;
+	if (Atomic_Decrement32(&counter->pending) == 0)
+	{
+		dependents = counter->dependents;
+		counter->dependents = NULL;
+	}
+
+	TaskCounter_Unlock(counter);
+
+	while (dependents != NULL)
+	{
+		STaskDependent* next = dependents->next;
+		ThreadPool_Enqueue(pool, &dependents->task);
+		engine_delete(dependents);
+		dependents = next;
+	}
+}
+
+static void ThreadPool_WorkerMain(void* arg)
+{
+	SThreadPoolWorker* worker = (SThreadPoolWorker*)arg;
+	ThreadPool pool = worker->pool;
+	s_currentWorker = worker;
+
+	// Allocations made by tasks stay off the global MemoryManager lock
+	MemoryManager_InitializeThreadCache();
+
+#if defined(ENABLE_PROFILER)
+	char threadName[PROFILER_THREAD_NAME_LENGTH];
+	snprintf(threadName, sizeof(threadName), "Worker %u", worker->index);
+	PROFILE_THREAD_NAME(threadName);
+#endif
+
+	for (;;)
+	{
+		STask task;
+		if (ThreadPool_FindTask(pool, worker, &task))
+		{
+			ThreadPool_RunTask(pool, &task);
+			continue;
+		}
+
+		Mutex_Lock(&pool->sleepLock);
+		Atomic_Increment32(&pool->sleepingCount);
+
+		// Re-check under the lock, a submit in between would otherwise be missed
+		while (Atomic_FetchAdd32(&pool->queuedTasks, 0) == 0 && Atomic_Load32(&pool->isShuttingDown) == 0)
+		{
+			ConditionVariable_Wait(&pool->sleepCondition, &pool->sleepLock);
+		}
+
+		Atomic_Decrement32(&pool->sleepingCount);
+		Mutex_Unlock(&pool->sleepLock);
+
+		// Finish whatever is queued before leaving
+		if (Atomic_Load32(&pool->isShuttingDown) != 0 && Atomic_Load32(&pool->queuedTasks) == 0)
+		{
+			break;
+		}
+	}
+
+	MemoryManager_DestroyThreadCache();
+	Log_ReleaseThread();
+	Epoch_ReleaseThread();
+	Profiler_ReleaseThread();
+	s_currentWorker = NULL;
+}
+
+bool ThreadPool_Initialize(ThreadPool* ppPool, uint32_t workersCount)
+{
+	if (ppPool == NULL)
+	{
+		return (false);
+	}
+
+	if (workersCount == 0)
+	{
+		uint32_t hardwareThreads = Thread_GetHardwareConcurrency();
+		workersCount = (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+	}
+
+	if (workersCount > THREAD_POOL_MAX_WORKERS)
+	{
+		workersCount = THREAD_POOL_MAX_WORKERS;
+	}
+
+	*ppPool = engine_new_zero(SThreadPool, 1, MEM_TAG_ENGINE);
+	ThreadPool pool = *ppPool;
+
+	if (pool == NULL)
+	{
+		syserr("Failed to Allocate Memory for ThreadPool");
+		return (false);
+	}
+
+	pool->workers = engine_new_count_zero(SThreadPoolWorker, workersCount, MEM_TAG_ENGINE);
+	if (pool->workers == NULL)
+	{
+		syserr("Failed to Allocate Memory for ThreadPool workers");
+		engine_delete(pool);
+		*ppPool = NULL;
+		return (false);
+	}
+
+	Mutex_Initialize(&pool->sleepLock);
+	ConditionVariable_Initialize(&pool->sleepCondition);
+	Mutex_Initialize(&pool->injectionQueue.lock);
+
+	for (uint32_t i = 0; i < workersCount; i++)
+	{
+		pool->workers[i].pool = pool;
+		pool->workers[i].index = i;
+	}
+
+	// Every queue must exist before the first worker starts stealing
+	pool->workersCount = workersCount;
+	for (uint32_t i = 0; i < workersCount; i++)
+	{
+		if (!Thread_Create(&pool->workers[i].thread, ThreadPool_WorkerMain, &pool->workers[i]))
+		{
+			// Keep the workers that did start, the pool still works with fewer threads
+			syserr("ThreadPool: only %u of %u workers started", i, workersCount);
+			pool->workersCount = i;
+			break;
+		}
+	}
+
+	if (pool->workersCount == 0)
+	{
+		ThreadPool_Destroy(ppPool);
+		return (false);
+	}
+
+	return (true);
+}
+
+void ThreadPool_Destroy(ThreadPool* ppPool)
+{
+	if (ppPool == NULL || *ppPool == NULL)
+	{
+		return;
+	}
+
+	ThreadPool pool = *ppPool;
+
+	Mutex_Lock(&pool->sleepLock);
+	Atomic_Store32(&pool->isShuttingDown, 1);
+	ConditionVariable_Broadcast(&pool->sleepCondition);
+	Mutex_Unlock(&pool->sleepLock);
+
+	for (uint32_t i = 0; i < pool->workersCount; i++)
+	{
+		Thread_Join(pool->workers[i].thread);
+	}
+
+	Mutex_Destroy(&pool->injectionQueue.lock);
+
+	ConditionVariable_Destroy(&pool->sleepCondition);
+	Mutex_Destroy(&pool->sleepLock);
+
+	engine_delete(pool->workers);
+	engine_delete(pool);
+
+	*ppPool = NULL;
+}
+
+bool ThreadPool_Submit(ThreadPool pool, fnTask function, void* data, TaskCounter counter)
+{
+	if (pool == NULL || function == NULL)
+	{
+		return (false);
+	}
+
+	STask task;
+	task.function = function;
+	task.data = data;
+	task.counter = counter;
+
+	if (counter != NULL)
+	{
+		Atomic_Increment32(&counter->pending);
+	}
+
+	ThreadPool_Enqueue(pool, &task);
+	return (true);
+}
+
+bool ThreadPool_SubmitAfter(ThreadPool pool, TaskCounter dependency, fnTask function, void* data, TaskCounter counter)
+{
+	if (pool == NULL || function == NULL)
+	{
+		return (false);
+	}
+
+	if (dependency == NULL)
+	{
+		return ThreadPool_Submit(pool, function, data, counter);
+	}
+
+	STaskDependent* dependent = engine_new(STaskDependent, MEM_TAG_ENGINE);
+	if (dependent == NULL)
+	{
+		syserr("Failed to Allocate Memory for a dependent task");
+		return (false);
+	}
+
+	dependent->task.function = function;
+	dependent->task.data = data;
+	dependent->task.counter = counter;
+
+	// Counted right away so waiting on 'counter' also covers the held back task
+	if (counter != NULL)
+	{
+		Atomic_Increment32(&counter->pending);
+	}
+
+	TaskCounter_Lock(dependency);
+
+	bool isReady = (Atomic_Load32(&dependency->pending) == 0);
+	if (!isReady)
+	{
+		dependent->next = dependency->dependents;
+		dependency->dependents = dependent;
+	}
+
+	TaskCounter_Unlock(dependency);
+
+	if (isReady)
+	{
+		ThreadPool_Enqueue(pool, &dependent->task);
+		engine_delete(dependent);
+	}
+
+	return (true);
+}
+
+void ThreadPool_Wait(ThreadPool pool, TaskCounter counter)
+{
+	if (pool == NULL || counter == NULL)
+	{
+		return;
+	}
+
+	// Help instead of blocking, the caller is just another worker until the batch is done
+	while (Atomic_Load32(&counter->pending) > 0)
+	{
+		STask task;
+		if (ThreadPool_FindTask(pool, s_currentWorker, &task))
+		{
+			ThreadPool_RunTask(pool, &task);
+		}
+		else
+		{
+			Thread_Yield();
+		}
+	}
+
+	// The last task may still be releasing dependents under the counter lock
+	while (Atomic_Load32(&counter->lock) != 0)
+	{
+		Atomic_CpuPause();
+	}
+}
+
+uint32_t ThreadPool_GetWorkersCount(ThreadPool pool)
+{
+	if (pool == NULL)
+	{
+		return (0);
+	}
+
+	return (pool->workersCount);
+}
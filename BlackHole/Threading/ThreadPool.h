@@ -0,0 +1,39 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void(*fnTask)(void* data);
+
+// Counts the unfinished tasks of a batch, ThreadPool_Wait returns once it reaches zero.
+// Zero initialize before use.
+typedef struct STaskCounter
+{
+	volatile int32_t pending;
+	volatile int32_t lock; // Guards 'dependents' and the final decrement
+	struct STaskDependent* dependents; // Tasks submitted with ThreadPool_SubmitAfter on this counter
+} STaskCounter;
+
+typedef struct STaskCounter* TaskCounter;
+
+typedef struct SThreadPool* ThreadPool;
+
+// workersCount = 0 uses one worker per hardware thread minus the caller
+bool ThreadPool_Initialize(ThreadPool* ppPool, uint32_t workersCount);
+void ThreadPool_Destroy(ThreadPool* ppPool);
+
+// Workers push to their own lock-free deque, other threads go through a shared injection queue.
+// If the target queue is full the task runs inline on the caller.
+bool ThreadPool_Submit(ThreadPool pool, fnTask function, void* data, TaskCounter counter);
+
+// Same as Submit, but the task is only queued once 'dependency' drops to zero.
+// Chain stages by passing the counter of one stage as the dependency of the next.
+bool ThreadPool_SubmitAfter(ThreadPool pool, TaskCounter dependency, fnTask function, void* data, TaskCounter counter);
+
+// Runs queued tasks on the calling thread until 'counter' drops to zero
+void ThreadPool_Wait(ThreadPool pool, TaskCounter counter);
+
+uint32_t ThreadPool_GetWorkersCount(ThreadPool pool);
+
+#endif // __THREAD_POOL_H__